@@ -53,7 +53,9 @@ public:
 		SC_THREAD(monitor_rchannel_stable);
 	}
 
-private:
+	//
+	// Channel samples, also used by checker_axi_engine
+	//
 #define SAMPLE_SIGNAL(d, s) s = d.s
 	class sample_awchannel {
 	public:
@@ -255,6 +257,7 @@ private:
 		const char *get_name(void) { return "rchannel"; }
 	};
 
+private:
 	GEN_STABLE_MON(aw)
 	GEN_STABLE_MON(ar)
 	GEN_STABLE_MON(w)
@@ -266,22 +269,74 @@ AXI_CHECKER(check_rd_tx)
 {
 public:
 	AXI_CHECKER_CTOR(check_rd_tx)
+	{}
+
+	//
+	// Called by checker_axi_engine at the clock edges (outside reset)
+	// where a handshake was detected on the ar / r channel. Read
+	// transactions are always tracked.
+	//
+	void ar_handshake()
 	{
-		if(enabled()) {
-			SC_THREAD(rd_check);
+		if (m_rtList.size() < m_cfg.max_depth()) {
+			m_rtList.push_back(SampleARSignals());
 		}
 	}
 
-private:
-	bool enabled()
+	void r_handshake()
 	{
-		if(m_cfg.en_rd_order_check() ||
-			m_cfg.en_resp_check()) {
-			return true;
+		Transaction *rt = GetFirst(to_uint(rid));
+
+		if (rt) {
+			rt->DecNumBeats();
+
+			if (m_cfg.en_resp_check()) {
+				if (!check_axi_resp(rt)) {
+					std::ostringstream msg;
+
+					msg << "Error response"
+					<< " identifed, rresp: "
+					<< "0x"<< std::hex
+					<< to_uint(rresp);
+
+					rt->ReportError(msg);
+				}
+			}
+
+			if (m_cfg.en_rd_order_check()) {
+				if (rlast.read() != rt->Done()) {
+					std::ostringstream msg;
+
+					msg << "Wrongly ordered transaction"
+						<< " identified (has an "
+						<< "unexpected burst length)";
+
+					rt->ReportError(msg);
+				}
+			}
+
+			// Transaction done
+			if (rlast.read()) {
+				m_rtList.remove(rt);
+				delete rt;
+			}
+
+		} else {
+			std::ostringstream msg;
+
+			msg << "Unexpected transaction id "
+				<< "on read response channel"
+				<< " (id: "
+				<< to_uint(rid) << ")";
+
+			SC_REPORT_ERROR(RD_TX_ERROR,
+					msg.str().c_str());
 		}
-		return true;
 	}
 
+	void restart() { ClearList(m_rtList); }
+
+private:
 	class Transaction
 	{
 	public:
@@ -410,94 +465,121 @@ private:
 		return resp == AXI_OKAY;
 	}
 
-	void rd_check(void)
-	{
-		while (true) {
-			wait(clk.posedge_event() | resetn.negedge_event());
-
-			if (reset_asserted()) {
-				ClearList(m_rtList);
-				wait_for_reset_release();
-				continue;
-			}
+	std::list<Transaction*> m_rtList;
+};
 
-			if (arvalid.read() && arready.read()) {
-				if (m_rtList.size() < m_cfg.max_depth()) {
-					m_rtList.push_back(SampleARSignals());
-				}
-			}
+AXI_CHECKER(check_wr_tx)
+{
+public:
+	AXI_CHECKER_CTOR(check_wr_tx),
+		m_max_wdata_depth(m_cfg.max_depth())
+	{
+		if (m_pc.GetVersion()) {
+			m_max_wdata_depth *= AXI3_MAX_BURSTLENGTH;
+		} else {
+			m_max_wdata_depth *= AXI4_MAX_BURSTLENGTH;
+		}
+	}
 
-			if (rvalid.read() && rready.read()) {
-				Transaction *rt = GetFirst(to_uint(rid));
+	bool enabled()
+	{
+		return m_cfg.en_wstrb_check() || m_cfg.en_wr_bursts_check();
+	}
 
-				if (rt) {
-					rt->DecNumBeats();
+	//
+	// Called by checker_axi_engine at the clock edges (outside reset)
+	// where a handshake was detected on the aw / w / b channels, while
+	// the check is enabled. process_aw_w() is called after aw_handshake()
+	// and w_handshake() on the edges with aw or w handshakes.
+	//
+	void aw_handshake()
+	{
+		if (m_wtList.size() < m_cfg.max_depth()) {
+			m_wtList.push_back(SampleAWSignals());
+		} else {
+			SC_REPORT_ERROR(WR_TX_ERROR,
+					"Maximum outstanding "
+					"transactions reached");
+		}
+	}
 
-					if (m_cfg.en_resp_check()) {
-						if (!check_axi_resp(rt)) {
-							std::ostringstream msg;
+	void w_handshake()
+	{
+		if (m_wdataList.size() < m_max_wdata_depth) {
+			m_wdataList.push_back(
+				SampleWDataSignals());
+		} else {
+			std::ostringstream msg;
 
-							msg << "Error response"
-							<< " identifed, rresp: "
-							<< "0x"<< std::hex
-							<< to_uint(rresp);
+			msg << "Maximum outstanding (wdata) "
+				<< "transactions reached";
 
-							rt->ReportError(msg);
-						}
-					}
-
-					if (m_cfg.en_rd_order_check()) {
-						if (rlast.read() != rt->Done()) {
-							std::ostringstream msg;
+			SC_REPORT_ERROR(WR_TX_ERROR,
+					msg.str().c_str());
+		}
+	}
 
-							msg << "Wrongly ordered transaction"
-								<< " identified (has an "
-								<< "unexpected burst length)";
+	void process_aw_w()
+	{
+		if (m_pc.GetVersion() == V_AXI4) {
+			process_aw_w_axi4();
+		} else {
+			process_aw_w_axi3();
+		}
+	}
 
-							rt->ReportError(msg);
-						}
-					}
+	void b_handshake()
+	{
+		WData *wd = GetFirst(m_respList,
+					   to_uint(bid));
 
-					// Transaction done
-					if (rlast.read()) {
-						m_rtList.remove(rt);
-						delete rt;
-					}
+		if (wd) {
+			Transaction *wt = wd->GetTransaction();
 
-				} else {
+			if (m_cfg.en_resp_check()) {
+				if (!check_axi_resp(wt)) {
 					std::ostringstream msg;
 
-					msg << "Unexpected transaction id "
-						<< "on read response channel"
-						<< " (id: "
-						<< to_uint(rid) << ")";
+					msg << "Error response"
+					<< " identifed, bresp: "
+					<< "0x" << std::hex
+					<< to_uint(bresp);
 
-					SC_REPORT_ERROR(RD_TX_ERROR,
+					if (wt) {
+						wt->ReportError(
+							msg);
+					} else {
+						SC_REPORT_ERROR(
+							WR_TX_ERROR,
 							msg.str().c_str());
+					}
 				}
 			}
-		}
-	}
 
-	std::list<Transaction*> m_rtList;
-};
+			// Transaction done
+			m_respList.remove(wd);
+			delete wd;
+		} else {
+			std::ostringstream msg;
 
-AXI_CHECKER(check_wr_tx)
-{
-public:
-	AXI_CHECKER_CTOR(check_wr_tx)
-	{
-		if (enabled()) {
-			SC_THREAD(wr_check);
+			msg << "Unexpected transaction id "
+				<< "on write response channel"
+				<< " (id: "
+				<< to_uint(rid) << ")";
+
+			SC_REPORT_ERROR(WR_TX_ERROR,
+					msg.str().c_str());
 		}
 	}
 
-private:
-	bool enabled()
+	void restart()
 	{
-		return m_cfg.en_wstrb_check() || m_cfg.en_wr_bursts_check();
+		ClearList(m_wtList);
+		ClearList(m_wdataList);
+		ClearList(m_respList);
 	}
 
+private:
 	class Transaction
 	{
 	public:
@@ -1020,119 +1102,19 @@ private:
 		}
 	}
 
-	void wr_check()
-	{
-		uint32_t max_wdata_depth = m_cfg.max_depth();
-
-		if (m_pc.GetVersion()) {
-			max_wdata_depth *= AXI3_MAX_BURSTLENGTH;
-		} else {
-			max_wdata_depth *= AXI4_MAX_BURSTLENGTH;
-		}
-
-		while (true) {
-			wait(clk.posedge_event() | resetn.negedge_event());
-
-			if (reset_asserted()) {
-				ClearList(m_wtList);
-				ClearList(m_wdataList);
-				ClearList(m_respList);
-				wait_for_reset_release();
-				continue;
-			}
-
-			if (awvalid.read() && awready.read()) {
-				if (m_wtList.size() < m_cfg.max_depth()) {
-					m_wtList.push_back(SampleAWSignals());
-				} else {
-					SC_REPORT_ERROR(WR_TX_ERROR,
-							"Maximum outstanding "
-							"transactions reached");
-				}
-			}
-
-			if (wvalid.read() && wready.read()) {
-				if (m_wdataList.size() < max_wdata_depth) {
-					m_wdataList.push_back(
-						SampleWDataSignals());
-				} else {
-					std::ostringstream msg;
-
-					msg << "Maximum outstanding (wdata) "
-						<< "transactions reached";
-
-					SC_REPORT_ERROR(WR_TX_ERROR,
-							msg.str().c_str());
-				}
-			}
-
-			if (m_pc.GetVersion() == V_AXI4) {
-				process_aw_w_axi4();
-			} else {
-				process_aw_w_axi3();
-			}
-
-			if (bvalid.read() && bready.read()) {
-				WData *wd = GetFirst(m_respList,
-							   to_uint(bid));
-
-				if (wd) {
-					Transaction *wt = wd->GetTransaction();
-
-					if (m_cfg.en_resp_check()) {
-						if (!check_axi_resp(wt)) {
-							std::ostringstream msg;
-
-							msg << "Error response"
-							<< " identifed, bresp: "
-							<< "0x" << std::hex
-							<< to_uint(bresp);
-
-							if (wt) {
-								wt->ReportError(
-									msg);
-							} else {
-								SC_REPORT_ERROR(
-									WR_TX_ERROR,
-									msg.str().c_str());
-							}
-						}
-					}
-
-					// Transaction done
-					m_respList.remove(wd);
-					delete wd;
-				} else {
-					std::ostringstream msg;
-
-					msg << "Unexpected transaction id "
-						<< "on write response channel"
-						<< " (id: "
-						<< to_uint(rid) << ")";
-
-					SC_REPORT_ERROR(WR_TX_ERROR,
-							msg.str().c_str());
-				}
-			}
-		}
-	}
-
 	std::list<Transaction*> m_wtList;
 	std::list<WData*> m_wdataList;
 	std::list<WData*> m_respList;
+
+	uint32_t m_max_wdata_depth;
 };
 
 AXI_CHECKER(check_addr_alignment)
 {
 public:
 	AXI_CHECKER_CTOR(check_addr_alignment)
-	{
-		if (enabled()) {
-			SC_THREAD(addr_alignment_check);
-		}
-	}
+	{}
 
-private:
 	bool enabled()
 	{
 		if (m_cfg.en_addr_align_check() ||
@@ -1143,6 +1125,14 @@ private:
 		return false;
 	}
 
+	//
+	// Called by checker_axi_engine at the clock edges (outside reset)
+	// where a handshake was detected on the ar / aw channel.
+	//
+	void ar_handshake() { check_rd_tx(); }
+	void aw_handshake() { check_wr_tx(); }
+
+private:
 	bool check_address_alignment(uint64_t addr, uint8_t axburst,
 					uint8_t axsize, uint8_t axlen)
 	{
@@ -1274,39 +1264,36 @@ private:
 		}
 	}
 
-	void addr_alignment_check()
-	{
-		while (true) {
-			wait(clk.posedge_event() | resetn.negedge_event());
-
-			if (reset_asserted()) {
-				wait_for_reset_release();
-				continue;
-			}
-
-			if (arvalid.read() && arready.read()) {
-				check_rd_tx();
-			}
-
-			if (awvalid.read() && awready.read()) {
-				check_wr_tx();
-			}
-		}
-	}
-
 	enum { MAX_AxSIZE = 8 };
 };
 
 AXI_CHECKER(check_axi_handshakes)
 {
 public:
-	AXI_CHECKER_CTOR(check_axi_handshakes)
+	AXI_CHECKER_CTOR(check_axi_handshakes),
+		m_axlen(m_pc),
+		m_tracker(m_pc, m_axlen, m_cfg.get_max_clks())
+	{}
+
+	//
+	// Called by checker_axi_engine at the clock edges (outside reset)
+	// where a channel is active or pending() returns true. The expected
+	// handshakes are followed also while the check is disabled (then
+	// without reporting errors), so the check (and the write transaction
+	// checks, see writes_idle()) can be enabled at runtime.
+	//
+	void step(bool report)
 	{
-		if (m_cfg.en_handshakes_check()) {
-			SC_THREAD(axi_handshakes_check);
-		}
+		m_tracker.report(report);
+		m_tracker.step();
 	}
 
+	void restart() { m_tracker.restart(); }
+
+	bool pending() { return m_tracker.pending(); }
+
+	bool writes_idle() { return m_tracker.writes_idle(); }
+
 private:
 	template<typename PC>
 	class IAxLen
@@ -1332,13 +1319,10 @@ private:
 		PC& m_pc;
 	};
 
-	void axi_handshakes_check()
-	{
-		axi_handshakes_checker checker(this);
-		IAxLen<typename T::PCType> axlen(m_pc);
+	typedef IAxLen<typename T::PCType> IAxLenType;
 
-		checker.run(m_pc, m_cfg, axlen);
-	}
+	IAxLenType m_axlen;
+	axi_handshakes_checker::tracker<typename T::PCType, IAxLenType> m_tracker;
 };
 
 AXI_CHECKER(check_axi_reset)
@@ -1360,4 +1344,192 @@ private:
 	}
 };
 
+//
+// Runs the AXI checks from a single method process triggered at the rising
+// clock edge, instead of one thread per check. The valid / ready signals of
+// the five channels are sampled once per edge and a channel is only looked
+// at when it is active (valid asserted or valid / ready changed since the
+// previous edge) or when a check is waiting on it. The configuration is
+// read at every edge so checks can be enabled and disabled at runtime.
+//
+AXI_CHECKER(checker_axi_engine)
+{
+public:
+	AXI_CHECKER_CTOR(checker_axi_engine),
+		m_check_rd_tx("check-rd-tx", pc),
+		m_check_wr_tx("check-wr-tx", pc),
+		m_check_addr_alignment("check-addr-alignment", pc),
+		m_check_axi_handshakes("check-axi-handshakes", pc),
+		m_reset_checker(this),
+		m_stable_on(false),
+		m_wr_tx_on(false),
+		m_in_reset(false),
+		m_prev(0)
+	{
+		SC_METHOD(clk_edge);
+		sensitive << clk.pos() << resetn.neg();
+		dont_initialize();
+	}
+
+private:
+	enum { AR, R, AW, W, B };
+
+	typedef checker_axi_stable<T, CFG> stable_type;
+
+	//
+	// valid in bit 2 * ch and ready in bit 2 * ch + 1
+	//
+	enum { VALID_MASK = 0x155 };
+
+	unsigned int sample_valid_ready()
+	{
+		return arvalid.read() << 0 | arready.read() << 1 |
+			rvalid.read() << 2 | rready.read() << 3 |
+			awvalid.read() << 4 | awready.read() << 5 |
+			wvalid.read() << 6 | wready.read() << 7 |
+			bvalid.read() << 8 | bready.read() << 9;
+	}
+
+	bool valid(unsigned int s, int ch) { return (s >> (2 * ch)) & 1; }
+	bool ready(unsigned int s, int ch) { return (s >> (2 * ch + 1)) & 1; }
+
+	bool handshake(unsigned int s, int ch)
+	{
+		return ((s >> (2 * ch)) & 3) == 3;
+	}
+
+	bool active(unsigned int s, int ch)
+	{
+		return valid(s, ch) || (((s ^ m_prev) >> (2 * ch)) & 3);
+	}
+
+	template<typename TRACKER>
+	void check_stable(TRACKER& t, unsigned int s, int ch)
+	{
+		if (t.armed() || active(s, ch)) {
+			t.step(m_pc, valid(s, ch), ready(s, ch));
+		}
+	}
+
+	void restart_stable()
+	{
+		m_ar_stable.restart();
+		m_r_stable.restart();
+		m_aw_stable.restart();
+		m_w_stable.restart();
+		m_b_stable.restart();
+	}
+
+	void restart()
+	{
+		m_check_rd_tx.restart();
+		m_check_wr_tx.restart();
+		m_check_axi_handshakes.restart();
+		restart_stable();
+		m_prev = 0;
+	}
+
+	void clk_edge()
+	{
+		bool en_stable = m_cfg.en_stable_data_resp_check();
+		unsigned int s;
+
+		if (reset_asserted()) {
+			if (!m_in_reset) {
+				restart();
+				m_in_reset = true;
+			}
+			return;
+		}
+
+		if (m_in_reset) {
+			// The edge releasing reset isn't checked
+			m_in_reset = false;
+			if (m_cfg.en_reset_check()) {
+				m_reset_checker.check_valids();
+			}
+			return;
+		}
+
+		s = sample_valid_ready();
+
+		if (en_stable) {
+			check_stable(m_ar_stable, s, AR);
+			check_stable(m_r_stable, s, R);
+			check_stable(m_aw_stable, s, AW);
+			check_stable(m_w_stable, s, W);
+			check_stable(m_b_stable, s, B);
+		} else if (m_stable_on) {
+			restart_stable();
+		}
+		m_stable_on = en_stable;
+
+		//
+		// Write transactions are followed from an edge without
+		// outstanding writes when the check gets enabled.
+		//
+		if (m_check_wr_tx.enabled() != m_wr_tx_on) {
+			if (m_wr_tx_on) {
+				m_check_wr_tx.restart();
+				m_wr_tx_on = false;
+			} else if (m_check_axi_handshakes.writes_idle()) {
+				m_wr_tx_on = true;
+			}
+		}
+
+		if ((s & VALID_MASK) || s != m_prev ||
+			m_check_axi_handshakes.pending()) {
+			m_check_axi_handshakes.step(
+				m_cfg.en_handshakes_check());
+		}
+
+		if (handshake(s, AR)) {
+			if (m_check_addr_alignment.enabled()) {
+				m_check_addr_alignment.ar_handshake();
+			}
+			m_check_rd_tx.ar_handshake();
+		}
+		if (handshake(s, R)) {
+			m_check_rd_tx.r_handshake();
+		}
+
+		if (handshake(s, AW) && m_check_addr_alignment.enabled()) {
+			m_check_addr_alignment.aw_handshake();
+		}
+		if (m_wr_tx_on) {
+			if (handshake(s, AW)) {
+				m_check_wr_tx.aw_handshake();
+			}
+			if (handshake(s, W)) {
+				m_check_wr_tx.w_handshake();
+			}
+			if (handshake(s, AW) || handshake(s, W)) {
+				m_check_wr_tx.process_aw_w();
+			}
+			if (handshake(s, B)) {
+				m_check_wr_tx.b_handshake();
+			}
+		}
+
+		m_prev = s;
+	}
+
+	check_rd_tx<T, CFG> m_check_rd_tx;
+	check_wr_tx<T, CFG> m_check_wr_tx;
+	check_addr_alignment<T, CFG> m_check_addr_alignment;
+	check_axi_handshakes<T, CFG> m_check_axi_handshakes;
+	axi_reset_checker m_reset_checker;
+
+	xchannel_stable_tracker<typename stable_type::sample_archannel> m_ar_stable;
+	xchannel_stable_tracker<typename stable_type::sample_rchannel> m_r_stable;
+	xchannel_stable_tracker<typename stable_type::sample_awchannel> m_aw_stable;
+	xchannel_stable_tracker<typename stable_type::sample_wchannel> m_w_stable;
+	xchannel_stable_tracker<typename stable_type::sample_bchannel> m_b_stable;
+
+	bool m_stable_on;
+	bool m_wr_tx_on;
+	bool m_in_reset;
+	unsigned int m_prev;
+};
+
 #endif
@@ -362,49 +362,153 @@ public:
 	template<typename PC, typename PCCFG, typename IAXLEN>
 	void run(PC& p, PCCFG& cfg, IAXLEN& axlen)
 	{
-		uint64_t m_max_clks = cfg.get_max_clks();
-		HandshakeMonitor ar_channel("ar", p.arvalid, p.arready, m_max_clks);
-		HandshakeMonitor rr_channel("r", p.rvalid, p.rready, m_max_clks);
-		HandshakeMonitor aw_channel("aw", p.awvalid, p.awready, m_max_clks);
-		HandshakeMonitor w_channel("w", p.wvalid, p.wready, m_max_clks);
-		HandshakeMonitor b_channel("b", p.bvalid, p.bready, m_max_clks);
+		tracker<PC, IAXLEN> t(p, axlen, cfg.get_max_clks());
 		sc_in<bool >& clk = p.clk;
 		sc_in<bool >& resetn = p.resetn;
-		uint32_t m_rt = 0;
-		int m_wd = 0;
-		uint32_t m_b = 0;
-		uint32_t m_aw = 0;
-		uint32_t m_wlast = 0;
-		bool is_axi3 = axlen.is_axi3();
-		bool use_ids = !axlen.is_axi4lite(); // AXI4Lite doesn't use ids
 
 		while (true) {
-			bool inc_rvalid = m_rt > 0;
-			bool inc_awvalid = m_wd < 0;
-			bool inc_wvalid = m_wd > 0;
-			bool inc_bvalid = m_b > 0;
-
 			sc_core::wait(clk.posedge_event() | resetn.negedge_event());
 			if (reset_asserted()) {
-				ar_channel.restart();
-				rr_channel.restart();
-				aw_channel.restart();
-				w_channel.restart();
-				b_channel.restart();
-				m_rt = 0;
-				m_wd = 0;
-				m_b = 0;
-
-				m_aw = 0;
-				m_wlast = 0;
-				m_awids.clear();
-				m_wids.clear();
-				m_bids.clear();
-
+				t.restart();
 				wait_for_reset_release();
 				continue;
 			}
 
+			t.step();
+		}
+	}
+
+private:
+	class HandshakeMonitor
+	{
+	public:
+		HandshakeMonitor(std::string name,
+				sc_in<bool >& valid,
+				sc_in<bool >& ready,
+				uint64_t max_clks) :
+			m_name(name),
+			m_valid(valid),
+			m_ready(ready),
+			m_valid_wait(0),
+			m_ready_wait(0),
+			m_max_clks(max_clks),
+			m_report(true)
+		{}
+
+		bool run(bool inc_valid = false)
+		{
+			if (!m_valid.read()) {
+
+				if (inc_valid) {
+					// Waiting for valid and not for ready
+					inc_valid_w();
+				}
+
+				if (m_ready_wait && m_report) {
+					std::ostringstream msg;
+
+					msg << m_name << "valid toggled without"
+						<< " waiting for " << m_name
+						<< "ready!";
+
+					SC_REPORT_ERROR(AXI_HANDSHAKE_ERROR,
+							msg.str().c_str());
+				}
+
+			} else if (!m_ready.read()) {
+				// Valid == true, now waiting for ready only
+				inc_ready_w();
+			} else {
+				// Valid == true, ready == true
+				restart();
+
+				return true;
+			}
+
+			return false;
+		}
+
+		void inc_valid_w()
+		{
+			m_valid_wait++;
+			if (m_report && m_valid_wait == m_max_clks) {
+				std::ostringstream msg;
+
+				msg << m_name << "valid hangup detected!";
+
+				SC_REPORT_ERROR(AXI_HANDSHAKE_ERROR,
+						msg.str().c_str());
+			}
+		}
+
+		void inc_ready_w()
+		{
+			m_ready_wait++;
+			if (m_report && m_ready_wait == m_max_clks) {
+				std::ostringstream msg;
+
+				msg << m_name << "ready hangup detected!";
+
+				SC_REPORT_ERROR(AXI_HANDSHAKE_ERROR,
+						msg.str().c_str());
+			}
+		}
+
+		void restart()
+		{
+			m_valid_wait = 0;
+			m_ready_wait = 0;
+		}
+
+		// Keep counting but don't report errors when disabled
+		void report(bool en) { m_report = en; }
+
+		bool waiting_ready() { return m_ready_wait > 0; }
+
+	private:
+		std::string m_name;
+
+		sc_in<bool >& m_valid;
+		sc_in<bool >& m_ready;
+
+		uint32_t m_valid_wait;
+		uint32_t m_ready_wait;
+		uint64_t m_max_clks;
+		bool m_report;
+	};
+
+public:
+	//
+	// Follows the handshakes expected on the channels, step() is called
+	// once per clock edge (outside reset).
+	//
+	template<typename PC, typename IAXLEN>
+	class tracker
+	{
+	public:
+		tracker(PC& p, IAXLEN& axlen, uint64_t max_clks) :
+			ar_channel("ar", p.arvalid, p.arready, max_clks),
+			rr_channel("r", p.rvalid, p.rready, max_clks),
+			aw_channel("aw", p.awvalid, p.awready, max_clks),
+			w_channel("w", p.wvalid, p.wready, max_clks),
+			b_channel("b", p.bvalid, p.bready, max_clks),
+			axlen(axlen),
+			m_rt(0),
+			m_wd(0),
+			m_b(0),
+			m_aw(0),
+			m_wlast(0),
+			is_axi3(axlen.is_axi3()),
+			use_ids(!axlen.is_axi4lite()) // AXI4Lite doesn't use ids
+		{}
+
+		void step()
+		{
+			bool inc_rvalid = m_rt > 0;
+			bool inc_awvalid = m_wd < 0;
+			bool inc_wvalid = m_wd > 0;
+			bool inc_bvalid = m_b > 0;
+
 			//
 			// ar and rr channels
 			//
@@ -526,127 +630,98 @@ public:
 				}
 			}
 		}
-	}
 
-private:
-	class HandshakeMonitor
-	{
-	public:
-		HandshakeMonitor(std::string name,
-				sc_in<bool >& valid,
-				sc_in<bool >& ready,
-				uint64_t max_clks) :
-			m_name(name),
-			m_valid(valid),
-			m_ready(ready),
-			m_valid_wait(0),
-			m_ready_wait(0),
-			m_max_clks(max_clks)
-		{}
-
-		bool run(bool inc_valid = false)
+		void restart()
 		{
-			if (!m_valid.read()) {
-
-				if (inc_valid) {
-					// Waiting for valid and not for ready
-					inc_valid_w();
-				}
-
-				if (m_ready_wait) {
-					std::ostringstream msg;
-
-					msg << m_name << "valid toggled without"
-						<< " waiting for " << m_name
-						<< "ready!";
-
-					SC_REPORT_ERROR(AXI_HANDSHAKE_ERROR,
-							msg.str().c_str());
-				}
-
-			} else if (!m_ready.read()) {
-				// Valid == true, now waiting for ready only
-				inc_ready_w();
-			} else {
-				// Valid == true, ready == true
-				restart();
-
-				return true;
-			}
-
-			return false;
+			ar_channel.restart();
+			rr_channel.restart();
+			aw_channel.restart();
+			w_channel.restart();
+			b_channel.restart();
+			m_rt = 0;
+			m_wd = 0;
+			m_b = 0;
+
+			m_aw = 0;
+			m_wlast = 0;
+			m_awids.clear();
+			m_wids.clear();
+			m_bids.clear();
 		}
 
-		void inc_valid_w()
+		void report(bool en)
 		{
-			m_valid_wait++;
-			if (m_valid_wait == m_max_clks) {
-				std::ostringstream msg;
-
-				msg << m_name << "valid hangup detected!";
-
-				SC_REPORT_ERROR(AXI_HANDSHAKE_ERROR,
-						msg.str().c_str());
-			}
+			ar_channel.report(en);
+			rr_channel.report(en);
+			aw_channel.report(en);
+			w_channel.report(en);
+			b_channel.report(en);
 		}
 
-		void inc_ready_w()
+		//
+		// Handshakes are expected on some channel, step() needs to
+		// run also while the valid / ready signals are idle.
+		//
+		bool pending()
 		{
-			m_ready_wait++;
-			if (m_ready_wait == m_max_clks) {
-				std::ostringstream msg;
-
-				msg << m_name << "ready hangup detected!";
-
-				SC_REPORT_ERROR(AXI_HANDSHAKE_ERROR,
-						msg.str().c_str());
-			}
+			return m_rt || m_wd || m_b ||
+				ar_channel.waiting_ready() ||
+				rr_channel.waiting_ready() ||
+				aw_channel.waiting_ready() ||
+				w_channel.waiting_ready() ||
+				b_channel.waiting_ready();
 		}
 
-		void restart()
+		// No write transaction is in progress
+		bool writes_idle()
 		{
-			m_valid_wait = 0;
-			m_ready_wait = 0;
+			return m_wd == 0 && m_b == 0 && m_aw == 0 &&
+				m_wlast == 0;
 		}
 
 	private:
-		std::string m_name;
-
-		sc_in<bool >& m_valid;
-		sc_in<bool >& m_ready;
-
-		uint32_t m_valid_wait;
-		uint32_t m_ready_wait;
-		uint64_t m_max_clks;
-	};
-
-	bool in_list(std::list<uint32_t>& l, uint32_t id)
-	{
-		for (typename std::list<uint32_t>::iterator it = l.begin();
-			it != l.end(); it++) {
+		bool in_list(std::list<uint32_t>& l, uint32_t id)
+		{
+			for (typename std::list<uint32_t>::iterator it = l.begin();
+				it != l.end(); it++) {
 
-			if ((*it) == id) {
-				return true;
+				if ((*it) == id) {
+					return true;
+				}
 			}
+			return false;
 		}
-		return false;
-	}
 
-	void remove(std::list<uint32_t>& l, uint32_t id)
-	{
-		for (typename std::list<uint32_t>::iterator it = l.begin();
-			it != l.end(); it++) {
+		void remove(std::list<uint32_t>& l, uint32_t id)
+		{
+			for (typename std::list<uint32_t>::iterator it = l.begin();
+				it != l.end(); it++) {
 
-			if ((*it) == id) {
-				l.erase(it);
-				return;
+				if ((*it) == id) {
+					l.erase(it);
+					return;
+				}
 			}
 		}
-	}
 
-	std::list<uint32_t> m_awids;
-	std::list<uint32_t> m_wids;
-	std::list<uint32_t> m_bids;
+		HandshakeMonitor ar_channel;
+		HandshakeMonitor rr_channel;
+		HandshakeMonitor aw_channel;
+		HandshakeMonitor w_channel;
+		HandshakeMonitor b_channel;
+		IAXLEN& axlen;
+		uint32_t m_rt;
+		int m_wd;
+		uint32_t m_b;
+		uint32_t m_aw;
+		uint32_t m_wlast;
+		bool is_axi3;
+		bool use_ids;
+
+		std::list<uint32_t> m_awids;
+		std::list<uint32_t> m_wids;
+		std::list<uint32_t> m_bids;
+	};
 };
 
 template<typename SAMPLE_TYPE>
@@ -698,6 +773,50 @@ public:
 	}
 };
 
+//
+// Clock edge driven variant of monitor_xchannel_stable. The channel signals
+// are sampled at the first edge where valid is asserted without ready and
+// are then compared at every following edge until ready is seen.
+//
+template<typename SAMPLE_TYPE>
+class xchannel_stable_tracker
+{
+public:
+	xchannel_stable_tracker() :
+		m_armed(false)
+	{}
+
+	template<typename PC>
+	void step(PC& pc, bool valid, bool ready)
+	{
+		if (m_armed) {
+			SAMPLE_TYPE tmp_ch;
+
+			tmp_ch.sample_from(pc);
+			if (!m_saved_ch.cmp_eq_stable_valid_cycle_signals(tmp_ch)) {
+				char msg[256];
+
+				snprintf(msg, sizeof(msg), "%s valid/ready cycle unstable signals violation",
+					tmp_ch.get_name());
+				SC_REPORT_ERROR(CHECKER_AXI_ERROR, msg);
+			}
+			m_armed = !ready;
+		} else if (valid && !ready) {
+			m_saved_ch.sample_from(pc);
+			m_armed = true;
+		}
+	}
+
+	// Waiting for ready, step() must run at every edge
+	bool armed() { return m_armed; }
+
+	void restart() { m_armed = false; }
+
+private:
+	SAMPLE_TYPE m_saved_ch;
+	bool m_armed;
+};
+
 #define GEN_STABLE_MON(ch)									\
 	void monitor_ ## ch ## channel_stable(void) {						\
 		monitor_xchannel_stable<sample_ ## ch ##channel> mon(this);			\
@@ -727,15 +846,21 @@ public:
 
 			wait_for_reset_release();
 
-			check_valid(arvalid, "ar");
-			check_valid(rvalid, "r");
-
-			check_valid(awvalid, "aw");
-			check_valid(wvalid, "w");
-			check_valid(bvalid, "b");
+			check_valids();
 		}
 	}
 
+	// Called at the clock edge releasing reset
+	void check_valids()
+	{
+		check_valid(arvalid, "ar");
+		check_valid(rvalid, "r");
+
+		check_valid(awvalid, "aw");
+		check_valid(wvalid, "w");
+		check_valid(bvalid, "b");
+	}
+
 private:
 	void check_valid(sc_in<bool>& valid, std::string prefix)
 	{
@@ -183,17 +183,22 @@ public:
 
 		dummy("axi-dummy"),
 		m_cfg(*reinterpret_cast<__AXIPCConfig*>(&cfg)),
-		m_checker_axi_stable("checker-axi-stable", this),
-		m_check_rd_tx("check-rd-tx", this),
-		m_check_wr_tx("check-wr-tx", this),
-		m_check_addr_alignment("check-addr-alignment", this),
-		m_check_axi_handshakes("check-axi-handshakes", this),
-		m_check_axi_reset("check-axi-reset", this)
+		m_checker_axi_engine("checker-axi-engine", this)
 	{}
 
 	AXIVersion GetVersion() { return m_cfg.get_axi_version(); }
 
 	__AXIPCConfig& Cfg() { return m_cfg; }
+
+	//
+	// The checks are enabled / disabled at the next clock edge when
+	// changed through the returned config. Write transaction checks that
+	// get enabled start at an edge without outstanding writes.
+	//
+	AXIPCConfig& Config()
+	{
+		return *reinterpret_cast<AXIPCConfig*>(&m_cfg);
+	}
 private:
 	class axi_dummy : public sc_core::sc_module {
 	public:
@@ -271,12 +276,7 @@ private:
 	__AXIPCConfig m_cfg;
 
 	// Checkers
-	checker_axi_stable<PCType> m_checker_axi_stable;
-	check_rd_tx<PCType> m_check_rd_tx;
-	check_wr_tx<PCType> m_check_wr_tx;
-	check_addr_alignment<PCType> m_check_addr_alignment;
-	check_axi_handshakes<PCType> m_check_axi_handshakes;
-	check_axi_reset<PCType> m_check_axi_reset;
+	checker_axi_engine<PCType> m_checker_axi_engine;
 };
 
 #endif /* PC_AXI_H__ */
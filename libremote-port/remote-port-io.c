@@ -0,0 +1,407 @@
+/*
+ * Buffered remote-port transport.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <endian.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+
+#include "remote-port-proto.h"
+#include "remote-port-io.h"
+#include "remote-port-shm.h"
+#include "remote-port-sk.h"
+
+#undef MIN
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+void rp_io_init(struct rp_io *io, int fd, size_t rx_size)
+{
+	/* The ring indexes are masked, so we need a power of 2.  */
+	assert(rx_size && (rx_size & (rx_size - 1)) == 0);
+
+	memset(io, 0, sizeof *io);
+	io->fd = fd;
+	io->rx_size = rx_size;
+	io->rx_buf = malloc(rx_size);
+	if (io->rx_buf == NULL) {
+		fprintf(stderr, "out of mem\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+void rp_io_free(struct rp_io *io)
+{
+	free(io->rx_buf);
+	io->rx_buf = NULL;
+	if (io->shm) {
+		rp_shm_close(io->shm);
+		io->shm = NULL;
+	}
+	if (io->reader.enabled) {
+		close(io->reader.efd);
+		io->reader.efd = -1;
+		io->reader.enabled = false;
+	}
+}
+
+int rp_io_open(struct rp_io *io, const char *descr, size_t rx_size)
+{
+	struct rp_shm *shm;
+	int fd;
+
+	if (descr == NULL)
+		return -1;
+
+	if (memcmp(RP_SHM_PREFIX, descr, strlen(RP_SHM_PREFIX)) == 0) {
+		shm = rp_shm_open(descr + strlen(RP_SHM_PREFIX));
+		if (shm == NULL)
+			return -1;
+		rp_io_init(io, -1, rx_size);
+		io->shm = shm;
+		return 0;
+	}
+
+	fd = sk_open(descr);
+	if (fd == -1)
+		return -1;
+	rp_io_init(io, fd, rx_size);
+	return 0;
+}
+
+size_t rp_io_rx_avail(struct rp_io *io)
+{
+	if (io->shm && !io->reader.enabled)
+		return rp_shm_rx_avail(io->shm);
+
+	return __atomic_load_n(&io->rx_wr, __ATOMIC_ACQUIRE)
+		- __atomic_load_n(&io->rx_rd, __ATOMIC_RELAXED);
+}
+
+/*
+ * Describe the free space in the receive ring.
+ * Returns the number of iov entries used, 0 if the ring is full.
+ */
+static int rp_io_rx_space(struct rp_io *io, struct iovec *iov)
+{
+	size_t mask = io->rx_size - 1;
+	size_t wr = io->rx_wr & mask;
+	size_t rd = __atomic_load_n(&io->rx_rd, __ATOMIC_ACQUIRE);
+	size_t space;
+
+	/* In reader thread mode the consumer may already have read part
+	 * of a header the reader hasn't parsed yet, keep those bytes
+	 * until rp_io_reader_scan has looked at them.  */
+	if (io->reader.enabled && !io->reader.scan_len
+	    && (ssize_t) (rd - io->reader.scan) > 0)
+		rd = io->reader.scan;
+
+	space = io->rx_size - (io->rx_wr - rd);
+
+	if (space == 0)
+		return 0;
+
+	iov[0].iov_base = io->rx_buf + wr;
+	iov[0].iov_len = MIN(space, io->rx_size - wr);
+	if (iov[0].iov_len < space) {
+		/* Wrap around.  */
+		iov[1].iov_base = io->rx_buf;
+		iov[1].iov_len = space - iov[0].iov_len;
+		return 2;
+	}
+	return 1;
+}
+
+/* Copy len bytes out of the ring, starting at the free running off.  */
+static void rp_io_rx_copy(struct rp_io *io, size_t off,
+			  unsigned char *buf, size_t len)
+{
+	size_t start = off & (io->rx_size - 1);
+	size_t part = MIN(len, io->rx_size - start);
+
+	memcpy(buf, io->rx_buf + start, part);
+	memcpy(buf + part, io->rx_buf, len - part);
+}
+
+/* Consume up to count bytes that are already in the ring.  */
+static size_t rp_io_rx_consume(struct rp_io *io, unsigned char *buf,
+			       size_t count)
+{
+	size_t rd = io->rx_rd;
+	size_t len = MIN(count, __atomic_load_n(&io->rx_wr, __ATOMIC_ACQUIRE)
+				- rd);
+
+	rp_io_rx_copy(io, rd, buf, len);
+	__atomic_store_n(&io->rx_rd, rd + len, __ATOMIC_SEQ_CST);
+	return len;
+}
+
+/* Fill all the free space in the ring with whatever the peer has sent.  */
+static ssize_t rp_io_rx_fill(struct rp_io *io)
+{
+	struct iovec iov[2];
+	int iovcnt;
+	ssize_t r;
+
+	iovcnt = rp_io_rx_space(io, iov);
+	assert(iovcnt);
+
+	do {
+		io->stats.rx_syscalls++;
+		r = readv(io->fd, iov, iovcnt);
+	} while (r < 0 && errno == EINTR);
+
+	if (r > 0) {
+		__atomic_store_n(&io->rx_wr, io->rx_wr + r, __ATOMIC_RELEASE);
+		io->stats.rx_bytes += r;
+	}
+	return r;
+}
+
+ssize_t rp_io_read(struct rp_io *io, void *rbuf, size_t count)
+{
+	unsigned char *buf = rbuf;
+	size_t rlen = 0;
+
+	if (io->shm)
+		return rp_shm_read(io->shm, rbuf, count, &io->stats);
+
+	while (rlen < count) {
+		if (rp_io_rx_avail(io) == 0) {
+			ssize_t r = rp_io_rx_fill(io);
+
+			if (r < 0)
+				return -1;
+			if (r == 0)
+				break;
+		}
+		rlen += rp_io_rx_consume(io, buf + rlen, count - rlen);
+	}
+	return rlen;
+}
+
+int rp_io_reader_init(struct rp_io *io)
+{
+	io->reader.efd = eventfd(0, 0);
+	if (io->reader.efd < 0)
+		return -1;
+	io->reader.enabled = true;
+	return 0;
+}
+
+size_t rp_io_read_nb(struct rp_io *io, void *buf, size_t count)
+{
+	size_t len;
+
+	assert(io->reader.enabled);
+	len = rp_io_rx_consume(io, buf, count);
+
+	/* rx_rd was updated before looking at need_space and the reader
+	 * sets need_space before looking at rx_rd, so a reader waiting
+	 * for space won't be missed.  */
+	if (len && __atomic_load_n(&io->reader.need_space, __ATOMIC_SEQ_CST)) {
+		uint64_t v = 1;
+
+		if (write(io->reader.efd, &v, sizeof v) < 0)
+			perror(__func__);
+	}
+	return len;
+}
+
+/* Wait for the consumer to free up space in the receive ring.  */
+static void rp_io_reader_wait_space(struct rp_io *io)
+{
+	struct iovec iov[2];
+	uint64_t v;
+
+	__atomic_store_n(&io->reader.need_space, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!rp_io_rx_space(io, iov)) {
+		io->stats.rx_syscalls++;
+		while (read(io->reader.efd, &v, sizeof v) < 0
+		       && errno == EINTR)
+			;
+	}
+	__atomic_store_n(&io->reader.need_space, 0, __ATOMIC_RELAXED);
+}
+
+/* Move what the shm peer has sent into the receive ring.  */
+static ssize_t rp_io_reader_shm_fill(struct rp_io *io,
+				     struct iovec *iov, int iovcnt)
+{
+	size_t avail;
+	size_t len = 0;
+	int i;
+
+	if (rp_shm_wait_rx(io->shm, &io->stats))
+		return 0;
+
+	avail = rp_shm_rx_avail(io->shm);
+	for (i = 0; i < iovcnt && avail; i++) {
+		size_t n = MIN(avail, iov[i].iov_len);
+
+		rp_shm_read(io->shm, iov[i].iov_base, n, &io->stats);
+		avail -= n;
+		len += n;
+	}
+	return len;
+}
+
+/*
+ * Walk the packet headers that have arrived since the last call.
+ * Returns the number of packets that are now completely received.
+ */
+static unsigned int rp_io_reader_scan(struct rp_io *io)
+{
+	size_t hdr_size = sizeof(struct rp_pkt_hdr);
+	unsigned int nr = 0;
+
+	while (1) {
+		size_t avail = io->rx_wr - io->reader.scan;
+
+		/* The consumer may already have picked up the header,
+		 * rp_io_rx_space doesn't hand out its bytes to the
+		 * reader until it has been parsed here.  */
+		if (!io->reader.scan_len) {
+			uint32_t len;
+
+			if (avail < hdr_size)
+				break;
+
+			rp_io_rx_copy(io, io->reader.scan
+					  + offsetof(struct rp_pkt_hdr, len),
+				      (unsigned char *) &len, sizeof len);
+			io->reader.scan_len = hdr_size + be32toh(len);
+		}
+
+		if (avail < io->reader.scan_len)
+			break;
+
+		io->reader.scan += io->reader.scan_len;
+		io->reader.scan_len = 0;
+		nr++;
+	}
+	return nr;
+}
+
+int rp_io_reader_run(struct rp_io *io,
+		     void (*notify)(void *opaque), void *opaque)
+{
+	assert(io->reader.enabled);
+
+	while (1) {
+		struct iovec iov[2];
+		unsigned int nr;
+		int iovcnt;
+		ssize_t r;
+
+		iovcnt = rp_io_rx_space(io, iov);
+		if (iovcnt == 0) {
+			rp_io_reader_wait_space(io);
+			continue;
+		}
+
+		if (io->shm) {
+			r = rp_io_reader_shm_fill(io, iov, iovcnt);
+		} else {
+			do {
+				io->stats.rx_syscalls++;
+				r = readv(io->fd, iov, iovcnt);
+			} while (r < 0 && errno == EINTR);
+
+			if (r > 0)
+				io->stats.rx_bytes += r;
+		}
+
+		if (r <= 0)
+			return r;
+
+		__atomic_store_n(&io->rx_wr, io->rx_wr + r, __ATOMIC_RELEASE);
+
+		nr = rp_io_reader_scan(io);
+		if (nr || io->reader.scan_len > io->rx_size) {
+			io->stats.wakeups++;
+			io->stats.wakeup_pkts += nr;
+			notify(opaque);
+		}
+	}
+}
+
+ssize_t rp_io_writev(struct rp_io *io, const struct iovec *iov, int iovcnt)
+{
+	struct iovec v[RP_IO_MAX_IOV];
+	struct iovec *vp = v;
+	size_t wlen = 0;
+	ssize_t r;
+
+	assert(iovcnt <= RP_IO_MAX_IOV);
+	if (io->shm)
+		return rp_shm_writev(io->shm, iov, iovcnt, &io->stats);
+
+	/* We'll be advancing through the vector on partial writes.  */
+	memcpy(v, iov, sizeof v[0] * iovcnt);
+
+	while (iovcnt) {
+		io->stats.tx_syscalls++;
+		r = writev(io->fd, vp, iovcnt);
+		if (r < 0) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN)
+				break;
+			return -1;
+		}
+
+		wlen += r;
+		io->stats.tx_bytes += r;
+
+		/* Skip the fully written entries.  */
+		while (iovcnt && (size_t) r >= vp->iov_len) {
+			r -= vp->iov_len;
+			vp++;
+			iovcnt--;
+		}
+		if (iovcnt) {
+			vp->iov_base = (unsigned char *) vp->iov_base + r;
+			vp->iov_len -= r;
+		}
+	}
+	return wlen;
+}
+
+ssize_t rp_io_write(struct rp_io *io, const void *buf, size_t count)
+{
+	struct iovec iov = {
+		.iov_base = (void *) buf,
+		.iov_len = count,
+	};
+
+	return rp_io_writev(io, &iov, 1);
+}
@@ -0,0 +1,138 @@
+/*
+ * Buffered remote-port transport.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef REMOTE_PORT_IO
+#define REMOTE_PORT_IO
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*
+ * Reads go through a receive ring that is filled with as much data as
+ * the peer has made available, so that a burst of small packets costs a
+ * single syscall. Multi-part packets (header, data, byte-enables) are
+ * gathered into a single writev.
+ *
+ * Descriptors starting with shm: select the shared memory transport
+ * (see remote-port-shm.h), which bypasses the socket and the receive
+ * ring altogether.
+ *
+ * Optionally, a reader thread (see rp_io_reader_run) keeps the receive
+ * ring filled. The ring is then a lock-free single-producer
+ * single-consumer queue between the reader and the thread consuming
+ * packets with rp_io_read_nb.
+ */
+
+#define RP_IO_RX_SIZE_DEFAULT (64 * 1024)
+#define RP_IO_MAX_IOV 8
+
+struct rp_io_stats {
+	uint64_t rx_syscalls;
+	uint64_t rx_bytes;
+	uint64_t rx_pkts;
+	uint64_t tx_syscalls;
+	uint64_t tx_bytes;
+	uint64_t tx_pkts;
+
+	/* Reader thread mode. wakeup_pkts / wakeups is the average
+	 * number of packets handed over per consumer wakeup.  */
+	uint64_t wakeups;
+	uint64_t wakeup_pkts;
+};
+
+struct rp_io {
+	int fd;
+	/* Shared memory transport, NULL when using fd.  */
+	struct rp_shm *shm;
+
+	/* Receive ring. rx_size is a power of 2, rx_rd and rx_wr are
+	 * free running and masked on use.  */
+	unsigned char *rx_buf;
+	size_t rx_size;
+	size_t rx_rd;
+	size_t rx_wr;
+
+	struct {
+		bool enabled;
+		/* eventfd kicked by the consumer when the reader is
+		 * waiting for space in the receive ring.  */
+		int efd;
+		uint32_t need_space;
+		/* Free running ring offset of the next packet to be
+		 * completely received and its total length, 0 until
+		 * its header has arrived.  */
+		size_t scan;
+		size_t scan_len;
+	} reader;
+
+	struct rp_io_stats stats;
+};
+
+void rp_io_init(struct rp_io *io, int fd, size_t rx_size);
+void rp_io_free(struct rp_io *io);
+
+/*
+ * Connect to the peer described by descr (see sk_open) and set up io.
+ * Returns 0 on success and -1 on failure.
+ */
+int rp_io_open(struct rp_io *io, const char *descr, size_t rx_size);
+
+/* Number of received bytes that can be read without blocking.  */
+size_t rp_io_rx_avail(struct rp_io *io);
+
+/*
+ * Reader thread mode.
+ *
+ * rp_io_reader_init must be called before starting a thread that runs
+ * rp_io_reader_run. The reader fills the receive ring and calls notify
+ * once per batch of completely received packets. Packets too large
+ * for the ring are handed over piecewise.
+ *
+ * rp_io_reader_run only returns if the peer goes away (0) or on
+ * errors (-1). The reader thread can be stopped with pthread_cancel,
+ * it only waits at cancellation points.
+ *
+ * The consumer must then only use rp_io_read_nb, which copies out up
+ * to count bytes without blocking and returns how many it got.
+ */
+int rp_io_reader_init(struct rp_io *io);
+int rp_io_reader_run(struct rp_io *io,
+		     void (*notify)(void *opaque), void *opaque);
+size_t rp_io_read_nb(struct rp_io *io, void *buf, size_t count);
+
+/*
+ * Read exactly count bytes, blocking as needed.
+ * Returns count on success, less on EOF and -1 on errors.
+ */
+ssize_t rp_io_read(struct rp_io *io, void *buf, size_t count);
+
+/*
+ * Write all of iov. At most RP_IO_MAX_IOV entries.
+ * Returns the number of bytes written or -1 on errors.
+ */
+ssize_t rp_io_writev(struct rp_io *io, const struct iovec *iov, int iovcnt);
+ssize_t rp_io_write(struct rp_io *io, const void *buf, size_t count);
+
+#endif
@@ -87,6 +87,8 @@ static const char *rp_cmd_names[RP_CMD_max + 1] = {
     [RP_CMD_write] = "write",
     [RP_CMD_interrupt] = "interrupt",
     [RP_CMD_sync] = "sync",
+    [RP_CMD_map] = "map",
+    [RP_CMD_unmap] = "unmap",
 };
 
 const char *rp_cmd_to_string(enum rp_cmd cmd)
@@ -188,6 +190,19 @@ int rp_decode_payload(struct rp_pkt *pkt)
         pkt->sync.timestamp = be64toh(pkt->interrupt.timestamp);
         used += pkt->hdr.len;
         break;
+    case RP_CMD_map:
+    case RP_CMD_unmap:
+        assert(pkt->hdr.len >= sizeof pkt->map - sizeof pkt->hdr);
+        pkt->map.timestamp = be64toh(pkt->map.timestamp);
+        pkt->map.attributes = be64toh(pkt->map.attributes);
+        pkt->map.addr = be64toh(pkt->map.addr);
+        pkt->map.len = be64toh(pkt->map.len);
+        pkt->map.offset = be64toh(pkt->map.offset);
+        pkt->map.path_offset = be32toh(pkt->map.path_offset);
+        pkt->map.path_len = be32toh(pkt->map.path_len);
+        /* The path is part of the payload.  */
+        used += pkt->hdr.len;
+        break;
     default:
         break;
     }
@@ -397,6 +412,63 @@ size_t rp_encode_sync_resp(uint32_t id, uint32_t dev,
     return rp_encode_sync_common(id, dev, pkt, clk, RP_PKT_FLAGS_response);
 }
 
+static size_t rp_encode_map_common(uint32_t cmd, uint32_t id, uint32_t dev,
+                                   struct rp_pkt_map *pkt,
+                                   int64_t clk, uint64_t attr,
+                                   uint64_t addr, uint64_t len,
+                                   uint64_t offset, uint32_t path_len,
+                                   uint32_t flags)
+{
+    rp_encode_hdr(&pkt->hdr, cmd, id, dev,
+                  sizeof *pkt - sizeof pkt->hdr + path_len, flags);
+    pkt->timestamp = htobe64(clk);
+    pkt->attributes = htobe64(attr);
+    pkt->addr = htobe64(addr);
+    pkt->len = htobe64(len);
+    pkt->offset = htobe64(offset);
+    /* The path goes right after the packet.  */
+    pkt->path_offset = htobe32(path_len ? sizeof *pkt : 0);
+    pkt->path_len = htobe32(path_len);
+    return sizeof *pkt;
+}
+
+size_t rp_encode_map(uint32_t id, uint32_t dev,
+                     struct rp_pkt_map *pkt,
+                     int64_t clk, uint64_t attr,
+                     uint64_t addr, uint64_t len)
+{
+    return rp_encode_map_common(RP_CMD_map, id, dev, pkt, clk, attr,
+                                addr, len, 0, 0, 0);
+}
+
+size_t rp_encode_map_resp(uint32_t id, uint32_t dev,
+                          struct rp_pkt_map *pkt,
+                          int64_t clk, uint64_t attr,
+                          uint64_t addr, uint64_t len,
+                          uint64_t offset, uint32_t path_len)
+{
+    return rp_encode_map_common(RP_CMD_map, id, dev, pkt, clk, attr,
+                                addr, len, offset, path_len,
+                                RP_PKT_FLAGS_response);
+}
+
+size_t rp_encode_unmap(uint32_t id, uint32_t dev,
+                       struct rp_pkt_map *pkt,
+                       int64_t clk, uint64_t addr, uint64_t len,
+                       uint32_t flags)
+{
+    return rp_encode_map_common(RP_CMD_unmap, id, dev, pkt, clk, 0,
+                                addr, len, 0, 0, flags);
+}
+
+size_t rp_encode_unmap_resp(uint32_t id, uint32_t dev,
+                            struct rp_pkt_map *pkt,
+                            int64_t clk, uint64_t addr, uint64_t len)
+{
+    return rp_encode_map_common(RP_CMD_unmap, id, dev, pkt, clk, 0,
+                                addr, len, 0, 0, RP_PKT_FLAGS_response);
+}
+
 void rp_process_caps(struct rp_peer_state *peer,
                      void *caps, size_t caps_len)
 {
@@ -419,6 +491,9 @@ void rp_process_caps(struct rp_peer_state *peer,
         case CAP_WIRE_POSTED_UPDATES:
             peer->caps.wire_posted_updates = true;
             break;
+        case CAP_MEMORY_MAP:
+            peer->caps.memory_map = true;
+            break;
         }
     }
 }
@@ -69,7 +69,9 @@ enum rp_cmd {
     RP_CMD_write       = 4,
     RP_CMD_interrupt   = 5,
     RP_CMD_sync        = 6,
-    RP_CMD_max         = 6
+    RP_CMD_map         = 7,
+    RP_CMD_unmap       = 8,
+    RP_CMD_max         = 8
 };
 
 enum {
@@ -135,6 +137,10 @@ enum {
      * of the posted header-flag.
      */
     CAP_WIRE_POSTED_UPDATES = 3,
+
+    /* Support for sharing memory regions through the map and unmap
+     * commands.  */
+    CAP_MEMORY_MAP = 4,
 };
 
 struct rp_pkt_hello {
@@ -230,6 +236,44 @@ struct rp_pkt_sync {
     uint64_t timestamp;
 } PACKED;
 
+/*
+ * Memory mapping.
+ *
+ * A map request asks the peer whether the memory at addr can be accessed
+ * directly. The response describes the region [addr, addr + len) that
+ * contains the requested address. If the region is backed by a file
+ * that can be shared, the response carries the path to it together with
+ * the offset of the region in the file. The path may be a regular file,
+ * a file on a hugetlbfs or tmpfs mount or /proc/<pid>/fd/<fd> for memory
+ * that only exists as a file descriptor (e.g memfd). A response without
+ * a path means that the region must be accessed through read and write
+ * commands.
+ *
+ * When the peer changes the mapping of a region it has previously handed
+ * out, it sends an unmap request for the affected range. Receivers must
+ * stop accessing the region before responding.
+ */
+enum {
+    RP_MAP_ATTR_READ    =  (1 << 0),
+    RP_MAP_ATTR_WRITE   =  (1 << 1),
+};
+
+struct rp_pkt_map {
+    struct rp_pkt_hdr hdr;
+    uint64_t timestamp;
+    uint64_t attributes;
+    uint64_t addr;
+    uint64_t len;
+
+    /* Offset of addr into the file.  */
+    uint64_t offset;
+
+    /* Offset to the path from start of pkt and its length, without
+       a terminating zero. Zero length if there's no path.  */
+    uint32_t path_offset;
+    uint32_t path_len;
+} PACKED;
+
 struct rp_pkt {
     union {
         struct rp_pkt_hdr hdr;
@@ -238,6 +282,7 @@ struct rp_pkt {
         struct rp_pkt_busaccess_ext_base busaccess_ext_base;
         struct rp_pkt_interrupt interrupt;
         struct rp_pkt_sync sync;
+        struct rp_pkt_map map;
     };
 };
 
@@ -253,6 +298,7 @@ struct rp_peer_state {
         bool busaccess_ext_base;
         bool busaccess_ext_byte_en;
         bool wire_posted_updates;
+        bool memory_map;
     } caps;
 
     /* Used to normalize our clk.  */
@@ -435,6 +481,43 @@ size_t rp_encode_sync_resp(uint32_t id, uint32_t dev,
                            struct rp_pkt_sync *pkt,
                            int64_t clk);
 
+/*
+ * Map and unmap requests and responses.
+ * For map responses with a path, the path_len bytes of the path should
+ * be sent right after the packet.
+ */
+size_t rp_encode_map(uint32_t id, uint32_t dev,
+                     struct rp_pkt_map *pkt,
+                     int64_t clk, uint64_t attr,
+                     uint64_t addr, uint64_t len);
+
+size_t rp_encode_map_resp(uint32_t id, uint32_t dev,
+                          struct rp_pkt_map *pkt,
+                          int64_t clk, uint64_t attr,
+                          uint64_t addr, uint64_t len,
+                          uint64_t offset, uint32_t path_len);
+
+size_t rp_encode_unmap(uint32_t id, uint32_t dev,
+                       struct rp_pkt_map *pkt,
+                       int64_t clk, uint64_t addr, uint64_t len,
+                       uint32_t flags);
+
+size_t rp_encode_unmap_resp(uint32_t id, uint32_t dev,
+                            struct rp_pkt_map *pkt,
+                            int64_t clk, uint64_t addr, uint64_t len);
+
+static inline char *
+rp_map_path_ptr(struct rp_pkt_map *pkt)
+{
+    if (!pkt->path_len) {
+        return NULL;
+    }
+    assert(pkt->path_offset >= sizeof *pkt);
+    assert(pkt->path_offset + pkt->path_len
+           <= pkt->hdr.len + sizeof pkt->hdr);
+    return (char *) pkt + pkt->path_offset;
+}
+
 void rp_process_caps(struct rp_peer_state *peer,
                      void *caps, size_t caps_len);
 
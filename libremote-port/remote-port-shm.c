@@ -0,0 +1,504 @@
+/*
+ * Shared memory remote-port transport.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "remote-port-io.h"
+#include "remote-port-shm.h"
+
+#undef MIN
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+#define RP_SHM_MAGIC 0x52505348 /* "RPSH".  */
+#define RP_SHM_VERSION 1
+
+/* Bounds for the adaptive number of polls before sleeping.  */
+#define RP_SHM_SPIN_MIN 64
+#define RP_SHM_SPIN_MAX (64 * 1024)
+
+/* How long to wait for a peer that has created but not yet set up
+ * the file before we consider it stale. In ms.  */
+#define RP_SHM_SETUP_TIMEOUT 5000
+
+#define RP_SHM_ALIGNED __attribute__ ((aligned(64)))
+
+/* Everything below lives in the shared mapping.  */
+struct rp_shm_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t ring_size;
+	/* Futex. 0 when free, 1 while a peer is attaching and 2 once
+	 * it's done.  */
+	uint32_t attached;
+	/* Creator and attacher.  */
+	int32_t pid[2];
+} RP_SHM_ALIGNED;
+
+struct rp_shm_ring {
+	/* Written by the producer.  */
+	uint64_t head RP_SHM_ALIGNED;
+	/* Futex, bumped by the producer to wake up the consumer.  */
+	uint32_t head_seq;
+
+	/* Written by the consumer.  */
+	uint64_t tail RP_SHM_ALIGNED;
+	/* Futex, bumped by the consumer to wake up the producer.  */
+	uint32_t tail_seq;
+
+	/* Set by either side before going to sleep.  */
+	uint32_t consumer_sleeping RP_SHM_ALIGNED;
+	uint32_t producer_sleeping;
+
+	unsigned char data[] RP_SHM_ALIGNED;
+};
+
+struct rp_shm {
+	unsigned char *map;
+	size_t map_size;
+	uint32_t ring_size;
+
+	struct rp_shm_hdr *hdr;
+	struct rp_shm_ring *rx;
+	struct rp_shm_ring *tx;
+	/* Index of the peer in hdr->pid.  */
+	int peer;
+
+	unsigned int rx_spin;
+	unsigned int tx_spin;
+};
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+static long futex(uint32_t *uaddr, int op, uint32_t val,
+		  const struct timespec *ts)
+{
+	return syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
+
+static bool rp_shm_pid_alive(pid_t pid)
+{
+	return !(kill(pid, 0) == -1 && errno == ESRCH);
+}
+
+static bool rp_shm_peer_alive(struct rp_shm *shm)
+{
+	return rp_shm_pid_alive(__atomic_load_n(&shm->hdr->pid[shm->peer],
+						__ATOMIC_ACQUIRE));
+}
+
+/*
+ * Wait for the peer to move *idx away from old.
+ *
+ * Polls first. If that doesn't pay off, flags that we're sleeping and
+ * waits on the seq futex which the peer bumps when it sees the flag.
+ * The sleeping flag is set before rechecking *idx and the peer updates
+ * its index before checking the flag, so one of us will notice.
+ */
+static int rp_shm_wait(struct rp_shm *shm, uint64_t *idx, uint64_t old,
+		       uint32_t *seq, uint32_t *sleeping,
+		       unsigned int *spin, uint64_t *nr_syscalls)
+{
+	struct timespec ts = { .tv_sec = 1 };
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < *spin; i++) {
+		if (__atomic_load_n(idx, __ATOMIC_ACQUIRE) != old) {
+			/* Polling paid off, poll longer next time.  */
+			if (*spin < RP_SHM_SPIN_MAX)
+				*spin *= 2;
+			return 0;
+		}
+		cpu_relax();
+	}
+
+	/* Peer is not keeping up, don't burn as much CPU next time.  */
+	if (*spin > RP_SHM_SPIN_MIN)
+		*spin /= 2;
+
+	while (1) {
+		uint32_t s = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+		long r;
+
+		__atomic_store_n(sleeping, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(idx, __ATOMIC_SEQ_CST) != old)
+			break;
+
+		(*nr_syscalls)++;
+		r = futex(seq, FUTEX_WAIT, s, &ts);
+		if (r == -1 && errno == ETIMEDOUT && !rp_shm_peer_alive(shm)) {
+			ret = -1;
+			break;
+		}
+
+		/* The futex syscall isn't a cancellation point, let a
+		 * cancelled reader thread (rp_io_reader_run) go.  */
+		pthread_testcancel();
+	}
+	__atomic_store_n(sleeping, 0, __ATOMIC_RELAXED);
+	return ret;
+}
+
+/* Wake up the peer if it has gone to sleep waiting for us.  */
+static void rp_shm_kick(uint32_t *seq, uint32_t *sleeping,
+			uint64_t *nr_syscalls)
+{
+	if (__atomic_load_n(sleeping, __ATOMIC_SEQ_CST)) {
+		__atomic_fetch_add(seq, 1, __ATOMIC_SEQ_CST);
+		(*nr_syscalls)++;
+		futex(seq, FUTEX_WAKE, 1, NULL);
+	}
+}
+
+size_t rp_shm_rx_avail(struct rp_shm *shm)
+{
+	struct rp_shm_ring *ring = shm->rx;
+
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)
+		- __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
+
+int rp_shm_wait_rx(struct rp_shm *shm, struct rp_io_stats *stats)
+{
+	struct rp_shm_ring *ring = shm->rx;
+	uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+	if (rp_shm_rx_avail(shm))
+		return 0;
+
+	return rp_shm_wait(shm, &ring->head, tail,
+			   &ring->head_seq, &ring->consumer_sleeping,
+			   &shm->rx_spin, &stats->rx_syscalls);
+}
+
+ssize_t rp_shm_read(struct rp_shm *shm, void *rbuf, size_t count,
+		    struct rp_io_stats *stats)
+{
+	struct rp_shm_ring *ring = shm->rx;
+	uint32_t mask = shm->ring_size - 1;
+	uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	unsigned char *buf = rbuf;
+	size_t rlen = 0;
+
+	while (rlen < count) {
+		uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		size_t off = tail & mask;
+		size_t len;
+
+		if (head == tail) {
+			if (rp_shm_wait(shm, &ring->head, tail,
+					&ring->head_seq,
+					&ring->consumer_sleeping,
+					&shm->rx_spin, &stats->rx_syscalls))
+				break;
+			continue;
+		}
+
+		len = MIN(count - rlen, head - tail);
+		len = MIN(len, shm->ring_size - off);
+		memcpy(buf + rlen, ring->data + off, len);
+		tail += len;
+		rlen += len;
+
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+		rp_shm_kick(&ring->tail_seq, &ring->producer_sleeping,
+			    &stats->rx_syscalls);
+	}
+	stats->rx_bytes += rlen;
+	return rlen;
+}
+
+static void rp_shm_publish(struct rp_shm_ring *ring, uint64_t head,
+			   struct rp_io_stats *stats)
+{
+	__atomic_store_n(&ring->head, head, __ATOMIC_SEQ_CST);
+	rp_shm_kick(&ring->head_seq, &ring->consumer_sleeping,
+		    &stats->tx_syscalls);
+}
+
+ssize_t rp_shm_writev(struct rp_shm *shm, const struct iovec *iov, int iovcnt,
+		      struct rp_io_stats *stats)
+{
+	struct rp_shm_ring *ring = shm->tx;
+	uint32_t mask = shm->ring_size - 1;
+	uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	size_t wlen = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		const unsigned char *buf = iov[i].iov_base;
+		size_t done = 0;
+
+		while (done < iov[i].iov_len) {
+			uint64_t tail = __atomic_load_n(&ring->tail,
+							__ATOMIC_ACQUIRE);
+			size_t space = shm->ring_size - (head - tail);
+			size_t off = head & mask;
+			size_t len;
+
+			if (space == 0) {
+				/* Let the peer drain what we have so far.  */
+				rp_shm_publish(ring, head, stats);
+				if (rp_shm_wait(shm, &ring->tail, tail,
+						&ring->tail_seq,
+						&ring->producer_sleeping,
+						&shm->tx_spin,
+						&stats->tx_syscalls))
+					goto done;
+				continue;
+			}
+
+			len = MIN(iov[i].iov_len - done, space);
+			len = MIN(len, shm->ring_size - off);
+			memcpy(ring->data + off, buf + done, len);
+			head += len;
+			done += len;
+			wlen += len;
+		}
+	}
+
+	/* Make the whole packet visible at once.  */
+	rp_shm_publish(ring, head, stats);
+done:
+	stats->tx_bytes += wlen;
+	return wlen;
+}
+
+/*
+ * Wait for cond to become true, polling every ms.
+ * Used during setup only.
+ */
+#define RP_SHM_SETUP_WAIT(cond) ({				\
+	unsigned int __ms = 0;					\
+	while (!(cond) && __ms++ < RP_SHM_SETUP_TIMEOUT)	\
+		usleep(1000);					\
+	(cond);							\
+})
+
+static void rp_shm_setup_rings(struct rp_shm *shm, bool creator)
+{
+	size_t stride = sizeof(struct rp_shm_ring) + shm->ring_size;
+	unsigned char *rings = shm->map + sizeof(struct rp_shm_hdr);
+	struct rp_shm_ring *ring0 = (struct rp_shm_ring *) rings;
+	struct rp_shm_ring *ring1 = (struct rp_shm_ring *) (rings + stride);
+
+	shm->hdr = (struct rp_shm_hdr *) shm->map;
+	shm->tx = creator ? ring0 : ring1;
+	shm->rx = creator ? ring1 : ring0;
+	shm->peer = creator ? 1 : 0;
+	shm->rx_spin = RP_SHM_SPIN_MIN;
+	shm->tx_spin = RP_SHM_SPIN_MIN;
+}
+
+enum rp_shm_attach_result {
+	RP_SHM_ATTACHED,
+	/* Left over from an earlier run, safe to remove.  */
+	RP_SHM_STALE,
+	/* In use or unusable, must be left alone.  */
+	RP_SHM_FAILED,
+};
+
+static enum rp_shm_attach_result rp_shm_attach(struct rp_shm *shm, int fd,
+					       const char *path)
+{
+	struct rp_shm_hdr *hdr;
+	struct stat st;
+	uint32_t expected = 0;
+
+	/* The creator may still be setting the file up.  */
+	if (!RP_SHM_SETUP_WAIT(fstat(fd, &st) == 0
+			       && (size_t) st.st_size >= shm->map_size)) {
+		/* The creator never got to size it.  */
+		return RP_SHM_STALE;
+	}
+
+	shm->map = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	if (shm->map == MAP_FAILED) {
+		perror(path);
+		shm->map = NULL;
+		return RP_SHM_FAILED;
+	}
+	rp_shm_setup_rings(shm, false);
+	hdr = shm->hdr;
+
+	if (!RP_SHM_SETUP_WAIT(__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE)
+			       == RP_SHM_MAGIC)) {
+		/* The creator never got to set it up.  */
+		return RP_SHM_STALE;
+	}
+
+	if (!rp_shm_pid_alive(hdr->pid[0])) {
+		return RP_SHM_STALE;
+	}
+
+	if (hdr->version != RP_SHM_VERSION
+	    || hdr->ring_size != shm->ring_size) {
+		fprintf(stderr, "remote-port shm: %s: incompatible peer\n",
+			path);
+		return RP_SHM_FAILED;
+	}
+
+	if (!__atomic_compare_exchange_n(&hdr->attached, &expected, 1, false,
+					 __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+		fprintf(stderr, "remote-port shm: %s: already in use\n",
+			path);
+		return RP_SHM_FAILED;
+	}
+
+	__atomic_store_n(&hdr->pid[1], getpid(), __ATOMIC_RELEASE);
+	__atomic_store_n(&hdr->attached, 2, __ATOMIC_SEQ_CST);
+	futex(&hdr->attached, FUTEX_WAKE, 1, NULL);
+	return RP_SHM_ATTACHED;
+}
+
+static bool rp_shm_create(struct rp_shm *shm, int fd, const char *path)
+{
+	struct rp_shm_hdr *hdr;
+	uint32_t attached;
+
+	if (ftruncate(fd, shm->map_size) < 0) {
+		perror(path);
+		return false;
+	}
+
+	shm->map = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	if (shm->map == MAP_FAILED) {
+		perror(path);
+		shm->map = NULL;
+		return false;
+	}
+	rp_shm_setup_rings(shm, true);
+	hdr = shm->hdr;
+
+	/* ftruncate zeroed everything, including the ring indexes.  */
+	hdr->version = RP_SHM_VERSION;
+	hdr->ring_size = shm->ring_size;
+	hdr->pid[0] = getpid();
+	__atomic_store_n(&hdr->magic, RP_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	printf("Waiting for peer to attach to %s\n", path);
+	while ((attached = __atomic_load_n(&hdr->attached,
+					   __ATOMIC_ACQUIRE)) != 2) {
+		futex(&hdr->attached, FUTEX_WAIT, attached, NULL);
+	}
+	return true;
+}
+
+struct rp_shm *rp_shm_open(const char *path)
+{
+	struct rp_shm *shm;
+	unsigned int tries;
+
+	shm = calloc(1, sizeof *shm);
+	if (shm == NULL) {
+		return NULL;
+	}
+	shm->ring_size = RP_SHM_RING_SIZE;
+	shm->map_size = sizeof(struct rp_shm_hdr)
+			+ 2 * (sizeof(struct rp_shm_ring) + shm->ring_size);
+
+	for (tries = 0; tries < 3; tries++) {
+		enum rp_shm_attach_result r;
+		bool ok;
+		int fd;
+
+		fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd >= 0) {
+			ok = rp_shm_create(shm, fd, path);
+			close(fd);
+			/* Both sides have it mapped, no need to keep the
+			 * file around.  */
+			unlink(path);
+			if (ok) {
+				return shm;
+			}
+			break;
+		}
+
+		if (errno != EEXIST) {
+			perror(path);
+			break;
+		}
+
+		fd = open(path, O_RDWR);
+		if (fd < 0) {
+			/* Raced with the creator removing it.  */
+			continue;
+		}
+		r = rp_shm_attach(shm, fd, path);
+		close(fd);
+		if (r == RP_SHM_ATTACHED) {
+			return shm;
+		}
+
+		if (shm->map) {
+			munmap(shm->map, shm->map_size);
+			shm->map = NULL;
+		}
+		if (r == RP_SHM_FAILED) {
+			break;
+		}
+
+		/* Left over from an earlier run. Remove it and retry.  */
+		printf("Removing stale %s\n", path);
+		unlink(path);
+	}
+
+	if (shm->map) {
+		munmap(shm->map, shm->map_size);
+	}
+	free(shm);
+	return NULL;
+}
+
+void rp_shm_close(struct rp_shm *shm)
+{
+	munmap(shm->map, shm->map_size);
+	free(shm);
+}
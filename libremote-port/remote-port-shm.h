@@ -0,0 +1,73 @@
+/*
+ * Shared memory remote-port transport.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef REMOTE_PORT_SHM
+#define REMOTE_PORT_SHM
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*
+ * A pair of single-producer single-consumer byte rings living in a file
+ * mapped by both peers, e.g shm:/dev/shm/qemu-rp. The first side to open
+ * the path creates it and waits for the peer to attach, much like the
+ * unix: sockets do.
+ *
+ * Readers and writers poll the ring indexes for a while before going to
+ * sleep on a futex in the shared mapping. The number of polls adapts to
+ * how often polling succeeds, so back-to-back MMIO round trips are
+ * serviced without entering the kernel while idle peers still sleep.
+ */
+
+#define RP_SHM_PREFIX "shm:"
+#define RP_SHM_RING_SIZE (1024 * 1024)
+
+struct rp_io_stats;
+struct rp_shm;
+
+struct rp_shm *rp_shm_open(const char *path);
+void rp_shm_close(struct rp_shm *shm);
+
+/* Bytes that can be read without blocking.  */
+size_t rp_shm_rx_avail(struct rp_shm *shm);
+
+/*
+ * Block until there's data to read.
+ * Returns 0 on success and -1 if the peer has gone away.
+ */
+int rp_shm_wait_rx(struct rp_shm *shm, struct rp_io_stats *stats);
+
+/*
+ * Read exactly count bytes. Returns less than count if the peer
+ * has gone away.
+ */
+ssize_t rp_shm_read(struct rp_shm *shm, void *buf, size_t count,
+		    struct rp_io_stats *stats);
+
+/* Write all of iov. Returns the number of bytes written.  */
+ssize_t rp_shm_writev(struct rp_shm *shm, const struct iovec *iov, int iovcnt,
+		      struct rp_io_stats *stats);
+
+#endif
@@ -26,6 +26,9 @@
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
 #include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/utsname.h>
 
 #include "systemc.h"
@@ -48,9 +51,26 @@ using namespace sc_core;
 using namespace std;
 
 remoteport_tlm_memory_slave::remoteport_tlm_memory_slave(sc_module_name name)
-	: sc_module(name)
+	: sc_module(name),
+	  nb_resp_in_progress(false),
+	  dmi_map_pending(false)
 {
 	sk.register_b_transport(this, &remoteport_tlm_memory_slave::b_transport);
+	sk.register_nb_transport_fw(this,
+			&remoteport_tlm_memory_slave::nb_transport_fw);
+	sk.register_get_direct_mem_ptr(this,
+			&remoteport_tlm_memory_slave::get_direct_mem_ptr);
+}
+
+remoteport_tlm_memory_slave::~remoteport_tlm_memory_slave(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < dmi_regions.size(); i++) {
+		if (dmi_regions[i].map_base) {
+			munmap(dmi_regions[i].map_base, dmi_regions[i].map_len);
+		}
+	}
 }
 
 void remoteport_tlm_memory_slave::tie_off(void)
@@ -75,8 +95,9 @@ static inline uint64_t genattr_to_rpattr(genattr_extension *genattr)
 	return rp_attr;
 }
 
-void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
-				       sc_time& delay)
+// Send trans to our peer. Returns false if trans can't be sent.
+bool remoteport_tlm_memory_slave::issue(tlm::tlm_generic_payload& trans,
+					uint32_t *id, bool *is_posted)
 {
 	size_t plen;
 	struct rp_encode_busaccess_in in = {0};
@@ -87,16 +108,18 @@ void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
 	unsigned char *be = trans.get_byte_enable_ptr();
 	unsigned int len = trans.get_data_length();
 	unsigned int wid = trans.get_streaming_width();
-	remoteport_packet pkt_tx;
+	struct rp_pkt pkt_tx;
+	struct iovec iov[3];
+	int iovcnt = 0;
 	genattr_extension *genattr;
 	uint16_t master_id = 0;
 	uint64_t attr = 0;
-	unsigned int ri;
-	bool is_posted = false;
+
+	*is_posted = false;
 
 	if (be && !adaptor->peer.caps.busaccess_ext_byte_en) {
 		trans.set_response_status(tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE);
-		return;
+		return false;
 	}
 
 	trans.get_extension(genattr);
@@ -104,10 +127,9 @@ void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
 		in.flags |= genattr->get_posted() ? RP_PKT_FLAGS_posted : 0;
 		master_id = genattr->get_master_id();
 		attr |= genattr_to_rpattr(genattr);
-		is_posted = genattr->get_posted();
+		*is_posted = genattr->get_posted();
 	}
 
-	pkt_tx.alloc(sizeof pkt_tx.pkt->busaccess + len);
 	in.clk = adaptor->rp_map_time(adaptor->sync->get_current_time());
 
 	in.cmd = cmd == tlm::TLM_READ_COMMAND ? RP_CMD_read : RP_CMD_write;
@@ -123,28 +145,42 @@ void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
 
 
 	plen = rp_encode_busaccess(&adaptor->peer,
-				   &pkt_tx.pkt->busaccess_ext_base,
+				   &pkt_tx.busaccess_ext_base,
 				   &in);
 
-	adaptor->rp_write(pkt_tx.pkt, plen);
+	// Header, data and byte-enables go out with a single syscall.
+	iov[iovcnt].iov_base = &pkt_tx;
+	iov[iovcnt].iov_len = plen;
+	iovcnt++;
 	if (cmd == tlm::TLM_WRITE_COMMAND) {
-		adaptor->rp_write(data, len);
+		iov[iovcnt].iov_base = data;
+		iov[iovcnt].iov_len = len;
+		iovcnt++;
 	}
 	if (in.byte_enable_len) {
-		adaptor->rp_write(be, in.byte_enable_len);
+		iov[iovcnt].iov_base = be;
+		iov[iovcnt].iov_len = in.byte_enable_len;
+		iovcnt++;
 	}
+	adaptor->rp_writev(iov, iovcnt);
 
 	trans.set_response_status(tlm::TLM_OK_RESPONSE);
-	if (is_posted) {
-		return;
-	}
+	*id = in.id;
+	return true;
+}
 
-	ri = response_wait(in.id);
-	assert(resp[ri].pkt.pkt->hdr.id == in.id);
+// Fill in trans from the response in slot ri and give the slot back.
+void remoteport_tlm_memory_slave::complete(tlm::tlm_generic_payload& trans,
+					   unsigned int ri)
+{
+	unsigned char *data = trans.get_data_ptr();
+	unsigned char *be = trans.get_byte_enable_ptr();
+	unsigned int be_len = trans.get_byte_enable_length();
+	unsigned int len = trans.get_data_length();
 
-	if (cmd == tlm::TLM_READ_COMMAND) {
+	if (trans.get_command() == tlm::TLM_READ_COMMAND) {
 		uint8_t *rx_data = rp_busaccess_rx_dataptr(&adaptor->peer,
-					   &resp[ri].pkt.pkt->busaccess_ext_base);
+					   &resp[ri].pkt->pkt->busaccess_ext_base);
 
 		// Handle READ byte-enables.
 		//
@@ -159,11 +195,11 @@ void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
 		// The remote peer does not control our buffer, so we
 		// do it here.
 		//
-		if (in.byte_enable_len) {
+		if (be && be_len) {
 			unsigned int i;
 
 			for (i = 0; i < len; i++) {
-				uint8_t b = be[i % in.byte_enable_len];
+				uint8_t b = be[i % be_len];
 				if (b == TLM_BYTE_ENABLED) {
 					data[i] = rx_data[i];
 				}
@@ -175,3 +211,290 @@ void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
 	// Give back the RP response slot.
 	response_done(ri);
 }
+
+void remoteport_tlm_memory_slave::b_transport(tlm::tlm_generic_payload& trans,
+				       sc_time& delay)
+{
+	unsigned int ri;
+	bool is_posted;
+	uint32_t id;
+
+	if (!issue(trans, &id, &is_posted)) {
+		return;
+	}
+
+	if (is_posted) {
+		return;
+	}
+
+	ri = response_wait(id);
+	assert(resp[ri].pkt->pkt->hdr.id == id);
+	complete(trans, ri);
+	dmi_hint(trans);
+}
+
+// Let the initiator know if it could use DMI instead. Ranges we
+// haven't asked the peer about yet might be mappable, only those
+// the peer couldn't map are excluded.
+void remoteport_tlm_memory_slave::dmi_hint(tlm::tlm_generic_payload& trans)
+{
+	if (adaptor->peer.caps.memory_map) {
+		dmi_region *r = dmi_lookup(trans.get_address());
+
+		trans.set_dmi_allowed(!r || r->ptr);
+	}
+}
+
+// Non-blocking transport.
+//
+// Requests are sent to the peer and accepted right away, so an
+// initiator can have many of them in flight. Responses are handed
+// back with BEGIN_RESP as they arrive, one at a time as required by
+// the base protocol, and not before the annotated time of the
+// request. Transactions are held (acquired) until the initiator
+// has sent END_RESP.
+tlm::tlm_sync_enum remoteport_tlm_memory_slave::nb_transport_fw(
+					tlm::tlm_generic_payload& trans,
+					tlm::tlm_phase& phase,
+					sc_time& delay)
+{
+	nb_txn *t;
+	bool is_posted;
+	uint32_t id;
+
+	if (phase == tlm::END_RESP) {
+		nb_resp_release(&trans);
+		nb_resp_in_progress = false;
+		nb_send_responses();
+		return tlm::TLM_COMPLETED;
+	}
+
+	if (phase != tlm::BEGIN_REQ) {
+		SC_REPORT_ERROR("remoteport_tlm_memory_slave",
+				"Unexpected phase in nb_transport_fw");
+		return tlm::TLM_COMPLETED;
+	}
+
+	if (!issue(trans, &id, &is_posted) || is_posted) {
+		// Nothing to wait for.
+		phase = tlm::BEGIN_RESP;
+		return tlm::TLM_COMPLETED;
+	}
+
+	if (trans.has_mm()) {
+		trans.acquire();
+	}
+
+	t = new nb_txn;
+	t->trans = &trans;
+	t->req_time = sc_time_stamp() + delay;
+
+	response_async(id, t);
+	phase = tlm::END_REQ;
+	return tlm::TLM_UPDATED;
+}
+
+// Called from the remote-port thread when a response for a
+// non-blocking transaction has arrived.
+void remoteport_tlm_memory_slave::response_complete(unsigned int ri)
+{
+	nb_txn *t;
+
+	if (resp[ri].pkt->pkt->hdr.cmd == RP_CMD_map) {
+		dmi_map_response(ri);
+		return;
+	}
+
+	t = (nb_txn *) resp[ri].opaque;
+	complete(*t->trans, ri);
+	dmi_hint(*t->trans);
+
+	nb_resp_queue.push_back(t);
+	nb_send_responses();
+}
+
+void remoteport_tlm_memory_slave::nb_send_responses(void)
+{
+	while (!nb_resp_in_progress && !nb_resp_queue.empty()) {
+		nb_txn *t = nb_resp_queue.front();
+		tlm::tlm_generic_payload *trans = t->trans;
+		tlm::tlm_phase phase = tlm::BEGIN_RESP;
+		sc_time now = sc_time_stamp();
+		sc_time delay = SC_ZERO_TIME;
+		tlm::tlm_sync_enum r;
+
+		if (t->req_time > now) {
+			delay = t->req_time - now;
+		}
+
+		nb_resp_queue.pop_front();
+		delete t;
+
+		r = sk->nb_transport_bw(*trans, phase, delay);
+		if (r == tlm::TLM_ACCEPTED
+		    || (r == tlm::TLM_UPDATED && phase != tlm::END_RESP)) {
+			// Wait for END_RESP before the next response.
+			nb_resp_in_progress = true;
+		} else {
+			nb_resp_release(trans);
+		}
+	}
+}
+
+void remoteport_tlm_memory_slave::nb_resp_release(
+					tlm::tlm_generic_payload *trans)
+{
+	if (trans->has_mm()) {
+		trans->release();
+	}
+}
+
+// DMI into peer memory.
+//
+// get_direct_mem_ptr is not allowed to wait, so a miss sends a map
+// request to the peer and fails. Once the peer has answered, the
+// region is cached. The DMI hint is set on transactions to regions
+// that are mapped or not yet known, so that initiators ask (again).
+remoteport_tlm_memory_slave::dmi_region *
+remoteport_tlm_memory_slave::dmi_lookup(uint64_t addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < dmi_regions.size(); i++) {
+		if (addr >= dmi_regions[i].start && addr <= dmi_regions[i].end) {
+			return &dmi_regions[i];
+		}
+	}
+	return NULL;
+}
+
+void remoteport_tlm_memory_slave::dmi_map_request(uint64_t addr)
+{
+	struct rp_pkt_map pkt_tx;
+	size_t plen;
+	int64_t clk;
+	uint32_t id;
+
+	// Keep one request in flight, initiators retry.
+	if (dmi_map_pending || !adaptor->peer.caps.memory_map) {
+		return;
+	}
+
+	id = adaptor->rp_pkt_id++;
+	clk = adaptor->rp_map_time(adaptor->sync->get_current_time());
+	plen = rp_encode_map(id, dev_id, &pkt_tx, clk,
+			     RP_MAP_ATTR_READ | RP_MAP_ATTR_WRITE, addr, 1);
+	response_async(id, NULL);
+	adaptor->rp_write(&pkt_tx, plen);
+	dmi_map_pending = true;
+}
+
+void remoteport_tlm_memory_slave::dmi_map_response(unsigned int ri)
+{
+	struct rp_pkt_map *map = &resp[ri].pkt->pkt->map;
+	char *rpath = rp_map_path_ptr(map);
+	dmi_region r = {0};
+
+	dmi_map_pending = false;
+
+	if (!map->len) {
+		response_done(ri);
+		return;
+	}
+
+	r.start = map->addr;
+	r.end = map->addr + map->len - 1;
+	r.access = tlm::tlm_dmi::DMI_ACCESS_NONE;
+
+	if (rpath) {
+		std::string path(rpath, map->path_len);
+		bool rw = map->attributes & RP_MAP_ATTR_WRITE;
+		long pgsize = sysconf(_SC_PAGESIZE);
+		uint64_t map_offset = map->offset & ~(uint64_t)(pgsize - 1);
+		size_t skip = map->offset - map_offset;
+		int fd;
+
+		fd = open(path.c_str(), rw ? O_RDWR : O_RDONLY);
+		if (fd >= 0) {
+			r.map_len = map->len + skip;
+			r.map_base = mmap(NULL, r.map_len,
+					  PROT_READ | (rw ? PROT_WRITE : 0),
+					  MAP_SHARED, fd, map_offset);
+			close(fd);
+		}
+		if (fd < 0 || r.map_base == MAP_FAILED) {
+			SC_REPORT_WARNING("remoteport_tlm_memory_slave",
+					  "Failed to map peer memory");
+			perror(path.c_str());
+			r.map_base = NULL;
+			r.map_len = 0;
+		} else {
+			r.ptr = (unsigned char *) r.map_base + skip;
+			r.access = rw ? tlm::tlm_dmi::DMI_ACCESS_READ_WRITE
+				      : tlm::tlm_dmi::DMI_ACCESS_READ;
+		}
+	}
+
+	// Replace whatever we knew about the range.
+	dmi_unmap(r.start, r.end);
+	dmi_regions.push_back(r);
+	response_done(ri);
+}
+
+void remoteport_tlm_memory_slave::dmi_unmap(uint64_t start, uint64_t end)
+{
+	unsigned int i = 0;
+
+	while (i < dmi_regions.size()) {
+		dmi_region &r = dmi_regions[i];
+
+		if (r.end < start || r.start > end) {
+			i++;
+			continue;
+		}
+
+		if (r.ptr) {
+			sk->invalidate_direct_mem_ptr(r.start, r.end);
+			munmap(r.map_base, r.map_len);
+		}
+		dmi_regions[i] = dmi_regions.back();
+		dmi_regions.pop_back();
+	}
+}
+
+bool remoteport_tlm_memory_slave::get_direct_mem_ptr(
+					tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data)
+{
+	uint64_t addr = trans.get_address();
+	dmi_region *r = dmi_lookup(addr);
+
+	if (!r) {
+		dmi_map_request(addr);
+		// We don't know anything about the rest of the space.
+		dmi_data.set_start_address(addr);
+		dmi_data.set_end_address(addr);
+		return false;
+	}
+
+	dmi_data.set_start_address(r->start);
+	dmi_data.set_end_address(r->end);
+	if (!r->ptr) {
+		dmi_data.set_granted_access(tlm::tlm_dmi::DMI_ACCESS_NONE);
+		return false;
+	}
+
+	dmi_data.set_dmi_ptr(r->ptr);
+	dmi_data.set_granted_access(r->access);
+	dmi_data.set_read_latency(SC_ZERO_TIME);
+	dmi_data.set_write_latency(SC_ZERO_TIME);
+	return true;
+}
+
+// The peer has changed its memory map. Stop all direct accesses to
+// the range before acknowledging.
+void remoteport_tlm_memory_slave::cmd_unmap(struct rp_pkt &pkt, bool can_sync)
+{
+	dmi_unmap(pkt.map.addr, pkt.map.addr + pkt.map.len - 1);
+	remoteport_tlm_dev::cmd_unmap(pkt, can_sync);
+}
@@ -25,6 +25,9 @@
 #ifndef REMOTE_PORT_TLM_MEMORY_SLAVE
 #define REMOTE_PORT_TLM_MEMORY_SLAVE
 
+#include <list>
+#include <vector>
+
 class remoteport_tlm_memory_slave
 	: public sc_module, public remoteport_tlm_dev
 {
@@ -34,13 +37,60 @@ public:
 	tlm_utils::simple_target_socket<remoteport_tlm_memory_slave> sk;
 
         remoteport_tlm_memory_slave(sc_module_name name);
+	~remoteport_tlm_memory_slave(void);
 	void tie_off(void);
 
+	virtual void cmd_unmap(struct rp_pkt &pkt, bool can_sync);
+
 private:
 	tlm_utils::simple_initiator_socket<remoteport_tlm_memory_slave> *tieoff_sk;
 
+	// A non-blocking transaction waiting for its response and the
+	// time its BEGIN_REQ was annotated with.
+	struct nb_txn {
+		tlm::tlm_generic_payload *trans;
+		sc_time req_time;
+	};
+
+	// Completed non-blocking transactions waiting for BEGIN_RESP
+	// and whether a BEGIN_RESP is waiting for END_RESP.
+	std::list<nb_txn *> nb_resp_queue;
+	bool nb_resp_in_progress;
+
+	// Regions the peer has answered map requests for. Regions
+	// with a NULL ptr can't be accessed directly.
+	struct dmi_region {
+		uint64_t start;
+		uint64_t end;
+		unsigned char *ptr;
+		void *map_base;
+		size_t map_len;
+		tlm::tlm_dmi::dmi_access_e access;
+	};
+	std::vector<dmi_region> dmi_regions;
+	bool dmi_map_pending;
+
+	dmi_region *dmi_lookup(uint64_t addr);
+	void dmi_map_request(uint64_t addr);
+	void dmi_map_response(unsigned int ri);
+	void dmi_unmap(uint64_t start, uint64_t end);
+
+	bool issue(tlm::tlm_generic_payload& trans,
+		   uint32_t *id, bool *is_posted);
+	void complete(tlm::tlm_generic_payload& trans, unsigned int ri);
+	void dmi_hint(tlm::tlm_generic_payload& trans);
+	void nb_send_responses(void);
+	void nb_resp_release(tlm::tlm_generic_payload *trans);
+
 	virtual void b_transport(tlm::tlm_generic_payload& trans,
 				 sc_time& delay);
+	virtual tlm::tlm_sync_enum nb_transport_fw(
+				tlm::tlm_generic_payload& trans,
+				tlm::tlm_phase& phase,
+				sc_time& delay);
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data);
+	virtual void response_complete(unsigned int ri);
 };
 
 #endif
@@ -0,0 +1,178 @@
+/*
+ * System-C TLM-2.0 remoteport adaptive quantum synchronizer.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+#include "systemc.h"
+#include "tlm_utils/tlm_quantumkeeper.h"
+
+#include "remote-port-tlm.h"
+#include "remote-port-tlm-sync-adaptive.h"
+
+using namespace sc_core;
+using namespace std;
+
+remoteport_tlm_sync_adaptive::remoteport_tlm_sync_adaptive(
+					sc_time min_quantum,
+					sc_time max_quantum,
+					unsigned int dense_threshold)
+	: min_quantum(min_quantum),
+	  max_quantum(max_quantum),
+	  dense_threshold(dense_threshold),
+	  window_events(0)
+{
+	sc_time q = m_qk.get_global_quantum();
+
+	assert(min_quantum > SC_ZERO_TIME);
+	assert(min_quantum <= max_quantum);
+
+	// Start from the global quantum if there is one.
+	if (q < min_quantum) {
+		q = q == SC_ZERO_TIME ? max_quantum : min_quantum;
+	} else if (q > max_quantum) {
+		q = max_quantum;
+	}
+	m_qk.set_quantum(q);
+
+	memset(&m_stats, 0, sizeof m_stats);
+	reset();
+}
+
+void remoteport_tlm_sync_adaptive::account_time(int64_t rclk)
+{
+	int64_t lclk;
+	int64_t delta_ns;
+	sc_time delta;
+
+	lclk = map_time(m_qk.get_current_time());
+	if (lclk >= rclk) {
+		/* lclk may have rounding errors due to conversions.
+		 * To avoid deadlocks, we never allow the delta to be zero.
+		 */
+		delta_ns = 1;
+	} else {
+		delta_ns = rclk - lclk;
+	}
+
+	delta = sc_time((double) delta_ns, SC_NS);
+	if (delta > m_qk.get_quantum()) {
+		delta = m_qk.get_quantum();
+	}
+
+	// Never allow the local time to go beyond the quantum, cap it.
+	if (get_local_time() + delta >= m_qk.get_quantum()) {
+		set_local_time(m_qk.get_quantum());
+	} else {
+		inc_local_time(delta);
+	}
+}
+
+void remoteport_tlm_sync_adaptive::adapt(void)
+{
+	sc_time q = m_qk.get_quantum();
+
+	if (window_events >= dense_threshold && q > min_quantum) {
+		q = q / 2;
+		if (q < min_quantum) {
+			q = min_quantum;
+		}
+		m_stats.shrinks++;
+	} else if (window_events == 0 && q < max_quantum) {
+		q = q * 2;
+		if (q > max_quantum) {
+			q = max_quantum;
+		}
+		m_stats.grows++;
+	}
+
+	m_qk.set_quantum(q);
+	window_events = 0;
+}
+
+void remoteport_tlm_sync_adaptive::sync(void)
+{
+	m_stats.syncs++;
+	// The new quantum takes effect when m_qk resets after the wait.
+	adapt();
+	m_qk.sync();
+}
+
+void remoteport_tlm_sync_adaptive::reset(void)
+{
+	window_events = 0;
+	m_qk.reset();
+}
+
+void remoteport_tlm_sync_adaptive::pre_sync_cmd(int64_t rclk, bool can_sync)
+{
+	account_time(rclk);
+}
+
+void remoteport_tlm_sync_adaptive::post_sync_cmd(int64_t rclk, bool can_sync)
+{
+	if (can_sync && m_qk.need_sync()) {
+		sync();
+	}
+}
+
+void remoteport_tlm_sync_adaptive::post_any_cmd(remoteport_packet *pkt,
+						bool can_sync)
+{
+	if (can_sync && m_qk.need_sync()) {
+		sync();
+	}
+}
+
+void remoteport_tlm_sync_adaptive::pre_wire_cmd(int64_t rclk, bool can_sync)
+{
+	account_time(rclk);
+	window_events++;
+	m_stats.events++;
+	if (can_sync && m_qk.need_sync()) {
+		sync();
+	}
+}
+
+void remoteport_tlm_sync_adaptive::post_wire_cmd(int64_t rclk, bool can_sync)
+{
+	// Make line-updates visible to back-to-back transactions.
+	if (can_sync) {
+		wait(SC_ZERO_TIME);
+	}
+}
+
+void remoteport_tlm_sync_adaptive::pre_memory_master_cmd(int64_t rclk,
+							 bool can_sync)
+{
+	account_time(rclk);
+	window_events++;
+	m_stats.events++;
+	if (can_sync && m_qk.need_sync()) {
+		sync();
+	}
+}
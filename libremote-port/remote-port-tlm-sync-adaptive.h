@@ -0,0 +1,136 @@
+/*
+ * TLM remoteport adaptive quantum synchronizer.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef REMOTE_PORT_TLM_SYNC_ADAPTIVE
+#define REMOTE_PORT_TLM_SYNC_ADAPTIVE
+
+#include "tlm_utils/tlm_quantumkeeper.h"
+
+// A quantum keeper with a quantum of its own instead of the global one.
+class remoteport_tlm_quantumkeeper : public tlm_utils::tlm_quantumkeeper
+{
+public:
+	remoteport_tlm_quantumkeeper(void) :
+		m_quantum(sc_core::SC_ZERO_TIME)
+	{
+	}
+
+	// Takes effect at the next sync point. SC_ZERO_TIME selects
+	// the global quantum.
+	void set_quantum(sc_core::sc_time q) { m_quantum = q; }
+
+	sc_core::sc_time get_quantum(void) {
+		if (m_quantum == sc_core::SC_ZERO_TIME) {
+			return get_global_quantum();
+		}
+		return m_quantum;
+	}
+
+protected:
+	virtual sc_core::sc_time compute_local_quantum(void) {
+		if (m_quantum == sc_core::SC_ZERO_TIME) {
+			return tlm_quantumkeeper::compute_local_quantum();
+		}
+		return m_quantum;
+	}
+
+	sc_core::sc_time m_quantum;
+};
+
+// Loosely timed synchronizer that picks its own quantum.
+//
+// Interrupts and MMIO from the peer are counted per quantum. At every
+// sync point, the quantum is halved if the count reached
+// dense_threshold and doubled if there was no activity at all, keeping
+// it within [min_quantum, max_quantum]. Long compute phases thus run
+// with few syncs while bursts of peer interaction get fine grained
+// timing.
+//
+// Unlike remoteport_tlm_sync_loosely_timed, wire updates don't force
+// a sync. They are instead applied at most one (small, since wire
+// updates count as activity) quantum late.
+class remoteport_tlm_sync_adaptive : public Iremoteport_tlm_sync
+{
+public:
+	struct stats {
+		// Sync points reached and waits on SystemC time.
+		uint64_t syncs;
+		// Quantum changes.
+		uint64_t grows;
+		uint64_t shrinks;
+		// Interrupts and MMIO seen from the peer.
+		uint64_t events;
+	};
+
+	remoteport_tlm_sync_adaptive(
+			sc_core::sc_time min_quantum = sc_core::sc_time(1, sc_core::SC_US),
+			sc_core::sc_time max_quantum = sc_core::sc_time(1, sc_core::SC_MS),
+			unsigned int dense_threshold = 8);
+
+	// The quantum currently in use.
+	sc_core::sc_time get_quantum(void) { return m_qk.get_quantum(); }
+	const struct stats &get_stats(void) { return m_stats; }
+
+	virtual void account_time(int64_t rclk);
+
+	virtual void pre_sync_cmd(int64_t rclk, bool can_sync);
+	virtual void post_sync_cmd(int64_t rclk, bool can_sync);
+	virtual void post_any_cmd(remoteport_packet *pkt, bool can_sync);
+	virtual void pre_wire_cmd(int64_t rclk, bool can_sync);
+	virtual void post_wire_cmd(int64_t rclk, bool can_sync);
+	virtual void pre_memory_master_cmd(int64_t rclk, bool can_sync);
+
+	virtual sc_core::sc_time get_current_time() {
+		return m_qk.get_current_time();
+	}
+
+	virtual sc_core::sc_time get_local_time() {
+		return m_qk.get_local_time();
+	}
+
+	virtual void set_local_time(sc_core::sc_time t) {
+		m_qk.set(t);
+	}
+
+	virtual void inc_local_time(sc_core::sc_time t) {
+		m_qk.inc(t);
+	}
+
+	virtual void reset(void);
+	virtual void sync(void);
+
+protected:
+	remoteport_tlm_quantumkeeper m_qk;
+
+private:
+	sc_core::sc_time min_quantum;
+	sc_core::sc_time max_quantum;
+	unsigned int dense_threshold;
+	// Peer activity since the last sync point.
+	unsigned int window_events;
+	struct stats m_stats;
+
+	void adapt(void);
+};
+
+#endif
@@ -161,7 +161,7 @@ void remoteport_tlm_wires::wire_update(void)
 		if (adaptor->peer.caps.wire_posted_updates
                     && !(flags & RP_PKT_FLAGS_posted) ) {
 			ri = response_wait(id);
-			assert(resp[ri].pkt.pkt->hdr.id == id);
+			assert(resp[ri].pkt->pkt->hdr.id == id);
 			response_done(ri);
 		}
 	}
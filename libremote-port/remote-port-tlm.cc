@@ -247,6 +247,52 @@ void remoteport_packet::copy(remoteport_packet &pkt)
 	memcpy(pkt.u8, u8, size);
 }
 
+remoteport_packet_pool::remoteport_packet_pool(void)
+{
+	unsigned int i;
+
+	nr_allocated = 0;
+	free_pkts.reserve(RP_PKT_POOL_SIZE);
+	for (i = 0; i < RP_PKT_POOL_SIZE; i++) {
+		remoteport_packet *pkt = new remoteport_packet();
+
+		pkt->alloc(sizeof(pkt->pkt->hdr) + 128);
+		free_pkts.push_back(pkt);
+		nr_allocated++;
+	}
+}
+
+remoteport_packet_pool::~remoteport_packet_pool(void)
+{
+	while (!free_pkts.empty()) {
+		delete free_pkts.back();
+		free_pkts.pop_back();
+	}
+}
+
+remoteport_packet *remoteport_packet_pool::get(void)
+{
+	remoteport_packet *pkt;
+
+	// Only grows when more packets are in flight (nested rp_process
+	// calls plus packets held by response slots) than ever before.
+	if (free_pkts.empty()) {
+		pkt = new remoteport_packet();
+		pkt->alloc(sizeof(pkt->pkt->hdr) + 128);
+		nr_allocated++;
+		return pkt;
+	}
+
+	pkt = free_pkts.back();
+	free_pkts.pop_back();
+	return pkt;
+}
+
+void remoteport_packet_pool::put(remoteport_packet *pkt)
+{
+	free_pkts.push_back(pkt);
+}
+
 static void *thread_trampoline(void *arg) {
         class remoteport_tlm *t = (class remoteport_tlm *)(arg);
         t->rp_pkt_main();
@@ -280,45 +326,58 @@ remoteport_tlm::remoteport_tlm(sc_module_name name,
 
 	if (fd == -1) {
 		printf("open socket\n");
-		this->fd = sk_open(sk_descr);
-		if (this->fd == -1) {
+		// sk_descr may also select the shared memory transport,
+		// in which case there's no socket fd.
+		if (rp_io_open(&io, sk_descr, RP_IO_RX_SIZE_DEFAULT)) {
 			printf("Failed to create remote-port socket connection!\n");
 			if (sk_descr) {
 				perror(sk_descr);
 			}
 			exit(EXIT_FAILURE);
 		}
+		this->fd = io.fd;
+	} else {
+		rp_io_init(&io, fd, RP_IO_RX_SIZE_DEFAULT);
 	}
 
-	pthread_mutex_init(&rp_pkt_mutex, NULL);
 	SC_THREAD(process);
 
-	if (!blocking_socket)
+	if (!blocking_socket) {
+		if (rp_io_reader_init(&io)) {
+			perror("rp_io_reader_init");
+			exit(EXIT_FAILURE);
+		}
 		pthread_create(&rp_pkt_thread, NULL, thread_trampoline, this);
+	}
 }
 
-void remoteport_tlm::rp_pkt_main(void)
+remoteport_tlm::~remoteport_tlm()
 {
-	fd_set rd;
-	int r;
+	if (!blocking_socket) {
+		// The reader thread fills io's receive ring, stop it
+		// before the ring goes away.
+		pthread_cancel(rp_pkt_thread);
+		pthread_join(rp_pkt_thread, NULL);
+	}
+	rp_io_free(&io);
+}
 
-	while (true) {
-		FD_ZERO(&rd);
+void remoteport_tlm::rp_pkt_notify(void *opaque)
+{
+	remoteport_tlm *t = (remoteport_tlm *) opaque;
 
-		FD_SET(fd, &rd);
-		pthread_mutex_lock(&rp_pkt_mutex);
-		r = select(fd + 1, &rd, NULL, NULL, NULL);
-		if (r == -1 && errno == EINTR)
-			continue;
+	t->rp_pkt_event.notify(SC_ZERO_TIME);
+}
 
-		if (r == -1) {
-			perror("select()");
-			exit(EXIT_FAILURE);
-		}
+void remoteport_tlm::rp_pkt_main(void)
+{
+	int r;
 
-		rp_pkt_event.notify(SC_ZERO_TIME);
-		pthread_mutex_unlock(&rp_pkt_mutex);
-	}
+	// Only returns when the connection is gone.
+	r = rp_io_reader_run(&io, rp_pkt_notify, this);
+	if (r < 0)
+		perror(__func__);
+	exit(EXIT_FAILURE);
 }
 
 void remoteport_tlm::register_dev(unsigned int dev_id, remoteport_tlm_dev *dev)
@@ -330,43 +389,143 @@ void remoteport_tlm::register_dev(unsigned int dev_id, remoteport_tlm_dev *dev)
 	dev->dev_id = dev_id;
 }
 
-unsigned int remoteport_tlm_dev::response_lookup(uint32_t id)
+remoteport_tlm_resp_table::remoteport_tlm_resp_table(unsigned int depth)
+	: nr_used(0),
+	  peak_used(0),
+	  free_head(RP_RESP_NONE)
+{
+	reserve(depth);
+}
+
+remoteport_tlm_resp_table::~remoteport_tlm_resp_table(void)
 {
 	unsigned int i;
-	unsigned int ret = ~0;
 
-	// Find a response slot waiting for id.
-	for (i = 0; i < (sizeof resp / sizeof resp[0]); i++) {
-		if (resp[i].used && resp[i].id == id) {
-			ret = i;
-			break;
+	for (i = 0; i < slots.size(); i++) {
+		delete slots[i];
+	}
+}
+
+void remoteport_tlm_resp_table::reserve(unsigned int depth)
+{
+	unsigned int nr_buckets;
+
+	while (slots.size() < depth) {
+		remoteport_tlm_resp_slot *s = new remoteport_tlm_resp_slot;
+
+		s->pkt = NULL;
+		s->id = 0;
+		s->used = false;
+		s->valid = false;
+		s->async = false;
+		s->opaque = NULL;
+		s->next = free_head;
+		free_head = slots.size();
+		slots.push_back(s);
+	}
+
+	// Keep at least one bucket per slot so chains stay short.
+	nr_buckets = buckets.size() ? buckets.size() : 1;
+	while (nr_buckets < slots.size()) {
+		nr_buckets *= 2;
+	}
+	if (nr_buckets != buckets.size()) {
+		rehash(nr_buckets);
+	}
+}
+
+void remoteport_tlm_resp_table::insert(unsigned int i)
+{
+	unsigned int b = slots[i]->id & (buckets.size() - 1);
+
+	slots[i]->next = buckets[b];
+	buckets[b] = i;
+}
+
+void remoteport_tlm_resp_table::rehash(unsigned int nr_buckets)
+{
+	unsigned int i;
+
+	buckets.assign(nr_buckets, RP_RESP_NONE);
+	for (i = 0; i < slots.size(); i++) {
+		if (slots[i]->used) {
+			insert(i);
 		}
 	}
-	return ret;
 }
 
-unsigned int remoteport_tlm_dev::response_wait(uint32_t id)
+unsigned int remoteport_tlm_resp_table::alloc(uint32_t id)
+{
+	unsigned int i;
+
+	if (free_head == RP_RESP_NONE) {
+		// More outstanding transactions than ever before.
+		reserve(slots.size() ? slots.size() * 2 : 1);
+	}
+
+	i = free_head;
+	free_head = slots[i]->next;
+
+	slots[i]->id = id;
+	slots[i]->used = true;
+	slots[i]->valid = false;
+	insert(i);
+
+	nr_used++;
+	if (nr_used > peak_used) {
+		peak_used = nr_used;
+	}
+	return i;
+}
+
+unsigned int remoteport_tlm_resp_table::lookup(uint32_t id)
 {
 	unsigned int i;
 
-	// Find a free response slot.
-	for (i = 0; i < (sizeof resp / sizeof resp[0]); i++) {
-		if (!resp[i].used)
+	for (i = buckets[id & (buckets.size() - 1)];
+	     i != RP_RESP_NONE; i = slots[i]->next) {
+		if (slots[i]->id == id) {
 			break;
+		}
 	}
+	return i;
+}
+
+void remoteport_tlm_resp_table::free(unsigned int i)
+{
+	unsigned int *p = &buckets[slots[i]->id & (buckets.size() - 1)];
 
-	if (i >= (sizeof resp / sizeof resp[0])) {
-	// If not OK, we ran out of outstanding response space.
-	// Increase RP_MAX_OUTSTANDING_TRANSACTIONS in remote-port-tlm.h
-		printf("Outstanding transactions overrun!\n");
-		printf("Increase RP_MAX_OUTSTANDING_TRANSACTIONS in remote-port-tlm.h\n");
-		assert(i < (sizeof resp / sizeof resp[0]));
+	// Unlink from the bucket chain.
+	while (*p != i) {
+		assert(*p != RP_RESP_NONE);
+		p = &slots[*p]->next;
 	}
+	*p = slots[i]->next;
+
+	slots[i]->pkt = NULL;
+	slots[i]->used = false;
+	slots[i]->valid = false;
+	slots[i]->async = false;
+	slots[i]->opaque = NULL;
+	slots[i]->next = free_head;
+	free_head = i;
+	nr_used--;
+}
 
-	// Now, wait for the reponse.
-	resp[i].id = id;
-	resp[i].used = true;
+unsigned int remoteport_tlm_dev::response_lookup(uint32_t id)
+{
+	// Find a response slot waiting for id.
+	return resp.lookup(id);
+}
+
+unsigned int remoteport_tlm_dev::response_wait(uint32_t id)
+{
+	unsigned int i;
+
+	// Take a response slot, the table grows if needed.
+	i = resp.alloc(id);
 
+	// Now, wait for the reponse.
 	do {
 		// We only want the remote-port thread to be
 		// processing RP packets. If the RP thread is
@@ -386,10 +545,21 @@ unsigned int remoteport_tlm_dev::response_wait(uint32_t id)
 	return i;
 }
 
+unsigned int remoteport_tlm_dev::response_async(uint32_t id, void *opaque)
+{
+	unsigned int i;
+
+	i = resp.alloc(id);
+	resp[i].async = true;
+	resp[i].opaque = opaque;
+	return i;
+}
+
 void remoteport_tlm_dev::response_done(unsigned int index)
 {
-	resp[index].valid = false;
-	resp[index].used = false;
+	// Give the packet back to the adaptor's pool.
+	adaptor->pkt_pool.put(resp[index].pkt);
+	resp.free(index);
 }
 
 int64_t remoteport_tlm::rp_map_time(sc_time t)
@@ -412,7 +582,22 @@ ssize_t remoteport_tlm::rp_read(void *rbuf, size_t count)
 {
 	ssize_t r;
 
-	r = rp_safe_read(fd, rbuf, count);
+	if (!blocking_socket) {
+		unsigned char *buf = (unsigned char *) rbuf;
+		size_t rlen = 0;
+
+		// rp_pkt_thread fills the receive ring for us and
+		// notifies once the packet is complete.
+		while (true) {
+			rlen += rp_io_read_nb(&io, buf + rlen, count - rlen);
+			if (rlen == count)
+				break;
+			wait(rp_pkt_event);
+		}
+		return rlen;
+	}
+
+	r = rp_io_read(&io, rbuf, count);
 	if (r < (ssize_t)count) {
 		if (r < 0)
 			perror(__func__);
@@ -425,12 +610,33 @@ ssize_t remoteport_tlm::rp_write(const void *wbuf, size_t count)
 {
 	ssize_t r;
 
-	r = rp_safe_write(fd, wbuf, count);
+	r = rp_io_write(&io, wbuf, count);
+	if (r < (ssize_t)count) {
+		if (r < 0)
+			perror(__func__);
+		exit(EXIT_FAILURE);
+	}
+	io.stats.tx_pkts++;
+	return r;
+}
+
+ssize_t remoteport_tlm::rp_writev(const struct iovec *iov, int iovcnt)
+{
+	size_t count = 0;
+	ssize_t r;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		count += iov[i].iov_len;
+	}
+
+	r = rp_io_writev(&io, iov, iovcnt);
 	if (r < (ssize_t)count) {
 		if (r < 0)
 			perror(__func__);
 		exit(EXIT_FAILURE);
 	}
+	io.stats.tx_pkts++;
 	return r;
 }
 
@@ -458,15 +664,20 @@ void remoteport_tlm::rp_say_hello(void)
 	uint32_t caps[] = {
 		CAP_BUSACCESS_EXT_BASE,
 		CAP_WIRE_POSTED_UPDATES,
+		CAP_MEMORY_MAP,
 	};
 	struct rp_pkt_hello pkt = {0};
+	struct iovec iov[2];
 	size_t len;
 
 	len = rp_encode_hello_caps(rp_pkt_id++, 0,
 				   &pkt, RP_VERSION_MAJOR, RP_VERSION_MINOR,
 				   caps, caps, sizeof caps / sizeof caps[0]);
-	rp_write(&pkt, len);
-	rp_write(caps, sizeof caps);
+	iov[0].iov_base = &pkt;
+	iov[0].iov_len = len;
+	iov[1].iov_base = caps;
+	iov[1].iov_len = sizeof caps;
+	rp_writev(iov, 2);
 }
 
 void remoteport_tlm::rp_cmd_sync(struct rp_pkt &pkt, bool can_sync)
@@ -491,6 +702,35 @@ void remoteport_tlm_dev::cmd_interrupt(struct rp_pkt &pkt, bool can_sync)
 	remoteport_tlm_wires::cmd_interrupt_null(adaptor, pkt, can_sync, NULL);
 }
 
+void remoteport_tlm_dev::cmd_map(struct rp_pkt &pkt, bool can_sync)
+{
+	struct rp_pkt_map pkt_tx;
+	size_t plen;
+	int64_t clk;
+
+	// An empty region without a path, i.e no direct access.
+	clk = adaptor->rp_map_time(adaptor->sync->get_current_time());
+	plen = rp_encode_map_resp(pkt.hdr.id, pkt.hdr.dev, &pkt_tx, clk,
+				  0, pkt.map.addr, 0, 0, 0);
+	adaptor->rp_write(&pkt_tx, plen);
+}
+
+void remoteport_tlm_dev::cmd_unmap(struct rp_pkt &pkt, bool can_sync)
+{
+	struct rp_pkt_map pkt_tx;
+	size_t plen;
+	int64_t clk;
+
+	if (pkt.hdr.flags & RP_PKT_FLAGS_posted) {
+		return;
+	}
+
+	clk = adaptor->rp_map_time(adaptor->sync->get_current_time());
+	plen = rp_encode_unmap_resp(pkt.hdr.id, pkt.hdr.dev, &pkt_tx, clk,
+				    pkt.map.addr, pkt.map.len);
+	adaptor->rp_write(&pkt_tx, plen);
+}
+
 void remoteport_tlm_dev::cmd_write(struct rp_pkt &pkt, bool can_sync,
 					unsigned char *data, size_t len)
 {
@@ -506,88 +746,102 @@ void remoteport_tlm_dev::cmd_read(struct rp_pkt &pkt, bool can_sync)
 
 bool remoteport_tlm::rp_process(bool can_sync)
 {
-	remoteport_packet pkt_rx;
+	remoteport_packet *pkt_rx;
 	ssize_t r;
 
-	pkt_rx.alloc(sizeof(pkt_rx.pkt->hdr) + 128);
 	while (1) {
 		remoteport_tlm_dev *dev;
 		unsigned char *data;
 		uint32_t dlen;
 		size_t datalen;
 
-		if (!blocking_socket)
-			wait(rp_pkt_event);
+		// rp_process may recurse through response_wait() while
+		// a packet is being handled, so every packet in flight
+		// needs its own buffer from the pool.
+		pkt_rx = pkt_pool.get();
 
-		pthread_mutex_lock(&rp_pkt_mutex);
-		r = rp_read(&pkt_rx.pkt->hdr, sizeof pkt_rx.pkt->hdr);
+		r = rp_read(&pkt_rx->pkt->hdr, sizeof pkt_rx->pkt->hdr);
 		if (r < 0)
 			perror(__func__);
 
-		rp_decode_hdr(pkt_rx.pkt);
+		rp_decode_hdr(pkt_rx->pkt);
 
-		pkt_rx.alloc(sizeof pkt_rx.pkt->hdr + pkt_rx.pkt->hdr.len);
-		r = rp_read(&pkt_rx.pkt->hdr + 1, pkt_rx.pkt->hdr.len);
-		pthread_mutex_unlock(&rp_pkt_mutex);
+		pkt_rx->alloc(sizeof pkt_rx->pkt->hdr + pkt_rx->pkt->hdr.len);
+		r = rp_read(&pkt_rx->pkt->hdr + 1, pkt_rx->pkt->hdr.len);
+		io.stats.rx_pkts++;
 
-		dlen = rp_decode_payload(pkt_rx.pkt);
-		data = pkt_rx.u8 + sizeof pkt_rx.pkt->hdr + dlen;
-		datalen = pkt_rx.pkt->hdr.len - dlen;
+		dlen = rp_decode_payload(pkt_rx->pkt);
+		data = pkt_rx->u8 + sizeof pkt_rx->pkt->hdr + dlen;
+		datalen = pkt_rx->pkt->hdr.len - dlen;
 
-		dev = devs[pkt_rx.pkt->hdr.dev];
+		dev = devs[pkt_rx->pkt->hdr.dev];
 		if (!dev) {
 			dev = &dev_null;
 		}
 
-		if (pkt_rx.pkt->hdr.flags & RP_PKT_FLAGS_response) {
+		if (pkt_rx->pkt->hdr.flags & RP_PKT_FLAGS_response) {
 			unsigned int ri;
 
-			if (pkt_rx.pkt->hdr.flags & RP_PKT_FLAGS_posted) {
+			if (pkt_rx->pkt->hdr.flags & RP_PKT_FLAGS_posted) {
 				// Drop responses for posted packets.
+				pkt_pool.put(pkt_rx);
 				return true;
 			}
-			sync->pre_any_cmd(&pkt_rx, can_sync);
+			sync->pre_any_cmd(pkt_rx, can_sync);
 
-			pkt_rx.data_offset = sizeof pkt_rx.pkt->hdr + dlen;
+			pkt_rx->data_offset = sizeof pkt_rx->pkt->hdr + dlen;
 
-			ri = dev->response_lookup(pkt_rx.pkt->hdr.id);
-			if (ri == ~0U) {
+			ri = dev->response_lookup(pkt_rx->pkt->hdr.id);
+			if (ri == RP_RESP_NONE) {
 				printf("unhandled response: id=%d dev=%d\n",
-					pkt_rx.pkt->hdr.id,
-					pkt_rx.pkt->hdr.dev);
-				assert(ri != ~0U);
+					pkt_rx->pkt->hdr.id,
+					pkt_rx->pkt->hdr.dev);
+				assert(ri != RP_RESP_NONE);
 			}
 
-			pkt_rx.copy(dev->resp[ri].pkt);
+			// Hand the packet over to the waiter, it will be
+			// given back to the pool in response_done().
+			dev->resp[ri].pkt = pkt_rx;
 			dev->resp[ri].valid = true;
-			dev->resp[ri].ev.notify();
-			sync->post_any_cmd(&pkt_rx, can_sync);
+			if (dev->resp[ri].async) {
+				dev->response_complete(ri);
+			} else {
+				dev->resp[ri].ev.notify();
+			}
+			sync->post_any_cmd(pkt_rx, can_sync);
 			return true;
 		}
 
-//		printf("%s: cmd=%d dev=%d\n", __func__, pkt_rx.pkt->hdr.cmd, pkt_rx.pkt->hdr.dev);
-		sync->pre_any_cmd(&pkt_rx, can_sync);
-		switch (pkt_rx.pkt->hdr.cmd) {
+//		printf("%s: cmd=%d dev=%d\n", __func__, pkt_rx->pkt->hdr.cmd, pkt_rx->pkt->hdr.dev);
+		sync->pre_any_cmd(pkt_rx, can_sync);
+		switch (pkt_rx->pkt->hdr.cmd) {
 		case RP_CMD_hello:
-			rp_cmd_hello(*pkt_rx.pkt);
+			rp_cmd_hello(*pkt_rx->pkt);
 			break;
 		case RP_CMD_write:
-			dev->cmd_write(*pkt_rx.pkt, can_sync, data, datalen);
+			dev->cmd_write(*pkt_rx->pkt, can_sync, data, datalen);
 			break;
 		case RP_CMD_read:
-			dev->cmd_read(*pkt_rx.pkt, can_sync);
+			dev->cmd_read(*pkt_rx->pkt, can_sync);
 			break;
 		case RP_CMD_interrupt:
-			dev->cmd_interrupt(*pkt_rx.pkt, can_sync);
+			dev->cmd_interrupt(*pkt_rx->pkt, can_sync);
 			break;
 		case RP_CMD_sync:
-                        rp_cmd_sync(*pkt_rx.pkt, can_sync);
+                        rp_cmd_sync(*pkt_rx->pkt, can_sync);
+			break;
+		case RP_CMD_map:
+			dev->cmd_map(*pkt_rx->pkt, can_sync);
+			break;
+		case RP_CMD_unmap:
+			dev->cmd_unmap(*pkt_rx->pkt, can_sync);
 			break;
 		default:
 			assert(0);
 			break;
 		}
-		sync->post_any_cmd(&pkt_rx, can_sync);
+		sync->post_any_cmd(pkt_rx, can_sync);
+		pkt_pool.put(pkt_rx);
 	}
 	return false;
 }
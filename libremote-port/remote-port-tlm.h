@@ -25,10 +25,12 @@
 #ifndef REMOTE_PORT_TLM
 #define REMOTE_PORT_TLM
 
+#include <vector>
 #include "utils/async_event.h"
 
 extern "C" {
 #include "remote-port-proto.h"
+#include "remote-port-io.h"
 };
 
 class remoteport_packet {
@@ -50,32 +52,104 @@ public:
 	void copy(class remoteport_packet &pkt);
 };
 
+// Pool of received packets.
+//
+// The receive path takes a packet from the pool, reads and decodes the
+// wire data in place and either returns it when done or hands it over
+// to a response slot. Packets keep their buffers while in the pool, so
+// once the pool has warmed up, receiving does no memory allocation.
+#define RP_PKT_POOL_SIZE 16
+class remoteport_packet_pool {
+public:
+	remoteport_packet_pool(void);
+	~remoteport_packet_pool(void);
+
+	remoteport_packet *get(void);
+	void put(remoteport_packet *pkt);
+
+	// Number of packets ever allocated by the pool.
+	unsigned int nr_allocated;
+private:
+	std::vector<remoteport_packet *> free_pkts;
+};
+
 class remoteport_tlm;
 
+// Default number of preallocated response slots per device.
+// The response table grows beyond this on demand.
 #define RP_MAX_OUTSTANDING_TRANSACTIONS 256
+
+struct remoteport_tlm_resp_slot {
+	// Points to a packet owned by the adaptor's packet pool and
+	// is only valid between response_wait() and response_done().
+	remoteport_packet *pkt;
+	sc_event ev;
+	uint32_t id;
+	bool used;
+	bool valid;
+	// Set for slots taken with response_async(). opaque is
+	// for the device to use.
+	bool async;
+	void *opaque;
+	// Next slot in the same hash bucket or on the free list.
+	unsigned int next;
+};
+
+// Response slots for handling multiple outstanding transactions.
+//
+// Slots are found by remote-port packet ID through a hash table
+// with id modulo a power-of-2 number of buckets. Unused slots sit
+// on a free list. Slots never move once allocated, so processes
+// can wait on a slot's event while the table grows.
+#define RP_RESP_NONE (~0U)
+class remoteport_tlm_resp_table
+{
+public:
+	remoteport_tlm_resp_table(unsigned int depth);
+	~remoteport_tlm_resp_table(void);
+
+	remoteport_tlm_resp_slot &operator[](unsigned int i) {
+		return *slots[i];
+	}
+
+	// Take a free slot for id. Returns the slot index.
+	unsigned int alloc(uint32_t id);
+	// Returns the index of the slot allocated for id or RP_RESP_NONE.
+	unsigned int lookup(uint32_t id);
+	void free(unsigned int i);
+	// Make sure at least depth slots are allocated.
+	void reserve(unsigned int depth);
+
+	unsigned int nr_slots(void) { return slots.size(); }
+	// Number of slots in use and the highest it has been.
+	unsigned int nr_used;
+	unsigned int peak_used;
+private:
+	std::vector<remoteport_tlm_resp_slot *> slots;
+	std::vector<unsigned int> buckets;
+	unsigned int free_head;
+
+	void insert(unsigned int i);
+	void rehash(unsigned int nr_buckets);
+};
+
 class remoteport_tlm_dev
 {
 public:
 	unsigned int dev_id;
 	remoteport_tlm *adaptor;
 
-	// Response slots to handling multiple outstanding transactions.
-	struct {
-		remoteport_packet pkt;
-		sc_event ev;
-		uint32_t id;
-		bool used;
-		bool valid;
-	} resp[RP_MAX_OUTSTANDING_TRANSACTIONS];
-
-	remoteport_tlm_dev(void) {
-		unsigned int i;
-
-		for (i = 0; i < sizeof resp / sizeof resp[0]; i++) {
-			resp[i].used = false;
-			resp[i].id = 0;
-			resp[i].valid = false;
-		}
+	remoteport_tlm_resp_table resp;
+
+	remoteport_tlm_dev(void) :
+		resp(RP_MAX_OUTSTANDING_TRANSACTIONS)
+	{
+	}
+
+	// Preallocate response slots for depth outstanding
+	// transactions. More are allocated on demand.
+	void set_outstanding_depth(unsigned int depth) {
+		resp.reserve(depth);
 	}
 
 	// Used to lookup a response slot that is currently
@@ -87,14 +161,24 @@ public:
 	// An index into resp[] will be returned.
 	unsigned int response_wait(uint32_t id);
 
+	// Like response_wait() but doesn't block. Instead,
+	// response_complete() is called from the remote-port thread
+	// once the response has arrived.
+	unsigned int response_async(uint32_t id, void *opaque);
+	virtual void response_complete(unsigned int resp_idx) {}
+
 	// Called by devices when they no longer need the
-	// response slot returned by response_wait().
+	// response slot returned by response_wait() or response_async().
 	void response_done(unsigned int resp_idx);
 
 	virtual void cmd_write(struct rp_pkt &pkt, bool can_sync,
 			       unsigned char *data, size_t len);
 	virtual void cmd_read(struct rp_pkt &pkt, bool can_sync);
 	virtual void cmd_interrupt(struct rp_pkt &pkt, bool can_sync);
+	// Memory mapping requests from the peer. By default, nothing
+	// can be mapped and unmaps are acknowledged.
+	virtual void cmd_map(struct rp_pkt &pkt, bool can_sync);
+	virtual void cmd_unmap(struct rp_pkt &pkt, bool can_sync);
 	virtual void tie_off(void) {} ;
 };
 
@@ -153,6 +237,7 @@ public:
 			const char *sk_descr,
 			Iremoteport_tlm_sync *sync = NULL,
 			bool blocking_socket = true);
+	~remoteport_tlm();
 
 	void register_dev(unsigned int dev_id, remoteport_tlm_dev *dev);
 	virtual void tie_off(void);
@@ -165,12 +250,20 @@ public:
 	bool rp_process(bool sync);
 	ssize_t rp_read(void *rbuf, size_t count);
 	ssize_t rp_write(const void *wbuf, size_t count);
+	// Writes a packet made up of several buffers in one go.
+	ssize_t rp_writev(const struct iovec *iov, int iovcnt);
+	// Syscall and packet counters of the transport.
+	const struct rp_io_stats &io_stats(void) { return io.stats; }
 	int64_t rp_map_time(sc_time t);
 	void account_time(int64_t rp_time_ns);
 	// Returns true if the current SC_THREAD is the remote-port
 	// thread for this adaptor.
 	bool current_process_is_adaptor(void);
 
+	// Received packets. Devices give packets handed to them
+	// through response slots back via response_done().
+	remoteport_packet_pool pkt_pool;
+
 	void rp_pkt_main(void);
 private:
 	remoteport_tlm_dev *devs[RP_MAX_DEVS];
@@ -178,14 +271,17 @@ private:
 	unsigned char *pktbuf_data;
 	/* Socket.  */
 	int fd;
+	struct rp_io io;
 	remoteport_tlm_dev dev_null;
 	bool blocking_socket;
 
 	sc_process_handle adaptor_proc;
 
+	// Non-blocking mode. rp_pkt_thread keeps the receive ring
+	// filled and notifies rp_pkt_event once per batch of packets.
 	async_event rp_pkt_event;
 	pthread_t rp_pkt_thread;
-	pthread_mutex_t rp_pkt_mutex;
+	static void rp_pkt_notify(void *opaque);
 
 	void rp_say_hello(void);
 	void rp_cmd_hello(struct rp_pkt &pkt);
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "traffic-generators/tg-tlm.h"
+#include "checkers/pc-axi.h"
+#include "checkers/config-axi.h"
+#include "test-modules/memory.h"
+#include "test-modules/signals-axi.h"
+#include "siggen-axi.h"
+
+#ifdef __AXI_VERSION_AXI3__
+static const AXIVersion version = V_AXI3;
+#else
+static const AXIVersion version = V_AXI4;
+#endif
+
+#define AXI_ADDR_WIDTH 32
+#define AXI_DATA_WIDTH 32
+
+//
+// The checker's config, changed by the testcases at runtime
+//
+static AXIPCConfig *pc_cfg;
+
+SIGGEN_TESTSUITE(TestSuite)
+{
+	SIGGEN_TESTSUITE_CTOR(TestSuite)
+	{}
+
+	void run_tests()
+	{
+		wait(clk.posedge_event());
+
+		//
+		// Write transaction checks enabled / disabled at runtime
+		//
+		m_s->SetMessageType(WR_TX_ERROR);
+
+		TESTCASE(test_wr_tx_check_off);
+		TESTCASE_NEG(test_wr_tx_check_enabled);
+		TESTCASE(test_wr_tx_check_disabled);
+		TESTCASE(test_wr_tx_check_enabled_during_write);
+		TESTCASE_NEG(test_wr_tx_check_after_enabled_during_write);
+
+		//
+		// Stable signals check enabled / disabled at runtime and
+		// back-to-back valid bursts
+		//
+		m_s->SetMessageType(CHECKER_AXI_ERROR);
+
+		TESTCASE(test_stable_check_off);
+		TESTCASE_NEG(test_stable_check_enabled);
+		TESTCASE(test_stable_back_to_back);
+		TESTCASE_NEG(test_stable_back_to_back_toggle_araddr);
+		TESTCASE(test_stable_restarted_by_reset);
+		TESTCASE(test_stable_check_disabled);
+
+		//
+		// The clock edge releasing reset
+		//
+		m_s->SetMessageType(AXI_RESET_ERROR);
+
+		TESTCASE(test_valid_after_reset_release_edge);
+		TESTCASE_NEG(test_valid_at_reset_release_edge);
+	}
+
+	//
+	// A single beat write of one byte at address 0, wstrb 0xf enables
+	// bytes outside the transfer.
+	//
+	void write_tx(unsigned int strb)
+	{
+		awaddr.write(0);
+		awsize.write(0);
+		awlen.write(0);
+		awvalid.write(true);
+		awready.write(true);
+
+		wait(clk.posedge_event());
+
+		awvalid.write(false);
+		awready.write(false);
+
+		wdata.write(0);
+		wstrb.write(strb);
+		wlast.write(true);
+		wvalid.write(true);
+		wready.write(true);
+
+		wait(clk.posedge_event());
+
+		wvalid.write(false);
+		wready.write(false);
+		wlast.write(false);
+
+		bvalid.write(true);
+		bready.write(true);
+
+		wait(clk.posedge_event());
+
+		bvalid.write(false);
+		bready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void set_wr_tx_check(bool en)
+	{
+		pc_cfg->check_wr_tx_data_wstrb(false, en);
+
+		// Takes effect at the next clock edge
+		wait(clk.posedge_event());
+		wait(clk.posedge_event());
+	}
+
+	void test_wr_tx_check_off()
+	{
+		write_tx(0xf);
+	}
+
+	void test_wr_tx_check_enabled()
+	{
+		set_wr_tx_check(true);
+
+		write_tx(0x1);
+		write_tx(0xf);
+	}
+
+	void test_wr_tx_check_disabled()
+	{
+		set_wr_tx_check(false);
+
+		write_tx(0xf);
+	}
+
+	//
+	// The check is enabled after the aw handshake, the write is not
+	// checked since tracking starts at an edge without outstanding
+	// writes.
+	//
+	void test_wr_tx_check_enabled_during_write()
+	{
+		awaddr.write(0);
+		awsize.write(0);
+		awlen.write(0);
+		awvalid.write(true);
+		awready.write(true);
+
+		wait(clk.posedge_event());
+
+		awvalid.write(false);
+		awready.write(false);
+
+		wait(clk.posedge_event());
+
+		pc_cfg->check_wr_tx_data_wstrb(false, true);
+
+		wstrb.write(0xf);
+		wlast.write(true);
+		wvalid.write(true);
+		wready.write(true);
+
+		wait(clk.posedge_event());
+
+		wvalid.write(false);
+		wready.write(false);
+		wlast.write(false);
+
+		bvalid.write(true);
+		bready.write(true);
+
+		wait(clk.posedge_event());
+
+		bvalid.write(false);
+		bready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void test_wr_tx_check_after_enabled_during_write()
+	{
+		write_tx(0xf);
+
+		set_wr_tx_check(false);
+	}
+
+	void set_stable_check(bool en)
+	{
+		pc_cfg->check_stable_data_resp_signal(en);
+
+		// Takes effect at the next clock edge
+		wait(clk.posedge_event());
+		wait(clk.posedge_event());
+	}
+
+	//
+	// araddr changes while arvalid is asserted and arready isn't
+	//
+	void toggle_araddr()
+	{
+		araddr.write(0x0);
+		arvalid.write(true);
+
+		wait(clk.posedge_event());
+
+		araddr.write(0x1);
+		arready.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void test_stable_check_off()
+	{
+		toggle_araddr();
+	}
+
+	void test_stable_check_enabled()
+	{
+		set_stable_check(true);
+
+		toggle_araddr();
+	}
+
+	//
+	// Two bursts, both waiting one cycle for arready, with arvalid kept
+	// asserted in between. The second burst's signals are sampled after
+	// the first burst's handshake.
+	//
+	void stable_back_to_back(unsigned int addr)
+	{
+		araddr.write(0x0);
+		arvalid.write(true);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+
+		arready.write(true);
+
+		wait(clk.posedge_event());
+
+		araddr.write(0x4);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+
+		araddr.write(addr);
+		arready.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void test_stable_back_to_back()
+	{
+		stable_back_to_back(0x4);
+
+		//
+		// Handshakes at consecutive edges with changing signals
+		//
+		araddr.write(0x0);
+		arvalid.write(true);
+		arready.write(true);
+
+		wait(clk.posedge_event());
+
+		araddr.write(0x4);
+
+		wait(clk.posedge_event());
+
+		araddr.write(0x8);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void test_stable_back_to_back_toggle_araddr()
+	{
+		stable_back_to_back(0x8);
+	}
+
+	//
+	// A burst waiting for arready when reset is asserted is forgotten,
+	// the burst after reset is sampled anew.
+	//
+	void test_stable_restarted_by_reset()
+	{
+		araddr.write(0x0);
+		arvalid.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+		resetn.write(false);
+
+		wait(clk.posedge_event());
+
+		araddr.write(0x4);
+		resetn.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(true);
+
+		wait(clk.posedge_event());
+
+		arready.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void test_stable_check_disabled()
+	{
+		set_stable_check(false);
+
+		toggle_araddr();
+	}
+
+	//
+	// Valid can be asserted at the edge after the one releasing reset
+	//
+	void test_valid_after_reset_release_edge()
+	{
+		resetn.write(false);
+
+		wait(clk.posedge_event());
+
+		resetn.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(true);
+		arready.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+		arready.write(false);
+
+		wait(clk.posedge_event());
+	}
+
+	void test_valid_at_reset_release_edge()
+	{
+		resetn.write(false);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(true);
+		resetn.write(true);
+
+		wait(clk.posedge_event());
+
+		arvalid.write(false);
+
+		wait(clk.posedge_event());
+	}
+};
+
+SIGGEN_RUN(TestSuite)
+
+AXIPCConfig checker_config()
+{
+	AXIPCConfig cfg;
+
+	cfg.check_axi_responses(false);
+	cfg.check_axi_reset(true);
+
+	return cfg;
+}
+
+int sc_main(int argc, char *argv[])
+{
+	AXIProtocolChecker<AXI_ADDR_WIDTH, AXI_DATA_WIDTH>
+			checker("checker", checker_config());
+
+	AXISignals<AXI_ADDR_WIDTH, AXI_DATA_WIDTH>
+			signals("axi-signals", version);
+
+	SignalGen<AXI_ADDR_WIDTH, AXI_DATA_WIDTH>
+			siggen("sig-gen", version);
+
+	sc_clock clk("clk", sc_time(20, SC_US));
+	sc_signal<bool> resetn("resetn", true);
+
+	pc_cfg = &checker.Config();
+
+	// Connect clk
+	checker.clk(clk);
+	siggen.clk(clk);
+
+	// Connect reset
+	checker.resetn(resetn);
+	siggen.resetn(resetn);
+
+	// Connect signals
+	signals.connect(checker);
+	signals.connect(siggen);
+
+	sc_trace_file *trace_fp = sc_create_vcd_trace_file(argv[0]);
+
+	sc_trace(trace_fp, siggen.clk, siggen.clk.name());
+	sc_trace(trace_fp, siggen.resetn, siggen.resetn.name());
+	signals.Trace(trace_fp);
+
+	// Run
+	sc_start(100, SC_MS);
+
+	sc_stop();
+
+	if (trace_fp) {
+		sc_close_vcd_trace_file(trace_fp);
+	}
+
+	return 0;
+}
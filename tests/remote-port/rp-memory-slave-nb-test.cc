@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+extern "C" {
+#include "safeio.h"
+#include "remote-port-proto.h"
+#include "remote-port-sk.h"
+};
+#include "remote-port-tlm.h"
+#include "remote-port-tlm-memory-master.h"
+#include "remote-port-tlm-memory-slave.h"
+
+#include "test-modules/memory.h"
+
+#define NR_TXNS 4
+
+//
+// Counts the transactions given back
+//
+class test_mm : public tlm::tlm_mm_interface
+{
+public:
+	test_mm() : nr_free(0) {}
+
+	void free(tlm::tlm_generic_payload *gp) { nr_free++; }
+
+	unsigned int nr_free;
+};
+
+//
+// Non-blocking initiator -> memory slave (adaptor rp-a) -> socketpair ->
+// memory master (adaptor rp-b) -> memory
+//
+SC_MODULE(Dut)
+{
+public:
+	enum { RamSize = 64 * 1024 };
+
+	SC_HAS_PROCESS(Dut);
+
+	Dut(sc_module_name name, int *fds) :
+		done(false),
+		rp_a("rp-a", fds[0], NULL, remoteport_tlm_sync_untimed_ptr,
+			false),
+		rp_b("rp-b", fds[1], NULL, remoteport_tlm_sync_untimed_ptr,
+			false),
+		slave("memory-slave"),
+		master("memory-master"),
+		ram("ram", sc_time(10, SC_NS), RamSize),
+		rst("rst"),
+		nr_resp(0)
+	{
+		unsigned int i;
+
+		rp_a.rst(rst);
+		rp_b.rst(rst);
+
+		rp_a.register_dev(1, &slave);
+		rp_b.register_dev(1, &master);
+
+		init_socket.register_nb_transport_bw(this,
+						&Dut::nb_transport_bw);
+		init_socket.bind(slave.sk);
+		master.sk.bind(ram.socket);
+
+		for (i = 0; i < NR_TXNS; i++) {
+			gp[i].set_mm(&mm);
+		}
+
+		SC_THREAD(test_thread);
+	}
+
+	bool done;
+
+private:
+	remoteport_tlm rp_a;
+	remoteport_tlm rp_b;
+	remoteport_tlm_memory_slave slave;
+	remoteport_tlm_memory_master master;
+	memory ram;
+	sc_signal<bool> rst;
+
+	tlm_utils::simple_initiator_socket<Dut> init_socket;
+
+	test_mm mm;
+	tlm::tlm_generic_payload gp[NR_TXNS];
+	unsigned char data[NR_TXNS][8];
+	sc_time req_time[NR_TXNS];
+
+	// Responses received and when (including the annotated delay)
+	std::vector<tlm::tlm_generic_payload *> resp;
+	std::vector<sc_time> resp_time;
+	unsigned int nr_resp;
+	sc_event resp_ev;
+
+	virtual tlm::tlm_sync_enum nb_transport_bw(
+				tlm::tlm_generic_payload& trans,
+				tlm::tlm_phase& phase,
+				sc_time& delay)
+	{
+		if (phase != tlm::BEGIN_RESP) {
+			SC_REPORT_ERROR("rp-memory-slave-nb-test",
+				"Unexpected phase on the backward path");
+			return tlm::TLM_COMPLETED;
+		}
+
+		resp.push_back(&trans);
+		resp_time.push_back(sc_time_stamp() + delay);
+		resp_ev.notify();
+
+		// END_RESP is sent from the test thread
+		return tlm::TLM_ACCEPTED;
+	}
+
+	void begin_req(unsigned int i, tlm::tlm_command cmd, uint64_t addr,
+			sc_time delay)
+	{
+		tlm::tlm_phase phase = tlm::BEGIN_REQ;
+		tlm::tlm_sync_enum r;
+
+		gp[i].acquire();
+		gp[i].set_command(cmd);
+		gp[i].set_address(addr);
+		gp[i].set_data_ptr(data[i]);
+		gp[i].set_data_length(sizeof(data[i]));
+		gp[i].set_streaming_width(sizeof(data[i]));
+		gp[i].set_byte_enable_ptr(NULL);
+		gp[i].set_byte_enable_length(0);
+		gp[i].set_dmi_allowed(false);
+		gp[i].set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+		req_time[i] = sc_time_stamp() + delay;
+
+		r = init_socket->nb_transport_fw(gp[i], phase, delay);
+		if (r != tlm::TLM_UPDATED || phase != tlm::END_REQ) {
+			SC_REPORT_ERROR("rp-memory-slave-nb-test",
+				"Request not accepted");
+		}
+
+		if (gp[i].get_ref_count() != 2) {
+			SC_REPORT_ERROR("rp-memory-slave-nb-test",
+				"Transaction not acquired by the slave");
+		}
+	}
+
+	//
+	// Waits for the responses of all transactions, one at a time, and
+	// completes them with END_RESP
+	//
+	void end_resp_all(void)
+	{
+		unsigned int nr_free = mm.nr_free;
+		unsigned int i;
+
+		while (nr_resp < NR_TXNS) {
+			tlm::tlm_phase phase = tlm::END_RESP;
+			sc_time delay(SC_ZERO_TIME);
+			tlm::tlm_generic_payload *trans;
+
+			while (resp.size() == nr_resp) {
+				wait(resp_ev);
+			}
+
+			if (resp.size() > nr_resp + 1) {
+				SC_REPORT_ERROR("rp-memory-slave-nb-test",
+					"BEGIN_RESP before END_RESP");
+			}
+
+			trans = resp[nr_resp];
+			i = trans - gp;
+
+			if (trans->get_response_status() !=
+				tlm::TLM_OK_RESPONSE) {
+				SC_REPORT_ERROR("rp-memory-slave-nb-test",
+					"Transaction failed");
+			}
+
+			if (resp_time[nr_resp] < req_time[i]) {
+				SC_REPORT_ERROR("rp-memory-slave-nb-test",
+					"Response before the request's delay");
+			}
+
+			if (!trans->is_dmi_allowed()) {
+				SC_REPORT_ERROR("rp-memory-slave-nb-test",
+					"DMI hint not set");
+			}
+
+			init_socket->nb_transport_fw(*trans, phase, delay);
+
+			if (trans->get_ref_count() != 1) {
+				SC_REPORT_ERROR("rp-memory-slave-nb-test",
+					"Transaction not released by the slave");
+			}
+
+			trans->release();
+			nr_resp++;
+		}
+
+		if (mm.nr_free - nr_free != NR_TXNS) {
+			SC_REPORT_ERROR("rp-memory-slave-nb-test",
+				"Transactions not given back");
+		}
+
+		resp.clear();
+		resp_time.clear();
+		nr_resp = 0;
+	}
+
+	void test_thread(void)
+	{
+		unsigned int i;
+		unsigned int j;
+
+		rst.write(true);
+		wait(1, SC_NS);
+		rst.write(false);
+
+		// Wait for the peer's hello
+		while (!rp_a.peer.caps.busaccess_ext_base) {
+			wait(1, SC_NS);
+		}
+
+		//
+		// All writes in flight at the same time, with growing
+		// annotated delays
+		//
+		for (i = 0; i < NR_TXNS; i++) {
+			for (j = 0; j < sizeof(data[i]); j++) {
+				data[i][j] = i * 0x10 + j;
+			}
+			begin_req(i, tlm::TLM_WRITE_COMMAND, i * 8,
+				sc_time(100 * (i + 1), SC_NS));
+		}
+		end_resp_all();
+
+		for (i = 0; i < NR_TXNS; i++) {
+			memset(data[i], 0, sizeof(data[i]));
+			begin_req(i, tlm::TLM_READ_COMMAND, i * 8,
+				sc_time(100, SC_NS));
+		}
+		end_resp_all();
+
+		for (i = 0; i < NR_TXNS; i++) {
+			for (j = 0; j < sizeof(data[i]); j++) {
+				if (data[i][j] != i * 0x10 + j) {
+					SC_REPORT_ERROR("rp-memory-slave-nb-test",
+						"Read data mismatch");
+				}
+			}
+		}
+
+		done = true;
+		sc_stop();
+	}
+};
+
+int sc_main(int argc, char *argv[])
+{
+	int fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+		perror("socketpair");
+		return EXIT_FAILURE;
+	}
+
+	Dut dut("dut", fds);
+
+	sc_start(100, SC_MS);
+
+	if (!dut.done) {
+		SC_REPORT_ERROR("rp-memory-slave-nb-test",
+			"Test did not complete");
+	}
+
+	return 0;
+}
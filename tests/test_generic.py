@@ -20,6 +20,14 @@ tlm_modules_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
 					"/tlm-modules/"), '*-test')
 tests_tlm_modules = ['./tlm-modules/{0}'.format(i) for i in tlm_modules_tests]
 
+remote_port_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
+					"/remote-port/"), '*-test')
+tests_remote_port = ['./remote-port/{0}'.format(i) for i in remote_port_tests]
+
+tlm_bridges_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
+					"/tlm-bridges/"), '*-test')
+tests_tlm_bridges = ['./tlm-bridges/{0}'.format(i) for i in tlm_bridges_tests]
+
 tg_axilite_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
 					"/traffic-generators/axilite/"), '*-tg-test')
 tests_tg_axilite = ['./traffic-generators/axilite/{0}'.format(i) for i in tg_axilite_tests]
@@ -51,6 +59,10 @@ tg_chi_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
 					"/traffic-generators/chi/"), '*-tg-test')
 tests_tg_chi = ['./traffic-generators/chi/{0}'.format(i) for i in tg_chi_tests]
 
+tg_tlm_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
+					"/traffic-generators/tlm/"), '*-tg-test')
+tests_tg_tlm = ['./traffic-generators/tlm/{0}'.format(i) for i in tg_tlm_tests]
+
 pc_chi_tests = fnmatch.filter(os.listdir(os.path.dirname(__file__) +
 					"/checkers/chi/"), '*-test')
 tests_pc_chi = ['./checkers/chi/{0}'.format(i) for i in pc_chi_tests]
@@ -96,6 +108,16 @@ def test_tlm_modules_tests(filename):
 	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
 	assert(subprocess.call([path_exe]) == 0)
 
+@pytest.mark.parametrize("filename", tests_remote_port)
+def test_remote_port_tests(filename):
+	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
+	assert(subprocess.call([path_exe]) == 0)
+
+@pytest.mark.parametrize("filename", tests_tlm_bridges)
+def test_tlm_bridges_tests(filename):
+	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
+	assert(subprocess.call([path_exe]) == 0)
+
 @pytest.mark.parametrize("filename", tests_tg_axilite)
 def test_tg_axilite_tests(filename):
 	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
@@ -140,6 +162,11 @@ def test_tg_chi_tests(filename):
 	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
 	assert(subprocess.call([path_exe]) == 0)
 
+@pytest.mark.parametrize("filename", tests_tg_tlm)
+def test_tg_tlm_tests(filename):
+	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
+	assert(subprocess.call([path_exe]) == 0)
+
 @pytest.mark.parametrize("filename", tests_pc_chi)
 def test_checker_chi_tests(filename):
 	path_exe = os.path.normpath(os.path.dirname(__file__) + '/' + filename)
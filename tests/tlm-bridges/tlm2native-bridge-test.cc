@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "tlm-bridges/tlm2native-bridge.h"
+
+#define PAGE_SIZE 4096
+
+SC_MODULE(Dut)
+{
+public:
+	// Not a multiple of the page size, the last page is partial
+	enum { MemSize = 5 * PAGE_SIZE + PAGE_SIZE / 2 };
+
+	SC_HAS_PROCESS(Dut);
+
+	Dut(sc_module_name name) :
+		done(false),
+		bridge("tlm2native-bridge", NULL, MemSize,
+			sc_time(10, SC_NS), true)
+	{
+		init_socket.bind(bridge.target_socket);
+
+		SC_THREAD(test_thread);
+	}
+
+	bool done;
+
+private:
+	tlm_utils::simple_initiator_socket<Dut> init_socket;
+	tlm2native_bridge bridge;
+
+	void access(tlm::tlm_command cmd, uint64_t addr, unsigned char *data,
+			unsigned int len, unsigned int streaming_width = 0,
+			unsigned char *be = NULL, unsigned int be_len = 0)
+	{
+		tlm::tlm_generic_payload gp;
+		sc_time delay(SC_ZERO_TIME);
+
+		gp.set_command(cmd);
+		gp.set_address(addr);
+		gp.set_data_ptr(data);
+		gp.set_data_length(len);
+		gp.set_streaming_width(streaming_width ? streaming_width : len);
+		gp.set_byte_enable_ptr(be);
+		gp.set_byte_enable_length(be_len);
+		gp.set_dmi_allowed(false);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+		init_socket->b_transport(gp, delay);
+
+		if (gp.get_response_status() != tlm::TLM_OK_RESPONSE) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"Access failed");
+		}
+		if (!gp.is_dmi_allowed()) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"DMI hint not set");
+		}
+	}
+
+	bool get_dmi(uint64_t addr, tlm::tlm_dmi& dmi)
+	{
+		tlm::tlm_generic_payload gp;
+
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		gp.set_address(addr);
+
+		return init_socket->get_direct_mem_ptr(gp, dmi);
+	}
+
+	void check(const unsigned char *data, const unsigned char *ref,
+			unsigned int len, const char *msg)
+	{
+		if (memcmp(data, ref, len)) {
+			SC_REPORT_ERROR("tlm2native-bridge-test", msg);
+		}
+	}
+
+	//
+	// Unwritten memory reads as zero, also on reads crossing into a
+	// written page.
+	//
+	void test_unwritten(void)
+	{
+		unsigned char data[64];
+		unsigned char zero[64];
+		unsigned char ones[8];
+
+		memset(zero, 0, sizeof(zero));
+		memset(ones, 0xff, sizeof(ones));
+
+		memset(data, 0xaa, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, 0x100, data, sizeof(data));
+		check(data, zero, sizeof(data), "Unwritten memory not zero");
+
+		access(tlm::TLM_WRITE_COMMAND, PAGE_SIZE, ones, sizeof(ones));
+
+		memset(data, 0xaa, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, PAGE_SIZE - 32, data,
+			sizeof(data));
+		check(data, zero, 32, "Unwritten page not zero");
+		check(data + 32, ones, sizeof(ones),
+			"Read across pages mismatch");
+		check(data + 40, zero, 24, "Rest of written page not zero");
+	}
+
+	//
+	// Writes allocate the pages they touch, including both pages of a
+	// write crossing a page boundary. Checked through the DMI pointers
+	// of the pages.
+	//
+	void test_write_alloc(void)
+	{
+		unsigned char data[16];
+		tlm::tlm_dmi dmi;
+		unsigned int i;
+
+		for (i = 0; i < sizeof(data); i++) {
+			data[i] = 0x10 + i;
+		}
+
+		access(tlm::TLM_WRITE_COMMAND, 3 * PAGE_SIZE - 8, data,
+			sizeof(data));
+
+		if (!get_dmi(3 * PAGE_SIZE - 8, dmi)) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"DMI refused");
+		}
+		check(dmi.get_dmi_ptr() + PAGE_SIZE - 8, data, 8,
+			"Write not in the first page");
+
+		if (!get_dmi(3 * PAGE_SIZE, dmi)) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"DMI refused");
+		}
+		check(dmi.get_dmi_ptr(), data + 8, 8,
+			"Write not in the second page");
+	}
+
+	//
+	// Byte enable patterns shorter than the data, with runs of 8 bytes
+	// (blended a word at a time) and a page boundary in the middle.
+	//
+	void test_byte_enables(void)
+	{
+		unsigned char be[] = { TLM_BYTE_ENABLED, TLM_BYTE_DISABLED,
+					TLM_BYTE_ENABLED };
+		uint64_t addr = 2 * PAGE_SIZE - 10;
+		unsigned char data[20];
+		unsigned char ref[20];
+		unsigned char old[20];
+		unsigned int i;
+
+		for (i = 0; i < sizeof(data); i++) {
+			old[i] = 0x80 + i;
+			data[i] = 0x40 + i;
+		}
+		access(tlm::TLM_WRITE_COMMAND, addr, old, sizeof(old));
+		access(tlm::TLM_WRITE_COMMAND, addr, data, sizeof(data),
+			0, be, sizeof(be));
+
+		for (i = 0; i < sizeof(ref); i++) {
+			ref[i] = be[i % sizeof(be)] == TLM_BYTE_ENABLED ?
+					data[i] : old[i];
+		}
+
+		memset(data, 0, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, addr, data, sizeof(data));
+		check(data, ref, sizeof(data), "Byte enabled write mismatch");
+
+		// Disabled bytes keep the initiator's data on reads
+		memset(data, 0xee, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, addr, data, sizeof(data),
+			0, be, sizeof(be));
+		for (i = 0; i < sizeof(ref); i++) {
+			if (be[i % sizeof(be)] != TLM_BYTE_ENABLED) {
+				ref[i] = 0xee;
+			}
+		}
+		check(data, ref, sizeof(data), "Byte enabled read mismatch");
+	}
+
+	//
+	// Every streaming width sized beat accesses the same addresses.
+	//
+	void test_streaming(void)
+	{
+		uint64_t addr = 4 * PAGE_SIZE - 2;
+		unsigned char data[16];
+		unsigned char ref[16];
+		unsigned int i;
+
+		for (i = 0; i < sizeof(data); i++) {
+			data[i] = 0x20 + i;
+		}
+
+		// Only the last beat remains
+		access(tlm::TLM_WRITE_COMMAND, addr, data, sizeof(data), 4);
+
+		memset(ref, 0, sizeof(ref));
+		access(tlm::TLM_READ_COMMAND, addr, ref, 4);
+		check(ref, data + 12, 4, "Streaming write mismatch");
+
+		for (i = 0; i < sizeof(ref); i++) {
+			ref[i] = data[12 + i % 4];
+		}
+
+		memset(data, 0, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, addr, data, sizeof(data), 4);
+		check(data, ref, sizeof(data), "Streaming read mismatch");
+	}
+
+	//
+	// DMI covers one page at a time, clipped to the memory size.
+	//
+	void test_dmi(void)
+	{
+		unsigned char data[4] = { 0x1, 0x2, 0x3, 0x4 };
+		unsigned char rd[4];
+		tlm::tlm_dmi dmi;
+
+		if (!get_dmi(4 * PAGE_SIZE + 0x10, dmi) ||
+			dmi.get_start_address() != 4 * PAGE_SIZE ||
+			dmi.get_end_address() != 5 * PAGE_SIZE - 1 ||
+			!dmi.is_read_write_allowed()) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"DMI range not a page");
+		}
+
+		// DMI and transactions share the backing store
+		memcpy(dmi.get_dmi_ptr() + 0x10, data, sizeof(data));
+		memset(rd, 0, sizeof(rd));
+		access(tlm::TLM_READ_COMMAND, 4 * PAGE_SIZE + 0x10, rd,
+			sizeof(rd));
+		check(rd, data, sizeof(rd), "DMI write not visible");
+
+		if (!get_dmi(MemSize - 1, dmi) ||
+			dmi.get_start_address() != 5 * PAGE_SIZE ||
+			dmi.get_end_address() != MemSize - 1) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"DMI range not clipped to the memory size");
+		}
+
+		if (get_dmi(MemSize, dmi)) {
+			SC_REPORT_ERROR("tlm2native-bridge-test",
+				"DMI granted outside the memory");
+		}
+	}
+
+	void test_thread(void)
+	{
+		test_unwritten();
+		test_write_alloc();
+		test_byte_enables();
+		test_streaming();
+		test_dmi();
+
+		done = true;
+	}
+};
+
+int sc_main(int argc, char *argv[])
+{
+	Dut dut("dut");
+
+	sc_start(100, SC_MS);
+	sc_stop();
+
+	if (!dut.done) {
+		SC_REPORT_ERROR("tlm2native-bridge-test",
+			"Test did not complete");
+	}
+
+	return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "tlm-extensions/genattr.h"
+#include "tlm-bridges/amba-ace.h"
+using namespace AMBA::ACE;
+
+#include "tlm-modules/cache-ace.h"
+#include "test-modules/memory.h"
+
+#define CACHE_SIZE 1024
+#define CACHELINE_SIZE 64
+#define NUM_WAYS 2
+
+// Addresses SET_STRIDE apart map to the same set
+#define SET_STRIDE (CACHE_SIZE / NUM_WAYS)
+
+typedef cache_ace<CACHE_SIZE, CACHELINE_SIZE, NUM_WAYS, ReplaceLRU> cache_t;
+
+//
+// Touch the victim of a set NUM_VICTIMS times and check the ways chosen
+//
+template<int POLICY>
+static void check_victim_order(const char *policy,
+				const unsigned int *expected,
+				unsigned int num_victims)
+{
+	CacheReplacement<2, 4, POLICY> r;
+	unsigned int i;
+
+	for (i = 0; i < num_victims; i++) {
+		unsigned int victim = r.GetVictim(1);
+
+		if (victim != expected[i] || r.GetVictim(1) != victim) {
+			std::ostringstream msg;
+
+			msg << policy << " victim " << i << " is way "
+				<< victim << ", expected " << expected[i];
+			SC_REPORT_ERROR("cache-ace-test", msg.str().c_str());
+		}
+
+		r.Touch(1, victim);
+	}
+
+	//
+	// Set 0 was never touched
+	//
+	if (POLICY != ReplaceRandom && r.GetVictim(0) != 0) {
+		std::ostringstream msg;
+
+		msg << policy << " touches leaked into another set";
+		SC_REPORT_ERROR("cache-ace-test", msg.str().c_str());
+	}
+}
+
+static void test_replacement()
+{
+	static const unsigned int lru[] = { 0, 1, 2, 3, 0, 1 };
+	static const unsigned int plru[] = { 0, 2, 1, 3, 0, 2 };
+	CacheReplacement<2, 4, ReplaceRandom> r0;
+	CacheReplacement<2, 4, ReplaceRandom> r1;
+	bool chosen[4] = { false, false, false, false };
+	CacheReplacement<1, 4, ReplaceLRU> r;
+	unsigned int i;
+
+	check_victim_order<ReplaceLRU>("LRU", lru, 6);
+	check_victim_order<ReplacePLRU>("PLRU", plru, 6);
+
+	//
+	// LRU: a hit moves the way to the back of the order
+	//
+	for (i = 0; i < 4; i++) {
+		r.Touch(0, i);
+	}
+	r.Touch(0, 0);
+	if (r.GetVictim(0) != 1) {
+		SC_REPORT_ERROR("cache-ace-test",
+			"LRU victim is not the least recently used way");
+	}
+
+	//
+	// Random: reproducible, in range and reaching every way
+	//
+	for (i = 0; i < 64; i++) {
+		unsigned int victim = r0.GetVictim(1);
+
+		if (victim >= 4 || victim != r1.GetVictim(1)) {
+			SC_REPORT_ERROR("cache-ace-test",
+				"Random victim out of range or not reproducible");
+		}
+		chosen[victim] = true;
+
+		r0.Touch(1, victim);
+		r1.Touch(1, victim);
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (!chosen[i]) {
+			SC_REPORT_ERROR("cache-ace-test",
+				"Random never picked a way");
+		}
+	}
+}
+
+SC_MODULE(Dut)
+{
+public:
+	enum { RamSize = 4 * 1024 };
+
+	SC_HAS_PROCESS(Dut);
+
+	Dut(sc_module_name name) :
+		done(false),
+		wb("cache-wb", WriteBack),
+		wt("cache-wt", WriteThrough),
+		ram_wb("ram-wb", sc_time(10, SC_NS), RamSize),
+		ram_wt("ram-wt", sc_time(10, SC_NS), RamSize)
+	{
+		socket[0].bind(wb.target_socket);
+		wb.init_socket.bind(ram_wb.socket);
+		snoop_socket[0].bind(wb.snoop_target_socket);
+
+		socket[1].bind(wt.target_socket);
+		wt.init_socket.bind(ram_wt.socket);
+		snoop_socket[1].bind(wt.snoop_target_socket);
+
+		SC_THREAD(test_thread);
+	}
+
+	bool done;
+
+private:
+	cache_t wb;
+	cache_t wt;
+
+	memory ram_wb;
+	memory ram_wt;
+
+	tlm_utils::simple_initiator_socket<Dut> socket[2];
+
+	// Snoops are not issued in this test
+	tlm_utils::simple_initiator_socket<Dut> snoop_socket[2];
+
+	void access(int port, tlm::tlm_command cmd, uint64_t addr,
+			unsigned char *data, unsigned int len)
+	{
+		tlm::tlm_generic_payload gp;
+		sc_time delay(SC_ZERO_TIME);
+
+		gp.set_command(cmd);
+		gp.set_address(addr);
+		gp.set_data_ptr(data);
+		gp.set_data_length(len);
+		gp.set_streaming_width(len);
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+		socket[port]->b_transport(gp, delay);
+		wait(delay);
+
+		if (gp.get_response_status() != tlm::TLM_OK_RESPONSE) {
+			SC_REPORT_ERROR("cache-ace-test", "Access failed");
+		}
+	}
+
+	void load(int port, uint64_t addr, unsigned int len = 4)
+	{
+		unsigned char data[CACHELINE_SIZE];
+
+		access(port, tlm::TLM_READ_COMMAND, addr, data, len);
+	}
+
+	void store(int port, uint64_t addr, unsigned char *data,
+			unsigned int len)
+	{
+		access(port, tlm::TLM_WRITE_COMMAND, addr, data, len);
+	}
+
+	void check_stats(const char *cache, CacheStats& stats,
+			uint64_t hits, uint64_t misses, uint64_t evictions)
+	{
+		if (stats.hits != hits ||
+			stats.misses != misses ||
+			stats.evictions != evictions ||
+			stats.snoop_hits != 0) {
+			std::ostringstream msg;
+
+			msg << cache << " stats: hits " << stats.hits
+				<< ", misses " << stats.misses
+				<< ", evictions " << stats.evictions
+				<< ", snoop hits " << stats.snoop_hits
+				<< ", expected " << hits << ", " << misses
+				<< ", " << evictions << ", 0";
+			SC_REPORT_ERROR("cache-ace-test", msg.str().c_str());
+		}
+	}
+
+	//
+	// Three lines of the same set through a 2 way LRU write back cache
+	//
+	void test_write_back()
+	{
+		load(0, 0);			// miss
+		load(0, SET_STRIDE);		// miss, fills the second way
+		load(0, 0);			// hit
+		load(0, 2 * SET_STRIDE);	// miss, evicts SET_STRIDE
+		load(0, SET_STRIDE);		// miss, evicts 0
+		load(0, 2 * SET_STRIDE);	// hit
+
+		check_stats("Write back", wb.get_stats(), 2, 4, 2);
+
+		wb.get_stats().Reset();
+		check_stats("Write back reset", wb.get_stats(), 0, 0, 0);
+	}
+
+	//
+	// Stores are counted but never allocate in the write through cache
+	//
+	void test_write_through()
+	{
+		unsigned char wr_data[CACHELINE_SIZE];
+		unsigned char rd_data[CACHELINE_SIZE];
+
+		memset(wr_data, 0xa5, sizeof(wr_data));
+
+		load(1, 0);				// miss
+		store(1, 0, wr_data, 4);		// hit
+		store(1, SET_STRIDE, wr_data, 4);	// miss
+		store(1, 0, wr_data, CACHELINE_SIZE);	// hit
+		store(1, 2 * SET_STRIDE, wr_data, 4);	// miss
+
+		check_stats("Write through", wt.get_stats(), 2, 3, 0);
+
+		memset(rd_data, 0, sizeof(rd_data));
+		access(1, tlm::TLM_READ_COMMAND, SET_STRIDE, rd_data, 4);
+
+		if (memcmp(wr_data, rd_data, 4)) {
+			SC_REPORT_ERROR("cache-ace-test",
+				"Write through data mismatch");
+		}
+
+		check_stats("Write through", wt.get_stats(), 2, 4, 0);
+	}
+
+	void test_thread()
+	{
+		test_write_back();
+		test_write_through();
+
+		done = true;
+	}
+};
+
+int sc_main(int argc, char *argv[])
+{
+	Dut dut("dut");
+
+	test_replacement();
+
+	sc_start(100, SC_MS);
+	sc_stop();
+
+	if (!dut.done) {
+		SC_REPORT_ERROR("cache-ace-test", "Test did not complete");
+	}
+
+	return 0;
+}
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "tlm-extensions/genattr.h"
+#include "tlm-bridges/amba-ace.h"
+using namespace AMBA::ACE;
+
+#include "tlm-modules/iconnect-ace.h"
+#include "test-modules/memory.h"
+
+#define CACHELINE_SIZE 64
+#define NUM_DS_PORTS 2
+
+typedef iconnect_ace<
+	1,		// NUM_ACE_MASTERS
+	2,		// NUM_ACELITE_MASTERS
+	CACHELINE_SIZE,	// CACHELINE_SZ
+	NUM_DS_PORTS	// NUM_DS_PORTS
+> iconnect_ace_t;
+
+//
+// Downstream target in front of the memory of one port, counts the
+// transactions it receives and acks exclusives below NoExOkayAddr.
+//
+SC_MODULE(DsTarget)
+{
+public:
+	enum { NoExOkayAddr = 0x2000 };
+
+	tlm_utils::simple_target_socket<DsTarget> socket;
+	tlm_utils::simple_initiator_socket<DsTarget> init_socket;
+
+	unsigned int num_tx;
+
+	DsTarget(sc_module_name name) :
+		socket("socket"),
+		init_socket("init-socket"),
+		num_tx(0)
+	{
+		socket.register_b_transport(this, &DsTarget::b_transport);
+	}
+
+private:
+	virtual void b_transport(tlm::tlm_generic_payload& trans,
+					sc_time& delay)
+	{
+		genattr_extension *genattr;
+
+		num_tx++;
+
+		init_socket->b_transport(trans, delay);
+
+		trans.get_extension(genattr);
+		if (genattr && genattr->get_exclusive()) {
+			genattr->set_exclusive_handled(
+				trans.get_address() < NoExOkayAddr);
+		}
+	}
+};
+
+SC_MODULE(Dut)
+{
+public:
+	enum { RamSize = 64 * 1024 };
+
+	SC_HAS_PROCESS(Dut);
+
+	Dut(sc_module_name name) :
+		done(false),
+		ic("iconnect-ace")
+	{
+		int i;
+
+		ace_socket.bind(ic.s_ace_port[0]->target_socket);
+		ic.s_ace_port[0]->snoop_init_socket.bind(snoop_socket);
+		snoop_socket.register_b_transport(this, &Dut::b_transport_snoop);
+
+		for (i = 0; i < 2; i++) {
+			acelite_socket[i].bind(
+				ic.s_acelite_port[i]->target_socket);
+		}
+
+		for (i = 0; i < NUM_DS_PORTS; i++) {
+			std::ostringstream name;
+
+			name << "ds-target" << i;
+			ds_target[i] = new DsTarget(name.str().c_str());
+
+			name.str("");
+			name << "ram" << i;
+			ram[i] = new memory(name.str().c_str(),
+						sc_time(10, SC_NS), RamSize);
+
+			ic.ds_ports[i]->connect_slave(*ds_target[i]);
+			ds_target[i]->init_socket.bind(ram[i]->socket);
+		}
+
+		//
+		// A cacheline per port so that a 4 KB transaction is split
+		// into 64 pieces, 32 per port, which is more than a port's
+		// fifo holds.
+		//
+		ic.set_ds_interleave(CACHELINE_SIZE);
+
+		SC_THREAD(test_thread);
+	}
+
+	~Dut()
+	{
+		int i;
+
+		for (i = 0; i < NUM_DS_PORTS; i++) {
+			delete ds_target[i];
+			delete ram[i];
+		}
+	}
+
+	bool done;
+
+private:
+	iconnect_ace_t ic;
+
+	tlm_utils::simple_initiator_socket<Dut> ace_socket;
+	tlm_utils::simple_target_socket<Dut> snoop_socket;
+	tlm_utils::simple_initiator_socket<Dut> acelite_socket[2];
+
+	DsTarget *ds_target[NUM_DS_PORTS];
+	memory *ram[NUM_DS_PORTS];
+
+	// Completion order of the overlapping ReadOnce transactions
+	std::vector<unsigned int> m_order;
+	unsigned int m_pending;
+	sc_event m_all_done;
+
+	//
+	// Snoops always miss (no data transfer, not shared, not dirty)
+	//
+	virtual void b_transport_snoop(tlm::tlm_generic_payload& trans,
+					sc_time& delay)
+	{
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	//
+	// ReadNoSnoop / WriteNoSnoop on ACE-Lite port
+	//
+	tlm::tlm_response_status access(int port, tlm::tlm_command cmd,
+					uint64_t addr, unsigned char *data,
+					unsigned int len,
+					bool exclusive = false,
+					bool *exokay = NULL)
+	{
+		tlm::tlm_generic_payload gp;
+		genattr_extension *genattr = new genattr_extension();
+		sc_time delay(SC_ZERO_TIME);
+
+		genattr->set_exclusive(exclusive);
+
+		gp.set_command(cmd);
+		gp.set_address(addr);
+		gp.set_data_ptr(data);
+		gp.set_data_length(len);
+		gp.set_streaming_width(len);
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		gp.set_extension(genattr);
+
+		acelite_socket[port]->b_transport(gp, delay);
+		wait(delay);
+
+		if (exokay) {
+			*exokay = genattr->get_exclusive_handled();
+		}
+
+		// Also deletes the extension
+		return gp.get_response_status();
+	}
+
+	void test_split()
+	{
+		unsigned char wr_data[4096];
+		unsigned char rd_data[4096];
+		unsigned int num_tx[NUM_DS_PORTS];
+		unsigned int i;
+		bool exokay;
+
+		for (i = 0; i < sizeof(wr_data); i++) {
+			wr_data[i] = i + (i >> 8);
+		}
+
+		for (i = 0; i < NUM_DS_PORTS; i++) {
+			num_tx[i] = ds_target[i]->num_tx;
+		}
+
+		if (access(0, tlm::TLM_WRITE_COMMAND, 0x1000, wr_data,
+				sizeof(wr_data)) != tlm::TLM_OK_RESPONSE) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Split write failed");
+		}
+
+		for (i = 0; i < NUM_DS_PORTS; i++) {
+			if (ds_target[i]->num_tx - num_tx[i] !=
+				sizeof(wr_data) / CACHELINE_SIZE / NUM_DS_PORTS) {
+				SC_REPORT_ERROR("iconnect-ace-test",
+					"Split write not interleaved");
+			}
+		}
+
+		memset(rd_data, 0, sizeof(rd_data));
+		if (access(1, tlm::TLM_READ_COMMAND, 0x1000, rd_data,
+				sizeof(rd_data)) != tlm::TLM_OK_RESPONSE) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Split read failed");
+		}
+
+		if (memcmp(wr_data, rd_data, sizeof(rd_data))) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Split read data mismatch");
+		}
+
+		//
+		// Exclusive okay only if all pieces are
+		//
+		if (access(0, tlm::TLM_READ_COMMAND, 0x1f40, rd_data, 128,
+				true, &exokay) != tlm::TLM_OK_RESPONSE ||
+			!exokay) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Exclusive okay lost on split read");
+		}
+
+		if (access(0, tlm::TLM_READ_COMMAND, 0x1fc0, rd_data, 128,
+				true, &exokay) != tlm::TLM_OK_RESPONSE ||
+			exokay) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Exclusive okay with a failing piece");
+		}
+	}
+
+	//
+	// ReadOnce on an ACE-Lite port issued at start, records when it
+	// completes in m_order
+	//
+	void read_once_thread(unsigned int id, int port, sc_time start,
+				uint64_t addr)
+	{
+		tlm::tlm_generic_payload gp;
+		genattr_extension *genattr = new genattr_extension();
+		sc_time delay(SC_ZERO_TIME);
+		unsigned char data[8];
+
+		wait(start);
+
+		genattr->set_domain(Domain::Inner);
+		genattr->set_snoop(AR::ReadOnce);
+
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		gp.set_address(addr);
+		gp.set_data_ptr(data);
+		gp.set_data_length(sizeof(data));
+		gp.set_streaming_width(sizeof(data));
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		gp.set_extension(genattr);
+
+		acelite_socket[port]->b_transport(gp, delay);
+		wait(delay);
+
+		if (gp.get_response_status() != tlm::TLM_OK_RESPONSE) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Overlapping ReadOnce failed");
+		}
+
+		m_order.push_back(id);
+
+		if (--m_pending == 0) {
+			m_all_done.notify();
+		}
+	}
+
+	//
+	// Three ReadOnce to the same cacheline from both ACE-Lite ports,
+	// each issued while the previous ones are ongoing, and one to
+	// another cacheline that must not stall.
+	//
+	void test_overlap()
+	{
+		iconnect_ace_t::overlap_stats& stats = ic.get_overlap_stats();
+		uint64_t transactions = stats.transactions;
+		uint64_t stalls = stats.stalls;
+		unsigned int expected = 0;
+		unsigned int i;
+
+		m_order.clear();
+		m_pending = 4;
+
+		sc_spawn(sc_bind(&Dut::read_once_thread, this,
+				0, 0, SC_ZERO_TIME, 0x4000));
+		sc_spawn(sc_bind(&Dut::read_once_thread, this,
+				1, 1, sc_time(1, SC_NS), 0x4008));
+		sc_spawn(sc_bind(&Dut::read_once_thread, this,
+				2, 0, sc_time(2, SC_NS), 0x4010));
+		sc_spawn(sc_bind(&Dut::read_once_thread, this,
+				3, 1, sc_time(3, SC_NS), 0x5000));
+
+		while (m_pending) {
+			wait(m_all_done);
+		}
+
+		for (i = 0; i < m_order.size(); i++) {
+			if (m_order[i] == 3) {
+				continue;
+			}
+
+			if (m_order[i] != expected++) {
+				SC_REPORT_ERROR("iconnect-ace-test",
+					"Overlapping ReadOnce out of order");
+			}
+		}
+
+		if (stats.transactions - transactions != 4) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Overlapping transactions not counted");
+		}
+
+		if (stats.stalls - stalls != 2) {
+			SC_REPORT_ERROR("iconnect-ace-test",
+				"Overlapping ReadOnce stalls not counted");
+		}
+	}
+
+	void test_thread()
+	{
+		test_split();
+		test_overlap();
+
+		done = true;
+	}
+};
+
+int sc_main(int argc, char *argv[])
+{
+	Dut dut("dut");
+
+	sc_start(100, SC_MS);
+	sc_stop();
+
+	if (!dut.done) {
+		SC_REPORT_ERROR("iconnect-ace-test", "Test did not complete");
+	}
+
+	return 0;
+}
@@ -42,8 +42,10 @@ using namespace std;
 #include "tlm_utils/simple_target_socket.h"
 
 #include "tlm-bridges/tlm2axi-bridge.h"
+#include "tlm-extensions/genattr.h"
 
 #include "tlm-modules/tlm-aligner.h"
+#include "tlm-modules/tlm-exmon.h"
 #include "tlm-modules/tlm-splitter.h"
 #include "traffic-generators/tg-tlm.h"
 #include "traffic-generators/random-traffic.h"
@@ -60,13 +62,54 @@ DataTransferVec transactions = {
         Read(28, 8),
         Read(0, 32),
         Read(0, 4),
+
+	//
+	// Byte enable patterns shorter than the pieces, the piece at 32
+	// starts in the middle of the pattern and runs past its end.
+	//
+        Write(29, DATA(0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+			0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c), 12),
+		ByteEnable(DATA(0xff, 0x0, 0xff, 0xff, 0x0), 5),
+        Read(24, 24),
+        Read(29, 12),
+		ByteEnable(DATA(0x0, 0xff, 0xff), 3),
+        Write(61, DATA(0x21, 0x22, 0x23, 0x24, 0x25, 0x26,
+			0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c,
+			0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32), 18),
+		ByteEnable(DATA(0xff, 0x0, 0x0, 0xff, 0xff, 0xff, 0x0), 7),
+        Read(56, 32),
 };
 
+//
+// Extension added by the target to the transactions it receives, counts
+// the instances alive.
+//
+class test_extension : public tlm::tlm_extension<test_extension>
+{
+public:
+	test_extension() { live++; }
+	~test_extension() { live--; }
+
+	tlm::tlm_extension_base *clone() const
+	{
+		return new test_extension();
+	}
+
+	void copy_from(const tlm::tlm_extension_base &ext) {}
+
+	static int live;
+};
+
+int test_extension::live = 0;
+
 SC_MODULE(Dut)
 {
 public:
+	SC_HAS_PROCESS(Dut);
+
 	Dut(sc_module_name name, DataTransferVec &transfers,
 		unsigned int ram_size = 256 * 1024) :
+		dmi_done(false),
 		xfers(merge(transfers)),
 		rand_xfers(0, ram_size - 1024, UINT64_MAX, 1, ram_size, ram_size, 1000),
 		splitter("splitter", true),
@@ -77,9 +120,18 @@ public:
 		rst_n("rst_n", true),
 		aligner("aligner", 64, 32, 4 * 1024, true, &bridge),
 		ram("ram", sc_time(1, SC_NS), ram_size),
-		ref_ram("ref-ram", sc_time(1, SC_NS), ram_size)
+		ref_ram("ref-ram", sc_time(1, SC_NS), ram_size),
+		err_aligner("err-aligner", 64, 32, 4 * 1024, true),
+		m_err_pieces(0),
+		m_err_last_addr(0),
+		dmi_aligner("dmi-aligner", 64, 32, 4 * 1024, true),
+		dmi_exmon("dmi-exmon"),
+		dmi_ram("dmi-ram", sc_time(1, SC_NS), 64 * 1024),
+		m_nr_inv(0)
 	{
 		target_socket.register_b_transport(this, &Dut::b_transport);
+		err_target_socket.register_b_transport(this,
+						&Dut::b_transport_err);
 
 //		tg.enableDebug();
 		tg.addTransfers(xfers, 0);
@@ -99,8 +151,25 @@ public:
 		bridge.clk(clk);
 		bridge.resetn(rst_n);
 		signals.connect(bridge);
+
+		// Error responses in the middle of a split transaction
+		err_init_socket.bind(err_aligner.target_socket);
+		err_aligner.init_socket.bind(err_target_socket);
+
+		SC_THREAD(err_thread);
+
+		// DMI, debug accesses and invalidations through the aligner
+		dmi_init_socket.register_invalidate_direct_mem_ptr(this,
+				&Dut::invalidate_direct_mem_ptr);
+		dmi_init_socket.bind(dmi_aligner.target_socket);
+		dmi_aligner.init_socket.bind(dmi_exmon.target_socket);
+		dmi_exmon.init_socket.bind(dmi_ram.socket);
+
+		SC_THREAD(dmi_thread);
 	}
 
+	bool dmi_done;
+
 private:
 	TrafficDesc xfers;
 	RandomTraffic rand_xfers;
@@ -124,11 +193,170 @@ private:
 
 	memory ref_ram;
 
+	tlm_utils::simple_initiator_socket<Dut> err_init_socket;
+	tlm_utils::simple_target_socket<Dut> err_target_socket;
+	tlm_aligner err_aligner;
+
+	enum { ERR_ADDR = 40 };
+
+	unsigned int m_err_pieces;
+	uint64_t m_err_last_addr;
+
+	tlm_utils::simple_initiator_socket<Dut> dmi_init_socket;
+	tlm_aligner dmi_aligner;
+	tlm_exclusive_monitor dmi_exmon;
+	memory dmi_ram;
+
+	unsigned int m_nr_inv;
+
 	virtual void b_transport(tlm::tlm_generic_payload &trans, sc_time &delay)
 	{
 		// Apply checks?
 		init_socket->b_transport(trans, delay);
 	}
+
+	//
+	// Fails the access of ERR_ADDR and adds an extension of its own to
+	// the transactions.
+	//
+	virtual void b_transport_err(tlm::tlm_generic_payload &trans,
+					sc_time &delay)
+	{
+		uint64_t addr = trans.get_address();
+		test_extension *ext;
+
+		m_err_pieces++;
+		m_err_last_addr = addr;
+
+		trans.get_extension(ext);
+		if (!ext) {
+			trans.set_extension(new test_extension());
+		}
+
+		if (addr <= ERR_ADDR && ERR_ADDR < addr + trans.get_data_length()) {
+			trans.set_response_status(
+				tlm::TLM_ADDRESS_ERROR_RESPONSE);
+		} else {
+			trans.set_response_status(tlm::TLM_OK_RESPONSE);
+		}
+	}
+
+	//
+	// A 96 byte write is split into [0, 32), [32, 64) and [64, 96), the
+	// second piece fails.
+	//
+	void err_thread()
+	{
+		tlm::tlm_generic_payload gp;
+		genattr_extension *attr = new genattr_extension();
+		unsigned char data[96];
+		sc_time delay(SC_ZERO_TIME);
+
+		memset(data, 0, sizeof(data));
+
+		gp.set_command(tlm::TLM_WRITE_COMMAND);
+		gp.set_address(0);
+		gp.set_data_ptr(data);
+		gp.set_data_length(sizeof(data));
+		gp.set_streaming_width(sizeof(data));
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		gp.set_extension(attr);
+
+		err_init_socket->b_transport(gp, delay);
+
+		if (gp.get_response_status() !=
+			tlm::TLM_ADDRESS_ERROR_RESPONSE) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Error response not propagated");
+		}
+
+		if (m_err_pieces != 2 || m_err_last_addr != 32) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Pieces issued after the error response");
+		}
+
+		if (gp.get_extension<genattr_extension>() != attr) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Transaction extension lost");
+		}
+
+		if (gp.get_extension<test_extension>() ||
+			test_extension::live != 0) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Target extension not released");
+		}
+	}
+
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		if (start != 0x100 || end != 0x107) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Wrong DMI range invalidated");
+		}
+		m_nr_inv++;
+	}
+
+	//
+	// The aligner forwards DMI requests and debug accesses unchanged and
+	// propagates invalidations (here from the exclusive monitor behind
+	// it).
+	//
+	void dmi_thread()
+	{
+		tlm::tlm_generic_payload gp;
+		genattr_extension *attr = new genattr_extension();
+		unsigned char data[8] = { 0x1, 0x2, 0x3, 0x4,
+					0x5, 0x6, 0x7, 0x8 };
+		unsigned char rd[8];
+		sc_time delay(SC_ZERO_TIME);
+		tlm::tlm_dmi dmi;
+
+		gp.set_command(tlm::TLM_WRITE_COMMAND);
+		gp.set_address(0x100);
+		gp.set_data_ptr(data);
+		gp.set_data_length(sizeof(data));
+		gp.set_streaming_width(sizeof(data));
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		if (dmi_init_socket->transport_dbg(gp) != sizeof(data)) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Debug write failed");
+		}
+
+		memset(rd, 0, sizeof(rd));
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		gp.set_data_ptr(rd);
+		if (dmi_init_socket->transport_dbg(gp) != sizeof(rd) ||
+			memcmp(data, rd, sizeof(rd))) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"Debug read failed");
+		}
+
+		if (!dmi_init_socket->get_direct_mem_ptr(gp, dmi) ||
+			dmi.get_start_address() != 0 ||
+			dmi.get_end_address() != 64 * 1024 - 1 ||
+			!dmi.is_read_write_allowed() ||
+			memcmp(dmi.get_dmi_ptr() + 0x100, data, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"DMI not forwarded");
+		}
+
+		// An exclusive read makes the monitor invalidate DMI
+		attr->set_exclusive(true);
+		gp.set_extension(attr);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		dmi_init_socket->b_transport(gp, delay);
+
+		if (m_nr_inv != 1) {
+			SC_REPORT_ERROR("tlm-aligner-test",
+				"DMI invalidation not propagated");
+		}
+
+		dmi_done = true;
+	}
 };
 
 SC_MODULE(Top)
@@ -149,6 +377,10 @@ int sc_main(int argc, char *argv[])
 	sc_start(100, SC_MS);
 	sc_stop();
 
+	if (!top.dut.dmi_done) {
+		SC_REPORT_ERROR("tlm-aligner-test", "DMI test did not complete");
+	}
+
 	if (trace_fp) {
 		sc_close_vcd_trace_file(trace_fp);
 	}
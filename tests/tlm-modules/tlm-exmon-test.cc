@@ -138,6 +138,99 @@ DataTransferVec transactions = {
 
         Read(16),
 		Expect(DATA(0x2, 0x2, 0x2, 0x2), 4),
+
+	//
+	// Write starting inside the monitored location
+	//
+        Read(0x100, 8),
+		GENATTR(0x0, true),
+
+        Write(0x104, DATA(0x3, 0x3, 0x3, 0x3)),
+		GENATTR(0x1, false),
+
+        Write(0x100, DATA(0x4, 0x4, 0x4, 0x4, 0x4, 0x4, 0x4, 0x4), 8),
+		GENATTR(0x0, true),
+
+        Read(0x100, 8),
+		Expect(DATA(0x0, 0x0, 0x0, 0x0, 0x3, 0x3, 0x3, 0x3), 8),
+
+	//
+	// Write starting before the monitored location and overlapping it
+	//
+        Read(0x110),
+		GENATTR(0x0, true),
+
+        Write(0x10e, DATA(0x5, 0x5, 0x5, 0x5)),
+		GENATTR(0x1, false),
+
+        Write(0x110, DATA(0x6, 0x6, 0x6, 0x6)),
+		GENATTR(0x0, true),
+
+        Read(0x10c, 8),
+		Expect(DATA(0x0, 0x0, 0x5, 0x5, 0x5, 0x5, 0x0, 0x0), 8),
+
+	//
+	// Write ending just before the monitored location
+	//
+        Read(0x120),
+		GENATTR(0x0, true),
+
+        Write(0x11c, DATA(0x7, 0x7, 0x7, 0x7)),
+		GENATTR(0x1, false),
+
+        Write(0x120, DATA(0x8, 0x8, 0x8, 0x8)),
+		GENATTR(0x0, true),
+
+        Read(0x11c, 8),
+		Expect(DATA(0x7, 0x7, 0x7, 0x7, 0x8, 0x8, 0x8, 0x8), 8),
+
+	//
+	// Monitored location crossing a 128 byte granule, written in the
+	// second granule only
+	//
+        Read(0x17e),
+		GENATTR(0x0, true),
+
+        Write(0x180, DATA(0x9, 0x9), 2),
+		GENATTR(0x1, false),
+
+        Write(0x17e, DATA(0xa, 0xa, 0xa, 0xa)),
+		GENATTR(0x0, true),
+
+        Read(0x17c, 8),
+		Expect(DATA(0x0, 0x0, 0x0, 0x0, 0x9, 0x9, 0x0, 0x0), 8),
+
+	// Exclusive write to a location crossing a granule
+        Read(0x1fe),
+		GENATTR(0x0, true),
+
+        Write(0x1fe, DATA(0xb, 0xb, 0xb, 0xb)),
+		GENATTR(0x0, true),
+
+        Read(0x1fc, 8),
+		Expect(DATA(0x0, 0x0, 0xb, 0xb, 0xb, 0xb, 0x0, 0x0), 8),
+
+	//
+	// A new exclusive read with the same masked id moves the monitored
+	// location (0x2 & 0x1 == 0x0)
+	//
+        Read(0x240),
+		GENATTR(0x0, true),
+
+        Read(0x250),
+		GENATTR(0x2, true),
+
+        Write(0x240, DATA(0xc, 0xc, 0xc, 0xc)),
+		GENATTR(0x0, true),
+
+        Write(0x250, DATA(0xd, 0xd, 0xd, 0xd)),
+		GENATTR(0x0, true),
+
+        Read(0x240),
+		Expect(DATA(0x0, 0x0, 0x0, 0x0), 4),
+
+        Read(0x250),
+		Expect(DATA(0xd, 0xd, 0xd, 0xd), 4),
 };
 
 SC_MODULE(Dut)
@@ -166,13 +259,179 @@ private:
 	TrafficDesc xfers;
 };
 
+//
+// Initiator -> exmon -> ram, checks the DMI ranges handed out around the
+// monitored locations, the invalidations sent when a location starts to
+// be monitored and debug accesses.
+//
+SC_MODULE(DmiDut)
+{
+public:
+	enum { RamSize = 64 * 1024 };
+
+	SC_HAS_PROCESS(DmiDut);
+
+	DmiDut(sc_module_name name) :
+		done(false),
+		exmon("exclusive-monitor"),
+		ram("ram", sc_time(1, SC_NS), RamSize),
+		inv_start(0),
+		inv_end(0),
+		nr_inv(0)
+	{
+		init_socket.register_invalidate_direct_mem_ptr(this,
+				&DmiDut::invalidate_direct_mem_ptr);
+
+		init_socket.bind(exmon.target_socket);
+		exmon.init_socket.bind(ram.socket);
+
+		SC_THREAD(test_thread);
+	}
+
+	bool done;
+
+private:
+	tlm_utils::simple_initiator_socket<DmiDut> init_socket;
+	tlm_exclusive_monitor exmon;
+	memory ram;
+
+	uint64_t inv_start;
+	uint64_t inv_end;
+	unsigned int nr_inv;
+
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		inv_start = start;
+		inv_end = end;
+		nr_inv++;
+	}
+
+	void access(tlm::tlm_command cmd, uint64_t addr, unsigned char *data,
+			unsigned int len, bool exclusive)
+	{
+		tlm::tlm_generic_payload gp;
+		genattr_extension *genattr = new genattr_extension();
+		sc_time delay(SC_ZERO_TIME);
+
+		genattr->set_exclusive(exclusive);
+
+		gp.set_command(cmd);
+		gp.set_address(addr);
+		gp.set_data_ptr(data);
+		gp.set_data_length(len);
+		gp.set_streaming_width(len);
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		gp.set_extension(genattr);
+
+		init_socket->b_transport(gp, delay);
+	}
+
+	bool get_dmi(uint64_t addr, tlm::tlm_dmi& dmi)
+	{
+		tlm::tlm_generic_payload gp;
+
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		gp.set_address(addr);
+
+		return init_socket->get_direct_mem_ptr(gp, dmi);
+	}
+
+	void check_dmi(uint64_t addr, uint64_t start, uint64_t end,
+			bool rw, unsigned char *base, const char *msg)
+	{
+		tlm::tlm_dmi dmi;
+
+		if (!get_dmi(addr, dmi) ||
+			dmi.get_start_address() != start ||
+			dmi.get_end_address() != end ||
+			dmi.get_dmi_ptr() != base + start ||
+			dmi.is_write_allowed() != rw ||
+			!dmi.is_read_allowed()) {
+			SC_REPORT_ERROR("tlm-exmon-test", msg);
+		}
+	}
+
+	void test_thread()
+	{
+		unsigned char data[8];
+		unsigned char *base;
+		tlm::tlm_generic_payload gp;
+		tlm::tlm_dmi dmi;
+
+		// Nothing monitored, all of the memory
+		if (!get_dmi(0, dmi)) {
+			SC_REPORT_ERROR("tlm-exmon-test", "DMI refused");
+		}
+		base = dmi.get_dmi_ptr();
+		check_dmi(0x1000, 0, RamSize - 1, true, base,
+			"DMI range with nothing monitored");
+
+		// Monitoring 0x100 - 0x107 invalidates the range
+		memset(data, 0, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, 0x100, data, sizeof(data), true);
+		if (nr_inv != 1 || inv_start != 0x100 || inv_end != 0x107) {
+			SC_REPORT_ERROR("tlm-exmon-test",
+				"Monitored location not invalidated");
+		}
+
+		// Ranges are carved around the location
+		check_dmi(0x0, 0, 0xff, true, base,
+			"DMI range below the monitored location");
+		check_dmi(0x1000, 0x108, RamSize - 1, true, base,
+			"DMI range above the monitored location");
+
+		// The location itself is read only
+		check_dmi(0x104, 0x100, 0x107, false, base,
+			"DMI on the monitored location");
+
+		// The exclusive write clears the location
+		access(tlm::TLM_WRITE_COMMAND, 0x100, data, sizeof(data), true);
+		check_dmi(0x104, 0, RamSize - 1, true, base,
+			"DMI range after the exclusive write");
+
+		//
+		// Debug accesses reach the memory and don't clear monitored
+		// locations
+		//
+		access(tlm::TLM_READ_COMMAND, 0x200, data, sizeof(data), true);
+
+		memset(data, 0x5a, sizeof(data));
+		gp.set_command(tlm::TLM_WRITE_COMMAND);
+		gp.set_address(0x300);
+		gp.set_data_ptr(data);
+		gp.set_data_length(sizeof(data));
+		gp.set_streaming_width(sizeof(data));
+		if (init_socket->transport_dbg(gp) != sizeof(data) ||
+			memcmp(base + 0x300, data, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-exmon-test", "Debug write failed");
+		}
+
+		memset(data, 0, sizeof(data));
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		if (init_socket->transport_dbg(gp) != sizeof(data) ||
+			memcmp(base + 0x300, data, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-exmon-test", "Debug read failed");
+		}
+
+		check_dmi(0x204, 0x200, 0x207, false, base,
+			"Monitored location lost on debug access");
+
+		done = true;
+	}
+};
+
 SC_MODULE(Top)
 {
 	Dut dut;
+	DmiDut dmi_dut;
 
 	Top(sc_module_name name,
 	    DataTransferVec &transfers_dut) :
-		dut("dut", transfers_dut)
+		dut("dut", transfers_dut),
+		dmi_dut("dmi-dut")
 	{ }
 };
 
@@ -184,6 +443,10 @@ int sc_main(int argc, char *argv[])
 	sc_start(100, SC_MS);
 	sc_stop();
 
+	if (!top.dmi_dut.done) {
+		SC_REPORT_ERROR("tlm-exmon-test", "DMI test did not complete");
+	}
+
 	if (trace_fp) {
 		sc_close_vcd_trace_file(trace_fp);
 	}
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "tlm-modules/tlm-splitter.h"
+
+//
+// Memory granting DMI over [dmi_start, dmi_end] only. Accesses wait
+// wait_time and add delay_time to the annotated delay.
+//
+SC_MODULE(Target)
+{
+public:
+	enum { MemSize = 4 * 1024 };
+
+	tlm_utils::simple_target_socket<Target> socket;
+
+	unsigned char mem[MemSize];
+
+	sc_time wait_time;
+	sc_time delay_time;
+
+	Target(sc_module_name name, uint64_t dmi_start, uint64_t dmi_end) :
+		socket("socket"),
+		wait_time(SC_ZERO_TIME),
+		delay_time(SC_ZERO_TIME),
+		dmi_start(dmi_start),
+		dmi_end(dmi_end)
+	{
+		memset(mem, 0, sizeof(mem));
+
+		socket.register_b_transport(this, &Target::b_transport);
+		socket.register_transport_dbg(this, &Target::transport_dbg);
+		socket.register_get_direct_mem_ptr(this,
+				&Target::get_direct_mem_ptr);
+	}
+
+	void invalidate(uint64_t start, uint64_t end)
+	{
+		socket->invalidate_direct_mem_ptr(start, end);
+	}
+
+private:
+	uint64_t dmi_start;
+	uint64_t dmi_end;
+
+	virtual void b_transport(tlm::tlm_generic_payload& trans,
+					sc_time& delay)
+	{
+		if (wait_time != SC_ZERO_TIME) {
+			wait(wait_time);
+		}
+		delay += delay_time;
+
+		transport_dbg(trans);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	virtual unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
+	{
+		uint64_t addr = trans.get_address();
+		unsigned int len = trans.get_data_length();
+
+		if (trans.is_read()) {
+			memcpy(trans.get_data_ptr(), &mem[addr], len);
+		} else {
+			memcpy(&mem[addr], trans.get_data_ptr(), len);
+		}
+		return len;
+	}
+
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data)
+	{
+		dmi_data.allow_read_write();
+		dmi_data.set_dmi_ptr(&mem[dmi_start]);
+		dmi_data.set_start_address(dmi_start);
+		dmi_data.set_end_address(dmi_end);
+		return true;
+	}
+};
+
+//
+// DMI and debug accesses through a splitter in front of two targets
+// granting different DMI ranges, and through one checking read data.
+//
+SC_MODULE(DmiDut)
+{
+public:
+	SC_HAS_PROCESS(DmiDut);
+
+	DmiDut(sc_module_name name) :
+		done(false),
+		splitter("splitter"),
+		check_splitter("check-splitter", true),
+		t0("target0", 0, 0xfff),
+		t1("target1", 0x100, 0x7ff),
+		t2("target2", 0, 0xfff),
+		t3("target3", 0, 0xfff),
+		nr_inv(0)
+	{
+		init_socket.register_invalidate_direct_mem_ptr(this,
+				&DmiDut::invalidate_direct_mem_ptr);
+
+		init_socket.bind(splitter.target_socket);
+		splitter.i_sk[0]->bind(t0.socket);
+		splitter.i_sk[1]->bind(t1.socket);
+
+		check_socket.bind(check_splitter.target_socket);
+		check_splitter.i_sk[0]->bind(t2.socket);
+		check_splitter.i_sk[1]->bind(t3.socket);
+
+		SC_THREAD(test_thread);
+	}
+
+	bool done;
+
+private:
+	tlm_utils::simple_initiator_socket<DmiDut> init_socket;
+	tlm_utils::simple_initiator_socket<DmiDut> check_socket;
+	tlm_splitter<2> splitter;
+	tlm_splitter<2> check_splitter;
+	Target t0;
+	Target t1;
+	Target t2;
+	Target t3;
+
+	unsigned int nr_inv;
+
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		nr_inv++;
+	}
+
+	void test_thread()
+	{
+		tlm::tlm_generic_payload gp;
+		unsigned char data[4] = { 0x1, 0x2, 0x3, 0x4 };
+		tlm::tlm_dmi dmi;
+
+		//
+		// Read only, into the first target, over the intersection
+		// of the granted ranges
+		//
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		gp.set_address(0x200);
+		if (!init_socket->get_direct_mem_ptr(gp, dmi) ||
+			dmi.get_start_address() != 0x100 ||
+			dmi.get_end_address() != 0x7ff ||
+			dmi.get_dmi_ptr() != &t0.mem[0x100] ||
+			!dmi.is_read_allowed() ||
+			dmi.is_write_allowed()) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"DMI not the read only intersection");
+		}
+
+		// Invalidations from any target are propagated
+		t1.invalidate(0x100, 0x7ff);
+		t0.invalidate(0, 0xfff);
+		if (nr_inv != 2) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"DMI invalidation not propagated");
+		}
+
+		// No DMI when the read data is compared
+		gp.set_address(0x200);
+		if (check_socket->get_direct_mem_ptr(gp, dmi)) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"DMI granted with read data checking");
+		}
+
+		// Debug writes reach all targets, reads the first one
+		gp.set_command(tlm::TLM_WRITE_COMMAND);
+		gp.set_address(0x10);
+		gp.set_data_ptr(data);
+		gp.set_data_length(sizeof(data));
+		gp.set_streaming_width(sizeof(data));
+		if (init_socket->transport_dbg(gp) != sizeof(data) ||
+			memcmp(&t0.mem[0x10], data, sizeof(data)) ||
+			memcmp(&t1.mem[0x10], data, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Debug write not replicated");
+		}
+
+		t1.mem[0x10] = 0xff;
+		memset(data, 0, sizeof(data));
+		gp.set_command(tlm::TLM_READ_COMMAND);
+		if (init_socket->transport_dbg(gp) != sizeof(data) ||
+			memcmp(&t0.mem[0x10], data, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Debug read not from the first target");
+		}
+
+		done = true;
+	}
+};
+
+//
+// Parallel splitter in front of three targets with different timing,
+// checks the returned delay and the read data comparison.
+//
+SC_MODULE(ParallelDut)
+{
+public:
+	SC_HAS_PROCESS(ParallelDut);
+
+	ParallelDut(sc_module_name name) :
+		done(false),
+		splitter("splitter", true, true),
+		t0("target0", 0, Target::MemSize - 1),
+		t1("target1", 0, Target::MemSize - 1),
+		t2("target2", 0, Target::MemSize - 1)
+	{
+		init_socket.bind(splitter.target_socket);
+		splitter.i_sk[0]->bind(t0.socket);
+		splitter.i_sk[1]->bind(t1.socket);
+		splitter.i_sk[2]->bind(t2.socket);
+
+		SC_THREAD(test_thread);
+	}
+
+	bool done;
+
+private:
+	tlm_utils::simple_initiator_socket<ParallelDut> init_socket;
+	tlm_splitter<3> splitter;
+	Target t0;
+	Target t1;
+	Target t2;
+
+	//
+	// Issues the access with an annotated delay of 3 ns and checks that
+	// it completes at start + end_ns.
+	//
+	void access(tlm::tlm_command cmd, uint64_t addr, unsigned char *data,
+			unsigned int len, unsigned int end_ns)
+	{
+		tlm::tlm_generic_payload gp;
+		sc_time start = sc_time_stamp();
+		sc_time delay(3, SC_NS);
+
+		gp.set_command(cmd);
+		gp.set_address(addr);
+		gp.set_data_ptr(data);
+		gp.set_data_length(len);
+		gp.set_streaming_width(len);
+		gp.set_byte_enable_ptr(NULL);
+		gp.set_byte_enable_length(0);
+		gp.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+		init_socket->b_transport(gp, delay);
+
+		if (gp.get_response_status() != tlm::TLM_OK_RESPONSE) {
+			SC_REPORT_ERROR("tlm-splitter-test", "Access failed");
+		}
+
+		if (sc_time_stamp() + delay != start + sc_time(end_ns, SC_NS)) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Wrong completion time");
+		}
+
+		wait(delay);
+	}
+
+	void test_thread()
+	{
+		unsigned char data[16];
+		unsigned char ref[16];
+		unsigned int nr_err;
+		unsigned int i;
+
+		for (i = 0; i < sizeof(ref); i++) {
+			ref[i] = 0x30 + i;
+		}
+
+		//
+		// Port 0 waits 10 ns and adds 5 ns, port 1 adds 40 ns and
+		// port 2 waits 20 ns, port 1 completes last.
+		//
+		t0.wait_time = sc_time(10, SC_NS);
+		t0.delay_time = sc_time(5, SC_NS);
+		t1.delay_time = sc_time(40, SC_NS);
+		t2.wait_time = sc_time(20, SC_NS);
+		access(tlm::TLM_WRITE_COMMAND, 0x40, ref, sizeof(ref), 43);
+
+		// Port 2 completes last, after the returning ports waited
+		t1.delay_time = SC_ZERO_TIME;
+		access(tlm::TLM_WRITE_COMMAND, 0x40, ref, sizeof(ref), 23);
+
+		// Port 0 completes last
+		t0.delay_time = sc_time(30, SC_NS);
+		access(tlm::TLM_WRITE_COMMAND, 0x40, ref, sizeof(ref), 43);
+
+		//
+		// Read data is compared with the fanout buffers reused
+		// across reads of different lengths
+		//
+		nr_err = sc_report_handler::get_count(TLM_SPLITTER_ERROR);
+
+		memset(data, 0, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, 0x40, data, sizeof(data), 43);
+		if (memcmp(data, ref, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Read data mismatch");
+		}
+
+		memset(data, 0, sizeof(data));
+		access(tlm::TLM_READ_COMMAND, 0x48, data, 4, 43);
+		access(tlm::TLM_READ_COMMAND, 0x40, data, sizeof(data), 43);
+		if (memcmp(data, ref, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Read data mismatch");
+		}
+
+		if (sc_report_handler::get_count(TLM_SPLITTER_ERROR) !=
+			nr_err) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Read data mismatch reported");
+		}
+
+		// A mismatch on port 2 is reported (but not failed on here)
+		sc_report_handler::set_actions(TLM_SPLITTER_ERROR, SC_DISPLAY);
+		t2.mem[0x4c] ^= 0xff;
+		access(tlm::TLM_READ_COMMAND, 0x40, data, sizeof(data), 43);
+		if (sc_report_handler::get_count(TLM_SPLITTER_ERROR) !=
+			nr_err + 1) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Read data mismatch not reported");
+		}
+		if (memcmp(data, ref, sizeof(data))) {
+			SC_REPORT_ERROR("tlm-splitter-test",
+				"Read data not from port 0");
+		}
+
+		done = true;
+	}
+};
+
+SC_MODULE(Top)
+{
+	DmiDut dmi_dut;
+	ParallelDut parallel_dut;
+
+	Top(sc_module_name name) :
+		dmi_dut("dmi-dut"),
+		parallel_dut("parallel-dut")
+	{ }
+};
+
+int sc_main(int argc, char *argv[])
+{
+	Top top("Top");
+
+	sc_start(100, SC_MS);
+	sc_stop();
+
+	if (!top.dmi_dut.done) {
+		SC_REPORT_ERROR("tlm-splitter-test",
+			"DMI test did not complete");
+	}
+
+	if (!top.parallel_dut.done) {
+		SC_REPORT_ERROR("tlm-splitter-test",
+			"Parallel test did not complete");
+	}
+
+	return 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * Traffic generator non-blocking mode test.
+ *
+ * Copyright (c) 2026 Xilinx Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include "systemc"
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm.h"
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+#include "traffic-generators/tg-tlm.h"
+#include "traffic-generators/traffic-desc.h"
+#include "test-modules/utils.h"
+
+using namespace utils;
+
+#define TEST_ERROR "tlm-nb-tg-test"
+
+enum { MAX_OUTSTANDING = 4 };
+
+const unsigned char burst_data[] = {
+	0x11, 0x12, 0x13, 0x14, 0x21, 0x22, 0x23, 0x24,
+	0x21, 0x22, 0x23, 0x24, 0x31, 0x32, 0x33, 0x34,
+	0x31, 0x32, 0x33, 0x34, 0x41, 0x42, 0x43, 0x44,
+	0x41, 0x42, 0x43, 0x44, 0x51, 0x52, 0x53, 0x54
+};
+
+DataTransferVec transactions = {
+	Write(0x0, DATA(0x1, 0x2, 0x3, 0x4)),
+	Write(0x4, DATA(0x5, 0x6, 0x7, 0x8)),
+	Write(0x8, DATA(0x9, 0xa, 0xb, 0xc)),
+	Write(0x10, burst_data, sizeof(burst_data)),
+
+	Read(0x0),
+		Expect(DATA(0x1, 0x2, 0x3, 0x4), 4),
+	Read(0x4),
+		Expect(DATA(0x5, 0x6, 0x7, 0x8), 4),
+	Read(0x8),
+		Expect(DATA(0x9, 0xa, 0xb, 0xc), 4),
+	Read(0x10, sizeof(burst_data)),
+		Expect(burst_data, sizeof(burst_data)),
+
+	Write(0x0, DATA(0xff, 0xff, 0xff, 0xff)),
+	Read(0x0),
+		Expect(DATA(0xff, 0xff, 0xff, 0xff), 4),
+	Write(0x4, DATA(0x0, 0x0, 0x0, 0x0)),
+	Read(0x4),
+		Expect(DATA(0x0, 0x0, 0x0, 0x0), 4),
+	Read(0x8),
+		Expect(DATA(0x9, 0xa, 0xb, 0xc), 4),
+	Read(0x0),
+		Expect(DATA(0xff, 0xff, 0xff, 0xff), 4),
+	Read(0x10, 8),
+		Expect(burst_data, 8),
+	Read(0x18, 8),
+		Expect(burst_data + 8, 8),
+};
+
+//
+// Non-blocking memory. Requests are accessed in order when they arrive
+// and complete in one of three ways, in turn:
+//
+//  - TLM_ACCEPTED, END_REQ and BEGIN_RESP sent later on the backward path
+//  - TLM_UPDATED with END_REQ, BEGIN_RESP sent later
+//  - TLM_COMPLETED right away
+//
+// Responses are returned one at a time, slower than requests are
+// accepted, so requests pile up to the generator's outstanding limit.
+//
+SC_MODULE(nb_memory)
+{
+public:
+	tlm_utils::simple_target_socket<nb_memory> socket;
+
+	SC_HAS_PROCESS(nb_memory);
+	nb_memory(sc_module_name name, unsigned int max_outstanding) :
+		socket("socket"),
+		m_max_outstanding(max_outstanding),
+		m_nr_txns(0),
+		m_outstanding(0),
+		m_max_seen(0)
+	{
+		memset(m_mem, 0, sizeof(m_mem));
+
+		socket.register_nb_transport_fw(this,
+				&nb_memory::nb_transport_fw);
+
+		SC_THREAD(req_thread);
+		SC_THREAD(resp_thread);
+	}
+
+	unsigned int get_nr_txns() { return m_nr_txns; }
+	unsigned int get_outstanding() { return m_outstanding; }
+	unsigned int get_max_seen() { return m_max_seen; }
+
+private:
+	enum { MEM_SIZE = 1024 };
+
+	void access(tlm::tlm_generic_payload& trans)
+	{
+		uint64_t addr = trans.get_address();
+		unsigned int len = trans.get_data_length();
+
+		if (addr + len > MEM_SIZE) {
+			trans.set_response_status(
+				tlm::TLM_ADDRESS_ERROR_RESPONSE);
+			return;
+		}
+
+		if (trans.is_read()) {
+			memcpy(trans.get_data_ptr(), &m_mem[addr], len);
+		} else {
+			memcpy(&m_mem[addr], trans.get_data_ptr(), len);
+		}
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	void done(tlm::tlm_generic_payload& trans)
+	{
+		m_outstanding--;
+		trans.release();
+	}
+
+	tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload& trans,
+					tlm::tlm_phase& phase,
+					sc_time& delay)
+	{
+		if (phase == tlm::END_RESP) {
+			done(trans);
+			return tlm::TLM_COMPLETED;
+		}
+
+		if (phase != tlm::BEGIN_REQ) {
+			SC_REPORT_ERROR(TEST_ERROR, "Unexpected phase");
+			return tlm::TLM_COMPLETED;
+		}
+
+		access(trans);
+
+		m_outstanding++;
+		if (m_outstanding > m_max_seen) {
+			m_max_seen = m_outstanding;
+		}
+		if (m_outstanding > m_max_outstanding) {
+			SC_REPORT_ERROR(TEST_ERROR,
+				"Outstanding request limit exceeded");
+		}
+
+		switch (m_nr_txns++ % 3) {
+		case 0:
+			trans.acquire();
+			m_req_queue.push_back(&trans);
+			m_req_event.notify();
+			return tlm::TLM_ACCEPTED;
+		case 1:
+			trans.acquire();
+			m_resp_queue.push_back(&trans);
+			m_resp_event.notify();
+			phase = tlm::END_REQ;
+			return tlm::TLM_UPDATED;
+		default:
+			m_outstanding--;
+			return tlm::TLM_COMPLETED;
+		}
+	}
+
+	void req_thread()
+	{
+		while (true) {
+			tlm::tlm_generic_payload *trans;
+			tlm::tlm_phase phase = tlm::END_REQ;
+			sc_time delay = SC_ZERO_TIME;
+
+			while (m_req_queue.empty()) {
+				wait(m_req_event);
+			}
+
+			wait(5, SC_NS);
+
+			trans = m_req_queue.front();
+			m_req_queue.pop_front();
+
+			socket->nb_transport_bw(*trans, phase, delay);
+
+			m_resp_queue.push_back(trans);
+			m_resp_event.notify();
+		}
+	}
+
+	void resp_thread()
+	{
+		while (true) {
+			tlm::tlm_generic_payload *trans;
+			tlm::tlm_phase phase = tlm::BEGIN_RESP;
+			sc_time delay = SC_ZERO_TIME;
+			tlm::tlm_sync_enum r;
+
+			while (m_resp_queue.empty()) {
+				wait(m_resp_event);
+			}
+
+			wait(20, SC_NS);
+
+			trans = m_resp_queue.front();
+			m_resp_queue.pop_front();
+
+			r = socket->nb_transport_bw(*trans, phase, delay);
+			if (r == tlm::TLM_COMPLETED) {
+				done(*trans);
+			}
+			// Otherwise END_RESP arrives on the forward path.
+		}
+	}
+
+	unsigned char m_mem[MEM_SIZE];
+
+	unsigned int m_max_outstanding;
+	unsigned int m_nr_txns;
+	unsigned int m_outstanding;
+	unsigned int m_max_seen;
+
+	std::deque<tlm::tlm_generic_payload*> m_req_queue;
+	std::deque<tlm::tlm_generic_payload*> m_resp_queue;
+	sc_event m_req_event;
+	sc_event m_resp_event;
+};
+
+static bool tg_done = false;
+
+static void tg_done_cb(TLMTrafficGenerator *gen, int threadID)
+{
+	tg_done = true;
+}
+
+int sc_main(int argc, char *argv[])
+{
+	TLMTrafficGenerator tg("tg");
+	nb_memory mem("mem", MAX_OUTSTANDING);
+	DataTransferVec merged = merge(transactions);
+	TrafficDesc xfers(merged);
+
+	tg.enableDebug();
+	tg.setNonBlocking(MAX_OUTSTANDING);
+	tg.addTransfers(xfers, 0, tg_done_cb);
+
+	tg.socket.bind(mem.socket);
+
+	sc_start(100, SC_MS);
+	sc_stop();
+
+	if (!tg_done) {
+		SC_REPORT_ERROR(TEST_ERROR, "Traffic generator did not finish");
+	}
+
+	if (mem.get_nr_txns() != merged.size()) {
+		SC_REPORT_ERROR(TEST_ERROR, "Transactions were lost");
+	}
+
+	if (mem.get_outstanding() != 0) {
+		SC_REPORT_ERROR(TEST_ERROR, "Transactions did not complete");
+	}
+
+	// Requests must have been pipelined, up to the limit.
+	if (mem.get_max_seen() < 2 || mem.get_max_seen() > MAX_OUTSTANDING) {
+		SC_REPORT_ERROR(TEST_ERROR, "Outstanding requests off limits");
+	}
+
+	// All transactions back in the pool, no more allocated than can
+	// be in flight.
+	if (tg.getTxnsFree() != tg.getTxnsAllocated()) {
+		SC_REPORT_ERROR(TEST_ERROR,
+			"Transactions not returned to the pool");
+	}
+	if (tg.getTxnsAllocated() > MAX_OUTSTANDING) {
+		SC_REPORT_ERROR(TEST_ERROR,
+			"Transactions allocated beyond the outstanding limit");
+	}
+
+	return 0;
+}
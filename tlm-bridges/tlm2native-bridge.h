@@ -27,6 +27,23 @@
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
+#include <string.h>
+#include <unordered_map>
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+//
+// Maps TLM accesses onto host memory. Addresses are offsets into mem (or
+// host pointers if mem is NULL) and size limits the address range (0 for
+// no limit).
+//
+// With sparse set the bridge instead models the address range with its own
+// backing store, allocated in 4 KiB pages the first time a page is written
+// (or a DMI pointer is handed out for it). Reads of untouched memory return
+// zeroes. mem is ignored in this mode.
+//
 class tlm2native_bridge
 : public sc_core::sc_module
 {
@@ -36,29 +53,51 @@ public:
 	SC_HAS_PROCESS(tlm2native_bridge);
 	tlm2native_bridge(sc_module_name name,
 			uint8_t *mem = NULL, uint64_t size = 0,
-			sc_time latency = SC_ZERO_TIME);
+			sc_time latency = SC_ZERO_TIME,
+			bool sparse = false);
+	~tlm2native_bridge();
 
 private:
+	enum { PAGE_BITS = 12,
+		PAGE_SIZE = 1 << PAGE_BITS };
+
 	virtual void b_transport(tlm::tlm_generic_payload& trans,
 			sc_time& delay);
 	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
 			tlm::tlm_dmi& dmi_data);
 	virtual unsigned int transport_dbg(tlm::tlm_generic_payload& trans);
 
+	void access(bool is_read, uint64_t addr, unsigned char *ptr,
+			unsigned int len, unsigned char *be,
+			unsigned int be_len, unsigned int be_pos);
+	uint8_t *get_page(uint64_t addr, bool alloc);
+
+	static void copy(uint8_t *dst, const uint8_t *src, unsigned int len,
+			const unsigned char *be, unsigned int be_len,
+			unsigned int be_pos);
 
 	uint8_t *mem;
 	uint64_t size;
 	sc_time latency;
+
+	// Sparse backing store, pages indexed by address >> PAGE_BITS
+	bool sparse;
+	std::unordered_map<uint64_t, uint8_t *> pages;
+	uint64_t last_page_nr;
+	uint8_t *last_page;
 };
 
 tlm2native_bridge::tlm2native_bridge(sc_module_name name,
 				     uint8_t *mem, uint64_t size,
-				     sc_time latency) :
+				     sc_time latency, bool sparse) :
 	sc_module(name),
 	target_socket("target-socket"),
 	mem(mem),
 	size(size),
-	latency(latency)
+	latency(latency),
+	sparse(sparse),
+	last_page_nr(0),
+	last_page(NULL)
 {
 	target_socket.register_b_transport(this,
 			&tlm2native_bridge::b_transport);
@@ -68,6 +107,138 @@ tlm2native_bridge::tlm2native_bridge(sc_module_name name,
 			&tlm2native_bridge::get_direct_mem_ptr);
 }
 
+tlm2native_bridge::~tlm2native_bridge()
+{
+	std::unordered_map<uint64_t, uint8_t *>::iterator it;
+
+	for (it = pages.begin(); it != pages.end(); it++) {
+		delete[] it->second;
+	}
+}
+
+//
+// Returns the backing page holding addr. Untouched pages are allocated
+// (zeroed) if alloc is set, else NULL is returned.
+//
+uint8_t *tlm2native_bridge::get_page(uint64_t addr, bool alloc)
+{
+	uint64_t page_nr = addr >> PAGE_BITS;
+	std::unordered_map<uint64_t, uint8_t *>::iterator it;
+	uint8_t *page;
+
+	if (last_page && last_page_nr == page_nr) {
+		return last_page;
+	}
+
+	it = pages.find(page_nr);
+	if (it != pages.end()) {
+		page = it->second;
+	} else if (alloc) {
+		page = new uint8_t[PAGE_SIZE]();
+		pages[page_nr] = page;
+	} else {
+		return NULL;
+	}
+
+	last_page_nr = page_nr;
+	last_page = page;
+	return page;
+}
+
+//
+// Copies len bytes from src to dst, only the bytes with enabled byte
+// enables if be_len is set (be_pos being the byte enable of the first
+// byte). The byte enables are applied 8 bytes at a time by blending
+// 64 bit words.
+//
+void tlm2native_bridge::copy(uint8_t *dst, const uint8_t *src,
+				unsigned int len, const unsigned char *be,
+				unsigned int be_len, unsigned int be_pos)
+{
+	unsigned int i = 0;
+
+	if (!be_len) {
+		memcpy(dst, src, len);
+		return;
+	}
+
+	for (; i + 8 <= len; i += 8) {
+		uint8_t m8[8];
+		uint64_t m, d, s;
+		unsigned int j;
+
+		for (j = 0; j < 8; j++) {
+			m8[j] = be[be_pos] == TLM_BYTE_ENABLED ? 0xff : 0;
+			if (++be_pos == be_len) {
+				be_pos = 0;
+			}
+		}
+		memcpy(&m, m8, 8);
+
+		if (m == 0) {
+			continue;
+		} else if (m == ~(uint64_t)0) {
+			memcpy(dst + i, src + i, 8);
+			continue;
+		}
+
+		memcpy(&d, dst + i, 8);
+		memcpy(&s, src + i, 8);
+		d = (d & ~m) | (s & m);
+		memcpy(dst + i, &d, 8);
+	}
+
+	for (; i < len; i++) {
+		if (be[be_pos] == TLM_BYTE_ENABLED) {
+			dst[i] = src[i];
+		}
+		if (++be_pos == be_len) {
+			be_pos = 0;
+		}
+	}
+}
+
+//
+// Accesses len consecutive bytes at addr.
+//
+void tlm2native_bridge::access(bool is_read, uint64_t addr,
+				unsigned char *ptr, unsigned int len,
+				unsigned char *be, unsigned int be_len,
+				unsigned int be_pos)
+{
+	static const uint8_t zero_page[PAGE_SIZE] = { 0 };
+
+	if (!sparse) {
+		if (is_read) {
+			copy(ptr, &mem[addr], len, be, be_len, be_pos);
+		} else {
+			copy(&mem[addr], ptr, len, be, be_len, be_pos);
+		}
+		return;
+	}
+
+	while (len) {
+		unsigned int offset = addr & (PAGE_SIZE - 1);
+		unsigned int n = MIN(len, PAGE_SIZE - offset);
+		uint8_t *page = get_page(addr, !is_read);
+
+		if (is_read) {
+			const uint8_t *src = page ? page : zero_page;
+
+			copy(ptr, &src[offset], n, be, be_len, be_pos);
+		} else {
+			copy(&page[offset], ptr, n, be, be_len, be_pos);
+		}
+
+		addr += n;
+		ptr += n;
+		len -= n;
+		if (be_len) {
+			be_pos = (be_pos + n) % be_len;
+		}
+	}
+}
+
 void tlm2native_bridge::b_transport(tlm::tlm_generic_payload& trans,
 				sc_time& delay)
 {
@@ -90,29 +261,19 @@ void tlm2native_bridge::b_transport(tlm::tlm_generic_payload& trans,
 		return;
 	}
 
-	if (be_len || streaming_width) {
-		// Slow path.
+	if (cmd == tlm::TLM_READ_COMMAND || cmd == tlm::TLM_WRITE_COMMAND) {
+		bool is_read = cmd == tlm::TLM_READ_COMMAND;
 		unsigned int pos;
 
-		for (pos = 0; pos < len; pos++) {
-			bool do_access = true;
-
-			if (be_len) {
-				do_access = be[pos % be_len] == TLM_BYTE_ENABLED;
-			}
-			if (do_access) {
-				if (trans.is_read()) {
-					ptr[pos] = mem[addr + (pos % streaming_width)];
-				} else {
-					mem[addr + (pos % streaming_width)] = ptr[pos];
-				}
-			}
+		//
+		// Each streaming_width sized beat accesses the same addresses,
+		// without streaming and byte enables this is a single memcpy.
+		//
+		for (pos = 0; pos < len; pos += streaming_width) {
+			access(is_read, addr, &ptr[pos],
+				MIN(streaming_width, len - pos),
+				be, be_len, be_len ? pos % be_len : 0);
 		}
-	} else {
-		if (trans.get_command() == tlm::TLM_READ_COMMAND)
-			memcpy(ptr, &mem[addr], len);
-		else if (cmd == tlm::TLM_WRITE_COMMAND)
-			memcpy(&mem[addr], ptr, len);
 	}
 
 	delay += latency;
@@ -128,9 +289,23 @@ bool tlm2native_bridge::get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
 
 	dmi_data.allow_read_write();
 
-	dmi_data.set_dmi_ptr(mem);
-	dmi_data.set_start_address(0);
-	dmi_data.set_end_address(end_addr);
+	if (sparse) {
+		uint64_t addr = trans.get_address();
+		uint64_t start = addr & ~((uint64_t) PAGE_SIZE - 1);
+
+		if (size > 0 && addr >= size) {
+			return false;
+		}
+
+		// One page at a time
+		dmi_data.set_dmi_ptr(get_page(addr, true));
+		dmi_data.set_start_address(start);
+		dmi_data.set_end_address(MIN(end_addr, start + PAGE_SIZE - 1));
+	} else {
+		dmi_data.set_dmi_ptr(mem);
+		dmi_data.set_start_address(0);
+		dmi_data.set_end_address(end_addr);
+	}
 	/* Latencies are per byte.  Our latency is expressed per access,
 	   which are in 32bits so dividie by 4. Is there a better way?.  */
 	dmi_data.set_read_latency(latency / 4);
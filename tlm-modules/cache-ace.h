@@ -38,12 +38,18 @@
 #include "tlm_utils/simple_target_socket.h"
 #include "tlm-extensions/genattr.h"
 #include "tlm-bridges/amba.h"
+#include "tlm-modules/private/cache-sets.h"
 
 using namespace AMBA::ACE;
 
 enum WritePolicy { WriteBack, WriteThrough };
 
-template<int CACHE_SZ, int CACHELINE_SZ = 64>
+//
+// NUM_WAYS selects the associativity (1 is direct mapped) and REPLACEMENT
+// the ReplacementPolicy used for choosing the way to refill.
+//
+template<int CACHE_SZ, int CACHELINE_SZ = 64,
+	int NUM_WAYS = 1, int REPLACEMENT = ReplaceLRU>
 class cache_ace :
 	public sc_core::sc_module
 {
@@ -85,6 +91,8 @@ public:
 		add_nonshareable_region(start, len);
 	}
 
+	CacheStats& get_stats() { return m_cache->get_stats(); }
+
 private:
 	class NonShareableRegion
 	{
@@ -110,7 +118,11 @@ private:
 	class IACECache
 	{
 	public:
-		enum { NUM_CACHELINES = CACHE_SZ / CACHELINE_SZ };
+		enum { NUM_CACHELINES = CACHE_SZ / CACHELINE_SZ,
+			NUM_SETS = NUM_CACHELINES / NUM_WAYS };
+
+		static_assert(NUM_CACHELINES % NUM_WAYS == 0,
+				"The cachelines must divide evenly into the ways");
 
 		struct CacheLine
 		{
@@ -399,6 +411,8 @@ private:
 		{
 			assert(l);
 
+			m_stats.evictions++;
+
 			if (l->dirty && get_toggle()) {
 				writeclean(l, gp);
 			}
@@ -980,17 +994,51 @@ private:
 
 		inline uint64_t get_index(uint64_t tag)
 		{
-			return (tag % CACHE_SZ) / CACHELINE_SZ;
+			return (tag / CACHELINE_SZ) % NUM_SETS;
 		}
 
+		//
+		// Returns the way holding addr if it is in the set, else the
+		// way to refill: the first invalid one or the victim chosen by
+		// the replacement policy.
+		//
 		CacheLine *get_line(uint64_t addr)
 		{
 			uint64 tag = get_tag(addr);
 			unsigned int index = get_index(tag);
+			CacheLine *set = &m_cacheline[index * NUM_WAYS];
+			int way;
 
-			return &m_cacheline[index];
+			for (way = 0; way < NUM_WAYS; way++) {
+				if (set[way].valid && set[way].tag == tag) {
+					return &set[way];
+				}
+			}
+
+			for (way = 0; way < NUM_WAYS; way++) {
+				if (!set[way].valid) {
+					return &set[way];
+				}
+			}
+
+			return &set[m_replacement.GetVictim(index)];
 		}
 
+		//
+		// Mark the line of addr as accessed for the replacement
+		// policy
+		//
+		void touch_line(uint64_t addr)
+		{
+			unsigned int index = get_index(get_tag(addr));
+			CacheLine *l = get_line(addr);
+
+			m_replacement.Touch(index,
+					l - &m_cacheline[index * NUM_WAYS]);
+		}
+
+		CacheStats& get_stats() { return m_stats; }
+
 		bool in_cache(uint64_t addr, bool is_secure)
 		{
 			uint64 tag = get_tag(addr);
@@ -1301,6 +1349,8 @@ private:
 		sc_event m_write_done_event;
 		bool m_toggle;
 		MasterExclusiveMonitor m_monitor;
+		CacheReplacement<NUM_SETS, NUM_WAYS, REPLACEMENT> m_replacement;
+		CacheStats m_stats;
 	};
 
 	class ACECacheWriteBack : public IACECache
@@ -1318,16 +1368,32 @@ private:
 			bool exclusive = this->is_exclusive(gp);
 			bool exclusive_failed = false;
 			bool is_secure = this->get_secure(gp);
+			int miss_pos = -1;
 
 			while (pos < len) {
 				if (this->in_cache(addr, is_secure)) {
-					unsigned int n = this->read_line(gp, pos);
+					unsigned int n;
+
+					//
+					// Don't count a line found after
+					// refilling it as a hit
+					//
+					if ((int) pos != miss_pos) {
+						this->m_stats.hits++;
+					}
+
+					this->touch_line(addr);
+
+					n = this->read_line(gp, pos);
 					pos+=n;
 					addr+=n;
 				} else {
 					bool do_read_shared = 
 						exclusive || this->get_toggle();
 
+					this->m_stats.misses++;
+					miss_pos = pos;
+
 					//
 					// toggle between read_shared /
 					// read_not_shared_dirty if not
@@ -1363,6 +1429,7 @@ private:
 			unsigned int pos = 0;
 			bool exclusive = this->is_exclusive(gp);
 			bool is_secure = this->get_secure(gp);
+			int miss_pos = -1;
 
 			while (pos < len) {
 				if (exclusive &&
@@ -1371,6 +1438,17 @@ private:
 				}
 
 				if (this->in_cache(addr, is_secure)){
+					//
+					// Lines needing an upgrade (CleanUnique)
+					// are counted once, as hits
+					//
+					if ((int) pos != miss_pos) {
+						this->m_stats.hits++;
+						miss_pos = pos;
+					}
+
+					this->touch_line(addr);
+
 					if (this->is_unique(addr)) {
 						unsigned int n = this->write_line(gp, pos);
 
@@ -1405,6 +1483,9 @@ private:
 				} else {
 					unsigned int n;
 
+					this->m_stats.misses++;
+					miss_pos = pos;
+
 					n = this->to_write(gp, pos);
 
 					if (n == CACHELINE_SZ) {
@@ -1436,13 +1517,25 @@ private:
 			uint64_t addr = gp.get_address();
 			unsigned int len = gp.get_data_length();
 			unsigned int pos = 0;
+			int miss_pos = -1;
 
 			while (pos < len) {
 				if (this->in_cache(addr, is_secure)) {
-					unsigned int n = this->read_line(gp, pos);
+					unsigned int n;
+
+					if ((int) pos != miss_pos) {
+						this->m_stats.hits++;
+					}
+
+					this->touch_line(addr);
+
+					n = this->read_line(gp, pos);
 					pos+=n;
 					addr+=n;
 				} else {
+					this->m_stats.misses++;
+					miss_pos = pos;
+
 					this->read_clean(gp, addr);
 				}
 			}
@@ -1455,6 +1548,8 @@ private:
 
 		void handle_store(tlm::tlm_generic_payload& gp)
 		{
+			bool is_secure = this->get_secure(gp);
+			uint64_t addr = gp.get_address();
 			unsigned int len = gp.get_data_length();
 			unsigned int pos = 0;
 
@@ -1462,6 +1557,17 @@ private:
 				unsigned int n = this->to_write(gp, pos);
 				bool do_write_line_unique =  false;
 
+				//
+				// Lines are never allocated on a store, a hit
+				// only updates the line already in the cache
+				//
+				if (this->in_cache(addr, is_secure)) {
+					this->m_stats.hits++;
+					this->touch_line(addr);
+				} else {
+					this->m_stats.misses++;
+				}
+
 				//
 				// Do WriteLineUnique if it is a cacheline
 				// sized transaction with no sparse wstrb
@@ -1477,6 +1583,7 @@ private:
 				}
 
 				pos+=n;
+				addr+=n;
 			}
 
 			// Exclusive not supported
@@ -1636,6 +1743,13 @@ private:
 		if (genattr) {
 			bool res = false;
 
+			if (genattr->get_snoop() != AC::DVMMessage &&
+				genattr->get_snoop() != AC::DVMComplete &&
+				m_cache->in_cache(gp.get_address(),
+						genattr->get_secure())) {
+				m_cache->get_stats().snoop_hits++;
+			}
+
 			switch (genattr->get_snoop()) {
 			case AC::ReadOnce:
 				res = m_cache->handle_readonce(gp);
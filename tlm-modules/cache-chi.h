@@ -38,20 +38,31 @@
 #include "tlm-extensions/chiattr.h"
 #include "tlm-bridges/amba-chi.h"
 #include "tlm-modules/private/chi/txnids.h"
+#include "tlm-modules/private/cache-sets.h"
 #include "tlm-modules/private/chi/cacheline.h"
 #include "tlm-modules/private/chi/txns-rn.h"
 
 using namespace AMBA::CHI;
 
+//
+// NUM_WAYS selects the associativity (1 is direct mapped) and REPLACEMENT
+// the ReplacementPolicy used for choosing the way to refill.
+//
 template<
 	int NODE_ID,
 	int CACHE_SZ,
-	int ICN_ID = 20>
+	int ICN_ID = 20,
+	int NUM_WAYS = 1,
+	int REPLACEMENT = ReplaceLRU>
 class cache_chi :
 	public sc_core::sc_module
 {
 private:
-	enum { NUM_CACHELINES = CACHE_SZ / CACHELINE_SZ };
+	enum { NUM_CACHELINES = CACHE_SZ / CACHELINE_SZ,
+		NUM_SETS = NUM_CACHELINES / NUM_WAYS };
+
+	static_assert(NUM_CACHELINES % NUM_WAYS == 0,
+			"The cachelines must divide evenly into the ways");
 
 	typedef RN::CacheLine CacheLine;
 	typedef RN::ITxn<NODE_ID, ICN_ID> ITxn;
@@ -184,7 +195,7 @@ private:
 			} else if (t->TransmitOnTxRspChannel()) {
 				m_txRspChannel.Process(t);
 			} else if (t->Done()) {
-				delete t;
+				t->Release();
 			}
 
 			// Else the txn is waiting on the rx channels
@@ -240,15 +251,48 @@ private:
 
 		inline uint64_t get_index(uint64_t tag)
 		{
-			return (tag % CACHE_SZ) / CACHELINE_SZ;
+			return (tag / CACHELINE_SZ) % NUM_SETS;
 		}
 
+		//
+		// Returns the way holding addr if it is in the set, else the
+		// way to refill: the first invalid one or the victim chosen by
+		// the replacement policy.
+		//
 		CacheLine *get_line(uint64_t addr)
 		{
 			uint64 tag = get_tag(addr);
 			unsigned int index = get_index(tag);
+			CacheLine *set = &m_cacheline[index * NUM_WAYS];
+			int way;
 
-			return &m_cacheline[index];
+			for (way = 0; way < NUM_WAYS; way++) {
+				if (set[way].IsValid() &&
+					set[way].GetTag() == tag) {
+					return &set[way];
+				}
+			}
+
+			for (way = 0; way < NUM_WAYS; way++) {
+				if (!set[way].IsValid()) {
+					return &set[way];
+				}
+			}
+
+			return &set[m_replacement.GetVictim(index)];
+		}
+
+		//
+		// Mark the line of addr as accessed for the replacement
+		// policy
+		//
+		void touch_line(uint64_t addr)
+		{
+			unsigned int index = get_index(get_tag(addr));
+			CacheLine *l = get_line(addr);
+
+			m_replacement.Touch(index,
+					l - &m_cacheline[index * NUM_WAYS]);
 		}
 
 		// Tag must have been checked before calling this function
@@ -536,6 +580,10 @@ private:
 		void InvalidateCacheLine(CacheLine *l,
 					tlm::tlm_generic_payload& gp)
 		{
+			if (l->IsValid()) {
+				m_stats.evictions++;
+			}
+
 			//
 			// Sometimes do a WriteCleanFull first
 			//
@@ -600,9 +648,11 @@ private:
 
 			//
 			// Line might be in the cache but not with fillgrade
-			// full
+			// full. ReadOnce does not allocate so only a line
+			// holding the same tag is invalidated, never a victim
+			// way of the set.
 			//
-			if (l->IsValid()) {
+			if (l->IsValid() && l->GetTag() == get_tag(addr)) {
 				InvalidateCacheLine(l, gp);
 			}
 
@@ -737,7 +787,7 @@ private:
 				// received.
 				//
 				if (m_receivedDVM[txnID]) {
-					SnpRespTxn *t = new SnpRespTxn(gp);
+					SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 					m_receivedDVM[txnID] = false;
 
@@ -747,6 +797,8 @@ private:
 					m_receivedDVM[txnID] = true;
 				}
 			} else if (InCache(addr, nonSecure)) {
+				m_stats.snoop_hits++;
+
 				switch(chiattr->GetOpcode()) {
 				case Snp::SnpOnce:
 					HandleSnpOnce(gp, chiattr);
@@ -805,7 +857,7 @@ private:
 				}
 
 			} else {
-				SnpRespTxn *t = new SnpRespTxn(gp);
+				SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 				t->SetSnpResp(INV);
 				m_txRspChannel.Process(t);
@@ -819,7 +871,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -871,7 +923,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -939,7 +991,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -997,7 +1049,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1058,7 +1110,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1110,7 +1162,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			//
 			// Invalidate line
@@ -1127,7 +1179,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1204,7 +1256,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			//
 			// Invalidate line
@@ -1225,7 +1277,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1283,7 +1335,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1331,7 +1383,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1390,7 +1442,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1479,7 +1531,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1569,7 +1621,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1659,7 +1711,7 @@ private:
 				chiattr_extension *chiattr)
 		{
 			CacheLine *l = get_line(gp.get_address());
-			SnpRespTxn *t = new SnpRespTxn(gp);
+			SnpRespTxn *t = m_snpRespPool.Get(gp);
 
 			switch (l->GetStatus()) {
 			case UC:
@@ -1717,6 +1769,13 @@ private:
 
 		CacheLine *GetCacheLine() { return m_cacheline; }
 
+		CacheStats& GetStats() { return m_stats; }
+
+		ObjPool<SnpRespTxn, ITxn>& GetSnpRespPool()
+		{
+			return m_snpRespPool;
+		}
+
 		bool GetRandomBool()
 		{
 			if (m_randomize == false) {
@@ -1865,6 +1924,15 @@ private:
 
 		LPExclusiveMonitor m_monitor;
 		bool m_receivedDVM[TxnIDs::NumIDs];
+
+		CacheReplacement<NUM_SETS, NUM_WAYS, REPLACEMENT> m_replacement;
+		CacheStats m_stats;
+
+		//
+		// Snoop responses are recycled instead of allocated per
+		// snoop (owned per cache since ITxn contains an sc_event)
+		//
+		ObjPool<SnpRespTxn, ITxn> m_snpRespPool;
 	};
 
 	class CacheWriteBack : public ICache
@@ -1905,15 +1973,31 @@ private:
 			unsigned int pos = 0;
 			bool exclusive = this->IsExclusive(gp);
 			bool exclusive_failed = false;
+			int missPos = -1;
 
 			while (pos < len) {
 				if (this->InCache(addr, nonSecure, true)) {
-					unsigned int n = this->ReadLine(gp, pos);
+					unsigned int n;
+
+					//
+					// Don't count a line found after
+					// refilling it as a hit
+					//
+					if ((int) pos != missPos) {
+						this->m_stats.hits++;
+					}
+
+					this->touch_line(addr);
+
+					n = this->ReadLine(gp, pos);
 					pos+=n;
 					addr+=n;
 				} else {
 					int randomInt = this->GetRandomInt(6);
 
+					this->m_stats.misses++;
+					missPos = pos;
+
 					//
 					// Randomize between different reads if not
 					// exclusive. Exclusive loads always use
@@ -1975,6 +2059,7 @@ private:
 			unsigned int len = gp.get_data_length();
 			unsigned int pos = 0;
 			bool exclusive = this->IsExclusive(gp);
+			int missPos = -1;
 
 			while (pos < len) {
 				if (exclusive &&
@@ -1983,6 +2068,17 @@ private:
 				}
 
 				if (this->InCache(addr, nonSecure)){
+					//
+					// Lines needing an upgrade (CleanUnique)
+					// are counted once, as hits
+					//
+					if ((int) pos != missPos) {
+						this->m_stats.hits++;
+						missPos = pos;
+					}
+
+					this->touch_line(addr);
+
 					if (this->IsUnique(addr)) {
 						unsigned int n = this->WriteLine(gp, pos);
 
@@ -2012,6 +2108,9 @@ private:
 
 					int randomInt = this->GetRandomInt(2);
 
+					this->m_stats.misses++;
+					missPos = pos;
+
 					//
 					// Make sure to use an operation that
 					// puts the line in unique state if
@@ -2419,6 +2518,22 @@ public:
 	void SetSeed(unsigned int seed) { m_cache->SetSeed(seed); }
 	unsigned int GetSeed() { return m_cache->GetSeed(); }
 
+	CacheStats& GetStats() { return m_cache->GetStats(); }
+
+	//
+	// Snoop responses allocated on the heap (the rest were recycled)
+	// out of the total number of snoops answered.
+	//
+	uint64_t GetSnpRespAllocs()
+	{
+		return m_cache->GetSnpRespPool().GetAllocs();
+	}
+
+	uint64_t GetSnpRespRequests()
+	{
+		return m_cache->GetSnpRespPool().GetGets();
+	}
+
 	void CreateNonShareableRegion(uint64_t start, unsigned int len)
 	{
 		AddNonShareableRegion(start, len);
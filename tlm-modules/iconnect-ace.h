@@ -31,6 +31,8 @@
 
 #include <sstream>
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 #include "tlm.h"
 #include "tlm_utils/simple_initiator_socket.h"
@@ -41,7 +43,8 @@
 template<
 	int NUM_ACE_MASTERS = 2,
 	int NUM_ACELITE_MASTERS = 1,
-	int CACHELINE_SZ = 64>
+	int CACHELINE_SZ = 64,
+	int NUM_DS_PORTS = 1>
 class iconnect_ace : public sc_core::sc_module
 {
 public:
@@ -774,6 +777,248 @@ public:
 		sc_fifo<Transaction*> m_downstream_fifo;
 	};
 
+	//
+	// Routes transactions to the downstream ports, interleaving the
+	// address space across them in m_granule sized blocks (default
+	// 4 KB, so AXI bursts never cross a block). Incrementing
+	// transactions that cross a block are split up and the pieces are
+	// issued in parallel on their ports. Others (fixed bursts, repeated
+	// byte enables) go to the port of their start address.
+	//
+	class DownstreamRouter
+	{
+	public:
+		DownstreamRouter() :
+			m_granule(4 * 1024)
+		{}
+
+		void set_port(int i, DownstreamPort *ds_port)
+		{
+			m_ds_port[i] = ds_port;
+		}
+
+		void process(Transaction *tr)
+		{
+			if (NUM_DS_PORTS > 1 && do_split(tr)) {
+				sc_spawn(sc_bind(&DownstreamRouter::split_thread,
+						this, tr));
+			} else {
+				m_ds_port[get_port(tr->GetAddress())]->process(tr);
+			}
+		}
+
+		//
+		// granule must be a power of 2 and at least a cacheline
+		//
+		void set_interleave(unsigned int granule)
+		{
+			assert(granule >= CACHELINE_SZ);
+			assert((granule & (granule - 1)) == 0);
+
+			m_granule = granule;
+		}
+
+		int get_port(uint64_t addr)
+		{
+			return (addr / m_granule) % NUM_DS_PORTS;
+		}
+
+	private:
+		bool do_split(Transaction *tr)
+		{
+			tlm::tlm_generic_payload& gp = tr->GetGP();
+			uint64_t addr = gp.get_address();
+			unsigned int len = gp.get_data_length();
+			unsigned int be_len = gp.get_byte_enable_length();
+
+			if (len == 0 ||
+				addr / m_granule == (addr + len - 1) / m_granule) {
+				return false;
+			}
+
+			return gp.get_streaming_width() >= len &&
+				(be_len == 0 || be_len == len);
+		}
+
+		void split_thread(Transaction *tr)
+		{
+			tlm::tlm_generic_payload& gp = tr->GetGP();
+			uint64_t addr = gp.get_address();
+			unsigned int len = gp.get_data_length();
+			unsigned char *be = gp.get_byte_enable_ptr();
+			unsigned int be_len = gp.get_byte_enable_length();
+			std::vector<tlm::tlm_generic_payload*> pieces;
+			std::vector<Transaction*> piece_trs;
+			tlm::tlm_response_status status = tlm::TLM_OK_RESPONSE;
+			genattr_extension *genattr;
+			sc_event all_done;
+			unsigned int pending;
+			unsigned int pos = 0;
+			unsigned int i;
+
+			while (pos < len) {
+				tlm::tlm_generic_payload *p =
+					new tlm::tlm_generic_payload();
+				uint64_t piece_addr = addr + pos;
+				unsigned int piece_len =
+					m_granule - (piece_addr & (m_granule - 1));
+
+				if (piece_len > len - pos) {
+					piece_len = len - pos;
+				}
+
+				p->set_command(gp.get_command());
+				p->set_address(piece_addr);
+				p->set_data_ptr(gp.get_data_ptr() + pos);
+				p->set_data_length(piece_len);
+				p->set_streaming_width(piece_len);
+				if (be_len) {
+					p->set_byte_enable_ptr(be + pos);
+					p->set_byte_enable_length(piece_len);
+				}
+				p->set_dmi_allowed(false);
+				p->set_response_status(
+					tlm::TLM_INCOMPLETE_RESPONSE);
+
+				gp.get_extension(genattr);
+				if (genattr) {
+					genattr_extension *attr =
+						new genattr_extension();
+
+					attr->copy_from(*genattr);
+					p->set_extension(attr);
+				}
+
+				pieces.push_back(p);
+				piece_trs.push_back(new Transaction(*p,
+							tr->GetPortID()));
+
+				pos += piece_len;
+			}
+
+			//
+			// A port's fifo may be full, so the pieces are issued from
+			// processes of their own. Pieces can then complete while
+			// others are still waiting to be queued, so count rather
+			// than wait on each done event.
+			//
+			pending = piece_trs.size();
+			for (i = 0; i < piece_trs.size(); i++) {
+				sc_spawn(sc_bind(&DownstreamRouter::piece_thread,
+						this, piece_trs[i], &pending,
+						&all_done));
+			}
+
+			while (pending) {
+				sc_core::wait(all_done);
+			}
+
+			//
+			// The original transaction is exclusive okay only if all
+			// its pieces are, the other response attributes are
+			// or:ed together.
+			//
+			gp.get_extension(genattr);
+			if (genattr) {
+				genattr->set_exclusive_handled(true);
+				genattr->set_error_bit(false);
+				genattr->set_shared(false);
+				genattr->set_dirty(false);
+				genattr->set_was_unique(false);
+			}
+
+			for (i = 0; i < piece_trs.size(); i++) {
+				genattr_extension *attr;
+
+				if (pieces[i]->is_response_error()) {
+					status = pieces[i]->get_response_status();
+				}
+
+				pieces[i]->get_extension(attr);
+				if (genattr && attr) {
+					merge_response(genattr, attr);
+				}
+
+				delete piece_trs[i];
+				// Also deletes the extension
+				delete pieces[i];
+			}
+
+			tr->SetTLMResponse(status);
+			tr->DoneEvent().notify();
+		}
+
+		void piece_thread(Transaction *t, unsigned int *pending,
+					sc_event *all_done)
+		{
+			m_ds_port[get_port(t->GetAddress())]->process(t);
+
+			//
+			// The port reads the piece in a later delta cycle, so it
+			// can't have completed before this wait.
+			//
+			sc_core::wait(t->DoneEvent());
+
+			if (--(*pending) == 0) {
+				all_done->notify();
+			}
+		}
+
+		void merge_response(genattr_extension *genattr,
+					genattr_extension *attr)
+		{
+			genattr->set_exclusive_handled(
+					genattr->get_exclusive_handled() &&
+					attr->get_exclusive_handled());
+			genattr->set_error_bit(genattr->get_error_bit() ||
+						attr->get_error_bit());
+			genattr->set_shared(genattr->get_shared() ||
+						attr->get_shared());
+			genattr->set_dirty(genattr->get_dirty() ||
+						attr->get_dirty());
+			genattr->set_was_unique(genattr->get_was_unique() ||
+						attr->get_was_unique());
+		}
+
+		DownstreamPort *m_ds_port[NUM_DS_PORTS];
+		unsigned int m_granule;
+	};
+
+	//
+	// Counters for transactions stalled behind ongoing transactions to
+	// the same cachelines.
+	//
+	struct overlap_stats
+	{
+		overlap_stats() { reset(); }
+
+		void reset()
+		{
+			transactions = 0;
+			stalls = 0;
+			stall_time = SC_ZERO_TIME;
+			max_stall_time = SC_ZERO_TIME;
+			max_stalled = 0;
+		}
+
+		// Transactions processed / that had to wait
+		uint64_t transactions;
+		uint64_t stalls;
+
+		// Total and longest time waited
+		sc_time stall_time;
+		sc_time max_stall_time;
+
+		// Most transactions waiting at the same time
+		unsigned int max_stalled;
+	};
+
+	//
+	// Snooping transactions to a cacheline with an ongoing transaction
+	// (or with transactions already waiting) wait in a per cacheline
+	// FIFO. The cachelines are kept in a hash table and a completing
+	// transaction only looks at the FIFOs of its own cachelines.
+	//
 	class OverlappingTxOrderer :
 		public sc_core::sc_module
 	{
@@ -782,46 +1027,79 @@ public:
 
 		OverlappingTxOrderer(sc_core::sc_module_name name,
 				ISnoopEngine *snoop_engine,
-				DownstreamPort& ds_port) :
+				DownstreamRouter& ds_port) :
 			sc_core::sc_module(name),
 			m_snoop_engine(snoop_engine),
-			m_ds_port(ds_port)
+			m_ds_port(ds_port),
+			m_num_stalled(0)
 		{}
 
 		void process(Transaction& trans)
 		{
-			if (trans.IsSnoopingTransaction()) {
-				if (is_overlapping(trans) && !trans.IsDVM()) {
+			bool is_dvm = trans.IsDVM();
+
+			m_stats.transactions++;
+
+			if (trans.IsSnoopingTransaction() && !is_dvm) {
+				line_entry *blocking = blocking_line(trans);
+
+				if (blocking) {
 					//
-					// This cacheline is already being processed,
-					// wait for that tx to complete.
+					// This cacheline is already being
+					// processed, wait for that tx to
+					// complete.
 					//
-					to_overlapping(&trans);
+					stall(blocking, waiter(&trans));
 				} else {
-					//
-					// Start processing snoop transaction
-					//
-					to_snoop_engine(&trans);
-					m_ongoing_tx.push_back(&trans);
+					start(&trans);
 				}
+			} else if (is_dvm) {
+				//
+				// DVM addresses are not memory addresses,
+				// nothing to order against.
+				//
+				to_snoop_engine(&trans);
 			} else {
 				//
 				// No snooping transaction, forward it to the
 				// downstream port.
 				//
-				to_downstream_port(&trans);
-				m_ongoing_tx.push_back(&trans);
-
+				start(&trans);
 			}
 
 			wait(trans.DoneEvent());
 
-			m_ongoing_tx.remove(&trans);
-
-			restart_overlapping(trans);
+			if (!is_dvm) {
+				release(trans);
+			}
 		}
 
+		overlap_stats& get_stats() { return m_stats; }
+
 	private:
+		struct waiter
+		{
+			waiter(Transaction *tr) :
+				tr(tr),
+				since(sc_time_stamp())
+			{}
+
+			Transaction *tr;
+			sc_time since;
+		};
+
+		struct line_entry
+		{
+			line_entry() : ongoing(0) {}
+
+			// Transactions started on the cacheline
+			unsigned int ongoing;
+
+			std::list<waiter> waiting;
+		};
+
+		typedef std::unordered_map<uint64_t, line_entry> line_map;
+
 		inline void to_snoop_engine(Transaction *trans)
 		{
 			m_snoop_engine->process(trans);
@@ -832,85 +1110,135 @@ public:
 			m_ds_port.process(trans);
 		}
 
-		inline void to_overlapping(Transaction *trans)
+		inline uint64_t first_line(Transaction& tr)
 		{
-			m_overlapping_tx.push_back(trans);
+			return tr.GetAddress() / CACHELINE_SZ;
 		}
 
-		bool is_overlapping(Transaction& tr)
+		inline uint64_t last_line(Transaction& tr)
 		{
-			uint64_t addr = tr.GetAddress();
-			uint64_t last_addr = addr + tr.GetDataLen()-1;
+			unsigned int len = tr.GetDataLen();
 
-			for (typename std::list<Transaction*>::iterator it = m_ongoing_tx.begin();
-				it != m_ongoing_tx.end(); it++) {
-				Transaction *ongoing_tr = (*it);
+			return (tr.GetAddress() + (len ? len - 1 : 0)) /
+					CACHELINE_SZ;
+		}
 
-				if (ongoing_tr->InAddressRange(addr) ||
-					ongoing_tr->InAddressRange(last_addr) ||
-					tr.InAddressRange(ongoing_tr->GetAddress()) ) {
-					return true;
+		//
+		// Returns the entry of the first cacheline of tr that is busy
+		// (ongoing or waiting transactions), skipping cacheline skip.
+		//
+		line_entry *blocking_line(Transaction& tr,
+					uint64_t skip = UINT64_MAX)
+		{
+			uint64_t last = last_line(tr);
+			uint64_t line;
+
+			for (line = first_line(tr); line <= last; line++) {
+				typename line_map::iterator it;
+
+				if (line == skip) {
+					continue;
+				}
+
+				it = m_lines.find(line);
+				if (it != m_lines.end() &&
+					(it->second.ongoing ||
+					 !it->second.waiting.empty())) {
+					return &it->second;
 				}
 			}
+			return NULL;
+		}
 
-			return false;
+		void start(Transaction *tr)
+		{
+			uint64_t last = last_line(*tr);
+			uint64_t line;
+
+			for (line = first_line(*tr); line <= last; line++) {
+				m_lines[line].ongoing++;
+			}
+
+			if (tr->IsSnoopingTransaction()) {
+				to_snoop_engine(tr);
+			} else {
+				to_downstream_port(tr);
+			}
 		}
 
-		void restart_overlapping(Transaction& tr)
+		void stall(line_entry *e, const waiter& w)
 		{
-			uint64_t addr = tr.GetAddress();
-			uint64_t last_addr = addr + tr.GetDataLen()-1;
-			typename std::list<Transaction*>::iterator it = m_overlapping_tx.begin();
+			e->waiting.push_back(w);
 
-			//
-			// Check if any overlapping tx (a tx accessing the same
-			// cacheline) needs to be restarted.
-			//
-			for (; it != m_overlapping_tx.end();) {
-				Transaction *overlapping_tr = (*it);
-				bool restart_tr = false;
+			m_stats.stalls++;
+			m_num_stalled++;
+			if (m_num_stalled > m_stats.max_stalled) {
+				m_stats.max_stalled = m_num_stalled;
+			}
+		}
 
-				if (overlapping_tr->InAddressRange(addr) ||
-					overlapping_tr->InAddressRange(last_addr) ||
-					tr.InAddressRange(overlapping_tr->GetAddress()) ) {
+		void release(Transaction& tr)
+		{
+			uint64_t last = last_line(tr);
+			uint64_t line;
 
-					if (!is_overlapping(*overlapping_tr)) {
-						//
-						// Found an overlapping tr stalled by
-						// the transaction that is now done.
-						// Restart it!
-						//
-						restart_tr = true;
-					}
+			for (line = first_line(tr); line <= last; line++) {
+				typename line_map::iterator it = m_lines.find(line);
+
+				assert(it != m_lines.end());
+				assert(it->second.ongoing > 0);
+
+				it->second.ongoing--;
+
+				restart_waiting(line);
+			}
+		}
+
+		//
+		// Start the transactions waiting first in line on a cacheline
+		// that has no ongoing transactions. Transactions also waiting
+		// on another cacheline move to that cacheline's FIFO.
+		//
+		void restart_waiting(uint64_t line)
+		{
+			// Element references are stable across rehashing
+			line_entry& e = m_lines[line];
+
+			while (e.ongoing == 0 && !e.waiting.empty()) {
+				waiter w = e.waiting.front();
+				line_entry *blocking;
+				sc_time stalled;
+
+				e.waiting.pop_front();
+
+				blocking = blocking_line(*w.tr, line);
+				if (blocking) {
+					blocking->waiting.push_back(w);
+					continue;
 				}
 
-				if (restart_tr) {
-					//
-					// Move overlapping tr to the
-					// ongoing list
-					//
-					it = m_overlapping_tx.erase(it);
-					m_ongoing_tx.push_back(overlapping_tr);
+				m_num_stalled--;
 
-					//
-					// Start processing it.
-					//
-					if (overlapping_tr->IsSnoopingTransaction()) {
-						to_snoop_engine(overlapping_tr);
-					} else {
-						to_downstream_port(overlapping_tr);
-					}
-				} else {
-					it++;
+				stalled = sc_time_stamp() - w.since;
+				m_stats.stall_time += stalled;
+				if (stalled > m_stats.max_stall_time) {
+					m_stats.max_stall_time = stalled;
 				}
+
+				start(w.tr);
+			}
+
+			if (e.ongoing == 0 && e.waiting.empty()) {
+				m_lines.erase(line);
 			}
 		}
 
 		ISnoopEngine *m_snoop_engine;
-		DownstreamPort& m_ds_port;
+		DownstreamRouter& m_ds_port;
 
-		std::list<Transaction*> m_ongoing_tx;
-		std::list<Transaction*> m_overlapping_tx;
+		line_map m_lines;
+		unsigned int m_num_stalled;
+		overlap_stats m_stats;
 	};
 
 	class ACELitePort_S :
@@ -1320,7 +1648,7 @@ public:
 
 		SnoopEngine(sc_core::sc_module_name name,
 				ACEPort_S **s_ace_port,
-				DownstreamPort& ds_port) :
+				DownstreamRouter& ds_port) :
 			sc_core::sc_module(name),
 			m_exmon("pos-monitor"),
 			m_s_ace_port(s_ace_port),
@@ -1639,13 +1967,18 @@ public:
 		DVMCompleteHandler m_dvm_completes;
 		sc_fifo<Transaction*> m_snoop_engine_fifo;
 		sc_fifo<SnoopTransaction*> m_snoop_done_fifo;
-		DownstreamPort& m_ds_port;
+		DownstreamRouter& m_ds_port;
 	};
 
 	ACEPort_S *s_ace_port[NUM_ACE_MASTERS];
 	ACELitePort_S *s_acelite_port[NUM_ACELITE_MASTERS];
 	DownstreamPort ds_port;
 
+	//
+	// All downstream ports, ds_ports[0] is ds_port
+	//
+	DownstreamPort *ds_ports[NUM_DS_PORTS];
+
 	SC_HAS_PROCESS(iconnect_ace);
 
 	iconnect_ace(sc_core::sc_module_name name) :
@@ -1653,13 +1986,27 @@ public:
 		ds_port("ds-port"),
 		m_snoop_engine("snoop-engine",
 				s_ace_port,
-				ds_port),
+				m_ds_router),
 		m_overlapping_orderer("overlapping-orderer",
 					&m_snoop_engine,
-					ds_port)
+					m_ds_router)
 	{
 		int port_id;
 
+		ds_ports[0] = &ds_port;
+		for (port_id = 1; port_id < NUM_DS_PORTS; port_id++) {
+			std::ostringstream name;
+
+			name << "ds-port" << port_id;
+
+			ds_ports[port_id] =
+				new DownstreamPort(name.str().c_str());
+		}
+
+		for (port_id = 0; port_id < NUM_DS_PORTS; port_id++) {
+			m_ds_router.set_port(port_id, ds_ports[port_id]);
+		}
+
 		for (port_id = 0; port_id < NUM_ACE_MASTERS; port_id++) {
 			std::ostringstream name;
 
@@ -1683,6 +2030,20 @@ public:
 		}
 	}
 
+	//
+	// Size of the address blocks interleaved across the downstream
+	// ports (power of 2, at least a cacheline, default 4 KB)
+	//
+	void set_ds_interleave(unsigned int granule)
+	{
+		m_ds_router.set_interleave(granule);
+	}
+
+	overlap_stats& get_overlap_stats()
+	{
+		return m_overlapping_orderer.get_stats();
+	}
+
 	~iconnect_ace()
 	{
 		int i;
@@ -1694,9 +2055,14 @@ public:
 		for (i = 0; i < NUM_ACELITE_MASTERS; i++) {
 			delete s_acelite_port[i];
 		}
+
+		for (i = 1; i < NUM_DS_PORTS; i++) {
+			delete ds_ports[i];
+		}
 	}
 
 private:
+	DownstreamRouter m_ds_router;
 	SnoopEngine m_snoop_engine;
 	OverlappingTxOrderer m_overlapping_orderer;
 };
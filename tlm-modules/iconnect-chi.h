@@ -31,6 +31,8 @@
 #define TLM_MODULES_ICONNECT_CHI_H__
 
 #include <list>
+#include <bitset>
+#include <unordered_map>
 
 #include "tlm.h"
 #include "tlm_utils/simple_initiator_socket.h"
@@ -38,13 +40,15 @@
 #include "tlm-extensions/chiattr.h"
 #include "tlm-bridges/amba-chi.h"
 #include "tlm-modules/private/chi/txnids.h"
+#include "tlm-modules/private/chi/pool.h"
 
 using namespace AMBA::CHI;
 
 template<
 	int NODE_ID = 20,
 	int SLAVE_NODE_ID = 10,
-	int NUM_CHI_RN_F = 2
+	int NUM_CHI_RN_F = 2,
+	int NUM_CHI_SN = 1
 	>
 class iconnect_chi :
 	public sc_core::sc_module
@@ -106,21 +110,17 @@ private:
 		IMsg(tlm::tlm_generic_payload *gp, chiattr_extension *chiattr) :
 			m_gp(gp),
 			m_chiattr(chiattr),
-			m_delete(false)
+			m_delete(false),
+			m_pool(NULL)
 		{}
 
 		IMsg() :
 			m_gp(new tlm::tlm_generic_payload()),
 			m_chiattr(new chiattr_extension()),
-			m_delete(true)
+			m_delete(true),
+			m_pool(NULL)
 		{
-			m_gp->set_data_ptr(m_data);
-			m_gp->set_data_length(CACHELINE_SZ);
-
-			m_gp->set_byte_enable_ptr(m_byteEnable);
-			m_gp->set_byte_enable_length(CACHELINE_SZ);
-
-			m_gp->set_streaming_width(CACHELINE_SZ);
+			SetupGP();
 
 			m_gp->set_extension(m_chiattr);
 		}
@@ -133,6 +133,41 @@ private:
 			}
 		}
 
+		void SetPool(IObjPool<IMsg> *pool) { m_pool = pool; }
+
+		//
+		// Messages taken from a pool are returned to it, others are
+		// deleted.
+		//
+		void Release()
+		{
+			if (m_pool) {
+				m_pool->Put(this);
+			} else {
+				delete this;
+			}
+		}
+
+		//
+		// Restore a pooled message to its newly constructed state
+		// (before it is initialized again), keeping the gp and
+		// chiattr allocations.
+		//
+		virtual void Recycle()
+		{
+			m_gp->clear_extension(m_chiattr);
+			m_gp->free_all_extensions();
+
+			m_gp->set_command(tlm::TLM_IGNORE_COMMAND);
+			m_gp->set_address(0);
+			m_gp->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+			m_gp->set_dmi_allowed(false);
+			SetupGP();
+
+			*m_chiattr = chiattr_extension();
+			m_gp->set_extension(m_chiattr);
+		}
+
 		tlm::tlm_generic_payload& GetGP()
 		{
 			return *m_gp;
@@ -151,6 +186,17 @@ private:
 
 	protected:
 
+		void SetupGP()
+		{
+			m_gp->set_data_ptr(m_data);
+			m_gp->set_data_length(CACHELINE_SZ);
+
+			m_gp->set_byte_enable_ptr(m_byteEnable);
+			m_gp->set_byte_enable_length(CACHELINE_SZ);
+
+			m_gp->set_streaming_width(CACHELINE_SZ);
+		}
+
 		tlm::tlm_generic_payload *m_gp;
 		chiattr_extension *m_chiattr;
 
@@ -158,6 +204,8 @@ private:
 		uint8_t m_byteEnable[CACHELINE_SZ];
 
 		bool m_delete;
+
+		IObjPool<IMsg> *m_pool;
 	};
 
 	class ReqTxn :
@@ -175,26 +223,20 @@ private:
 		// towards SN
 		//
 		ReqTxn(tlm::tlm_generic_payload& gp) :
-			m_waitingForReadReceipt(false),
-			m_waitingForCompAck(false),
-			m_gotRetryAck(false),
-			m_gotPCrdGrant(false),
-			m_isSnpFwded(false),
-			m_snpResp(0),
-			m_snpDataFwded(false),
-			m_gotSnpData(false),
-			m_isSnpDataPtl(false),
-			m_compAckReceived(false),
-			m_writeToSNDone(false),
-			m_compSNReceived(false),
-			m_chiattrSN(new chiattr_extension),
-			m_dataReceived(0)
+			m_chiattrSN(new chiattr_extension)
 		{
-			m_gp->deep_copy_from(gp);
-
-			// For storing SN requests (unused in a retry request)
+			// For storing SN requests (unused in SN requests)
 			m_reqSNCopy.set_extension(m_chiattrSN);
 
+			Init(gp);
+		}
+
+		void Init(tlm::tlm_generic_payload& gp)
+		{
+			ResetState();
+
+			m_gp->deep_copy_from(gp);
+
 			//
 			// ReadOnce* without ExpCompAck will not receive
 			// CompAck after a Snp*Fwd has forwarded data and ends after the
@@ -217,24 +259,20 @@ private:
 		// Used when building SN requests
 		//
 		ReqTxn(ReqTxn *req, uint8_t opcode, uint8_t txnID) :
-			m_waitingForReadReceipt(false),
-			m_waitingForCompAck(false),
-			m_gotRetryAck(false),
-			m_gotPCrdGrant(false),
-			m_isSnpFwded(false),
-			m_snpResp(0),
-			m_snpDataFwded(false),
-			m_gotSnpData(false),
-			m_isSnpDataPtl(false),
-			m_compAckReceived(false),
-			m_writeToSNDone(false),
-			m_compSNReceived(false),
-			m_chiattrSN(NULL),
-			m_dataReceived(0)
+			m_chiattrSN(new chiattr_extension)
+		{
+			m_reqSNCopy.set_extension(m_chiattrSN);
+
+			Init(req, opcode, txnID);
+		}
+
+		void Init(ReqTxn *req, uint8_t opcode, uint8_t txnID)
 		{
 			tlm::tlm_generic_payload& gp = req->GetGP();
 			chiattr_extension *attr = req->GetCHIAttr();
 
+			ResetState();
+
 			m_gp->set_address(gp.get_address());
 
 			m_chiattr->SetQoS(attr->GetQoS());
@@ -278,6 +316,17 @@ private:
 			req->CopyToRequestSN(m_gp);
 		}
 
+		virtual void Recycle()
+		{
+			IMsg::Recycle();
+
+			m_snpIDs.clear();
+			// Keeps the capacity for the next request
+			m_snpTrackers.clear();
+
+			*m_chiattrSN = chiattr_extension();
+		}
+
 		tlm::tlm_generic_payload& GetReqSNCopy()
 		{
 			return m_reqSNCopy;
@@ -830,18 +879,21 @@ private:
 			//
 			m_chiattrSN->SetAllowRetry(false);
 			m_chiattrSN->SetPCrdType(chiattr->GetPCrdType());
+			m_retrySrcID = chiattr->GetSrcID();
 			m_gotRetryAck = true;
 		}
 
-		void HandlePCrdGrant(chiattr_extension *chiattr)
+		void HandlePCrdGrant()
 		{
-			// Only one transaction at a time so just keep track
-			// that a PCrdGrant has been is received. Most likely
-			// it will arrive after the RetryAck, but it can also
-			// arrive before 2.3.2 [1].
+			// The TxnProcessor hands over a PCrdGrant (from the SN
+			// and of the PCrdType in the RetryAck) to the request
+			// once the RetryAck has been received.
 			m_gotPCrdGrant = true;
 		}
 
+		uint16_t GetRetrySrcID() { return m_retrySrcID; }
+		uint8_t GetPCrdType() { return m_chiattrSN->GetPCrdType(); }
+
 		uint8_t GetLPID() { return m_chiattr->GetLPID(); }
 		uint8_t GetExcl() { return m_chiattr->GetExcl(); }
 		uint8_t GetRespErr() { return m_chiattr->GetRespErr(); }
@@ -905,6 +957,24 @@ private:
 			return len;
 		}
 
+		void ResetState()
+		{
+			m_waitingForReadReceipt = false;
+			m_waitingForCompAck = false;
+			m_gotRetryAck = false;
+			m_gotPCrdGrant = false;
+			m_retrySrcID = 0;
+			m_isSnpFwded = false;
+			m_snpResp = 0;
+			m_snpDataFwded = false;
+			m_gotSnpData = false;
+			m_isSnpDataPtl = false;
+			m_compAckReceived = false;
+			m_writeToSNDone = false;
+			m_compSNReceived = false;
+			m_dataReceived = 0;
+		}
+
 		SnpTxnTracker *GetSnpTxnTracker(uint8_t txnID)
 		{
 			typename std::vector<SnpTxnTracker>::iterator it;
@@ -929,6 +999,7 @@ private:
 		//
 		bool m_gotRetryAck;
 		bool m_gotPCrdGrant;
+		uint16_t m_retrySrcID;
 
 		bool m_isSnpFwded;
 		uint8_t m_snpResp;
@@ -971,6 +1042,11 @@ private:
 		// This is called when creating dataless responses and read receipts
 		//
 		RspMsg(ReqTxn *req, uint8_t opcode)
+		{
+			Init(req, opcode);
+		}
+
+		void Init(ReqTxn *req, uint8_t opcode)
 		{
 			chiattr_extension *attr = req->GetCHIAttr();
 
@@ -985,7 +1061,7 @@ private:
 			m_chiattr->SetResp(GetResp(req));
 			m_chiattr->SetRespErr(req->GetRespErr());
 			m_chiattr->SetTraceTag(attr->GetTraceTag());
-		};
+		}
 
 		bool IsCompAck()
 		{
@@ -1065,6 +1141,11 @@ private:
 		// This is called when routing packets.
 		//
 		DatMsg(DatMsg& rhs)
+		{
+			Init(rhs);
+		}
+
+		void Init(DatMsg& rhs)
 		{
 			m_gp->deep_copy_from(rhs.GetGP());
 			m_gp->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
@@ -1082,6 +1163,11 @@ private:
 		// This is called on snoop responses.
 		//
 		DatMsg(ReqTxn *req)
+		{
+			Init(req);
+		}
+
+		void Init(ReqTxn *req)
 		{
 			tlm::tlm_generic_payload& gp = req->GetGP();
 			chiattr_extension *attr = req->GetCHIAttr();
@@ -1120,6 +1206,11 @@ private:
 		// This is called for slave node DatMsgs.
 		//
 		DatMsg(ReqTxn *req, uint8_t opcode, uint8_t txnID)
+		{
+			Init(req, opcode, txnID);
+		}
+
+		void Init(ReqTxn *req, uint8_t opcode, uint8_t txnID)
 		{
 			tlm::tlm_generic_payload& gp = req->GetGP();
 			chiattr_extension *attr = req->GetCHIAttr();
@@ -1219,6 +1310,11 @@ private:
 		// SnpMsg Construction
 		//
 		SnpMsg(ReqTxn *req, uint8_t txnID, bool allowsSnpFwd)
+		{
+			Init(req, txnID, allowsSnpFwd);
+		}
+
+		void Init(ReqTxn *req, uint8_t txnID, bool allowsSnpFwd)
 		{
 			tlm::tlm_generic_payload& gp = req->GetGP();
 			chiattr_extension *attr = req->GetCHIAttr();
@@ -1498,6 +1594,27 @@ private:
 		}
 	};
 
+	//
+	// Messages are recycled through free lists instead of being
+	// allocated and freed for each transaction. The pools are shared by
+	// all instances of the template (messages don't refer to a specific
+	// instance).
+	//
+	struct MsgPools
+	{
+		ObjPool<ReqTxn, IMsg> req;
+		ObjPool<RspMsg, IMsg> rsp;
+		ObjPool<DatMsg, IMsg> dat;
+		ObjPool<SnpMsg, IMsg> snp;
+	};
+
+	static MsgPools& GetMsgPools()
+	{
+		static MsgPools pools;
+
+		return pools;
+	}
+
 	class IPacketRouter
 	{
 	public:
@@ -1558,7 +1675,7 @@ private:
 
 				assert(t->GetGP().get_response_status() ==
 						tlm::TLM_OK_RESPONSE);
-				delete t;
+				t->Release();
 			}
 		}
 
@@ -1586,6 +1703,15 @@ private:
 				lhs.m_non_secure == rhs.m_non_secure;
 		}
 
+		//
+		// The line address with the NS bit in bit 0, lines are at
+		// least 2 bytes so it is unique per line.
+		//
+		uint64_t GetKey() const { return m_addr | m_non_secure; }
+
+		uint64_t GetAddress() const { return m_addr; }
+		bool GetNonSecure() const { return m_non_secure; }
+
 	private:
 		uint64_t Align(uint64_t addr)
 		{
@@ -1596,6 +1722,158 @@ private:
 		bool m_non_secure;
 	};
 
+	//
+	// Orders the incoming requests per cache line (the endpoint address
+	// range is 64b, same as the cache line here 2.8 [1]). A hazard
+	// table, keyed by line, holds an entry for each line that has a
+	// request ready or ongoing together with the requests that arrived
+	// after it to the same line. When a request is done the next
+	// request waiting on its line (only) is made ready, so by blocking
+	// write observer order is preserved per line.
+	//
+	// Ready requests are routed in arrival order, at most
+	// m_maxOutstanding at a time (default one).
+	//
+	class RequestOrderer :
+		public sc_core::sc_module
+	{
+	public:
+		SC_HAS_PROCESS(RequestOrderer);
+
+		RequestOrderer(sc_core::sc_module_name name,
+				IPacketRouter *router) :
+			sc_core::sc_module(name),
+			m_router(router),
+			m_numOngoing(0),
+			m_maxOutstanding(1)
+		{
+			SC_THREAD(req_ordering_thread);
+		}
+
+		void ProcessReq(ReqTxn *req)
+		{
+			Address addr(req);
+			typename HazardTable::iterator it;
+
+			assert(req);
+
+			it = m_hazards.find(addr.GetKey());
+			if (it != m_hazards.end()) {
+				//
+				// Overlapping request ready or ongoing, wait
+				// for it to be done
+				//
+				it->second.push_back(req);
+			} else {
+				m_hazards[addr.GetKey()];
+
+				m_reqList.push_back(req);
+				m_pushEvent.notify();
+			}
+		}
+
+		bool RunVerify(ReqTxn *req)
+		{
+			switch (req->GetCHIAttr()->GetOpcode()) {
+			case Req::WriteCleanFull:
+			case Req::WriteUniquePtl:
+			case Req::WriteUniqueFull:
+			case Req::WriteUniqueFullStash:
+			case Req::WriteUniquePtlStash:
+				return false;
+			default:
+				return true;
+			}
+		}
+
+		void ReqDone(ReqTxn *req)
+		{
+			Address addr(req);
+			typename HazardTable::iterator it;
+
+			it = m_hazards.find(addr.GetKey());
+			assert(it != m_hazards.end());
+
+			if (it->second.empty()) {
+				m_hazards.erase(it);
+			} else {
+				//
+				// Wake up the next request on the line
+				//
+				m_reqList.push_back(it->second.front());
+				it->second.pop_front();
+				m_pushEvent.notify();
+			}
+
+			assert(m_numOngoing > 0);
+			m_numOngoing--;
+
+			req->Release();
+
+			m_removeEvent.notify();
+		}
+
+		void SetMaxOutstanding(unsigned int maxOutstanding)
+		{
+			assert(maxOutstanding > 0);
+			m_maxOutstanding = maxOutstanding;
+		}
+
+	private:
+		//
+		// Line key (see Address::GetKey()) to the requests waiting
+		// on the line
+		//
+		typedef std::unordered_map<uint64_t,
+					std::list<ReqTxn*> > HazardTable;
+
+		void req_ordering_thread()
+		{
+			while (true) {
+				ReqTxn *req;
+
+				while (m_reqList.empty()) {
+					wait(m_pushEvent);
+				}
+
+				while (m_numOngoing >= m_maxOutstanding) {
+					wait(m_removeEvent);
+				}
+
+				req = m_reqList.front();
+				assert(req);
+
+				m_reqList.pop_front();
+				m_numOngoing++;
+
+				// Forward to router now
+				m_router->RouteReq(req);
+			}
+		}
+
+		IPacketRouter *m_router;
+		std::list<ReqTxn*> m_reqList;
+		HazardTable m_hazards;
+		unsigned int m_numOngoing;
+		unsigned int m_maxOutstanding;
+		sc_event m_pushEvent;
+		sc_event m_removeEvent;
+
+	};
+
+	//
+	// Snoop filter directory, tracks which RN-Fs that have allocated
+	// each cache line (by Port_RN_F index). Lines are looked up through
+	// a hash table so the cost of a lookup does not depend on the amount
+	// of lines tracked.
+	//
+	// The capacity is unlimited by default. With a capacity set, the
+	// least recently allocated line is back-invalidated when the
+	// directory overflows: a CleanInvalid from the HN-F is queued on the
+	// RequestOrderer, snooping the line out of the RN-Fs holding it (and
+	// writing back dirty data). The line stays tracked until the snoop
+	// responses have invalidated it.
+	//
 	class SnoopFilter
 	{
 	public:
@@ -1607,14 +1885,19 @@ private:
 			I_PD = 0x4 // 0b100
 			};
 
-		SnoopFilter()
+		typedef std::bitset<NUM_CHI_RN_F> Presence;
+
+		SnoopFilter(RequestOrderer *reqOrderer) :
+			m_reqOrderer(reqOrderer),
+			m_capacity(0),
+			m_backInvalidations(0)
 		{}
 
 		//
 		// Called from the PoC after snooping
 		//
 		template<typename TxnType>
-		void Update(TxnType& t, ReqTxn *req)
+		void Update(int portID, TxnType& t, ReqTxn *req)
 		{
 			switch (t.GetCHIAttr()->GetResp()) {
 			case INV:
@@ -1626,7 +1909,7 @@ private:
 				//
 				Address addr(req);
 
-				EvictCacheLine(addr);
+				EvictCacheLine(portID, addr);
 				break;
 			}
 			default:
@@ -1639,7 +1922,7 @@ private:
 		//
 		// Called from the TxnProcessor
 		//
-		void Update(ReqTxn *req)
+		void Update(int portID, ReqTxn *req)
 		{
 			Address addr(req);
 
@@ -1662,7 +1945,7 @@ private:
 			case Req::ReadUnique:
 			case Req::CleanUnique:
 			case Req::MakeUnique:
-				AllocateCacheLine(addr);
+				AllocateCacheLine(portID, addr);
 				break;
 			//
 			// CleanShared and CleanSharedPersist leaves
@@ -1682,171 +1965,148 @@ private:
 				// All other transactions expect the line to be
 				// invalid afterwards, 4.7 [1]
 				//
-				EvictCacheLine(addr);
+				EvictCacheLine(portID, addr);
 				break;
 			}
 		}
 
-		bool ContainsAllocated(Address& addr)
+		//
+		// RN-Fs that might have the line allocated
+		//
+		Presence GetPresence(Address& addr)
 		{
-			return InList(addr);
-		}
-
-	private:
+			typename std::unordered_map<uint64_t, Entry>::iterator it;
 
-		void AllocateCacheLine(Address& addr)
-		{
-			if (!InList(addr)) {
-				m_allocated.push_back(addr);
+			it = m_lines.find(addr.GetKey());
+			if (it == m_lines.end()) {
+				return Presence();
 			}
+			return it->second.presence;
 		}
 
-		void EvictCacheLine(Address& addr)
+		//
+		// Amount of lines to track before back-invalidating, 0 is
+		// unlimited.
+		//
+		void SetCapacity(unsigned int nrLines)
 		{
-			if (InList(addr)) {
-				m_allocated.remove(addr);
-			}
+			m_capacity = nrLines;
+			BackInvalidate();
 		}
 
-		bool InList(Address& addr)
-		{
-			typename std::list<Address>::iterator it;
-			for (it = m_allocated.begin();
-				it != m_allocated.end(); it++) {
-
-				if ((*it) == addr) {
-					return true;
-				}
-			}
-			return false;
-		}
+		unsigned int GetCapacity() { return m_capacity; }
+		unsigned int GetNumLines() { return m_lines.size(); }
+		uint64_t GetBackInvalidations() { return m_backInvalidations; }
 
-		std::list<Address> m_allocated;
-	};
+	private:
+		struct Entry
+		{
+			Presence presence;
 
-	class RequestOrderer :
-		public sc_core::sc_module
-	{
-	public:
-		SC_HAS_PROCESS(RequestOrderer);
+			//
+			// Position in m_lru, lines being back-invalidated
+			// are not in m_lru.
+			//
+			typename std::list<uint64_t>::iterator lru;
+			bool backInvalidating;
+		};
 
-		RequestOrderer(sc_core::sc_module_name name,
-				IPacketRouter *router) :
-			sc_core::sc_module(name),
-			m_router(router)
+		void AllocateCacheLine(int portID, Address& addr)
 		{
-			SC_THREAD(req_ordering_thread);
-		}
+			uint64_t key = addr.GetKey();
+			typename std::unordered_map<uint64_t, Entry>::iterator it;
 
-		void ProcessReq(ReqTxn *req)
-		{
-			assert(req);
-			m_reqList.push_back(req);
-			m_pushEvent.notify();
-		}
+			it = m_lines.find(key);
+			if (it == m_lines.end()) {
+				Entry e;
 
-		bool RunVerify(ReqTxn *req)
-		{
-			switch (req->GetCHIAttr()->GetOpcode()) {
-			case Req::WriteCleanFull:
-			case Req::WriteUniquePtl:
-			case Req::WriteUniqueFull:
-			case Req::WriteUniqueFullStash:
-			case Req::WriteUniquePtlStash:
-				return false;
-			default:
-				return true;
-			}
-		}
+				e.lru = m_lru.insert(m_lru.end(), key);
+				e.backInvalidating = false;
 
-		void ReqDone(ReqTxn *req)
-		{
-			m_ongoing.remove(req);
+				it = m_lines.insert(std::make_pair(key, e)).first;
+			} else if (!it->second.backInvalidating) {
+				// Most recently allocated goes last
+				m_lru.splice(m_lru.end(), m_lru, it->second.lru);
+			}
 
-			delete req;
+			it->second.presence.set(portID);
 
-			m_removeEvent.notify();
+			BackInvalidate();
 		}
 
-	private:
-
-		void req_ordering_thread()
+		void EvictCacheLine(int portID, Address& addr)
 		{
-			while (true) {
-				ReqTxn *req;
+			typename std::unordered_map<uint64_t, Entry>::iterator it;
 
-				if (m_reqList.empty()) {
-					wait(m_pushEvent);
-				}
-
-				req = m_reqList.front();
-				assert(req);
-				if (OverlappingRequestOngoing(req)) {
-					//
-					// block processing (by blocking write
-					// observer order is preserved)
-					//
-					wait(m_removeEvent);
-
-					//
-					// check againg if there is an overlapping
-					//
-					continue;
-				}
+			it = m_lines.find(addr.GetKey());
+			if (it == m_lines.end()) {
+				return;
+			}
 
-				m_reqList.remove(req);
-				m_ongoing.push_back(req);
+			it->second.presence.reset(portID);
 
-				// Forward to router now
-				m_router->RouteReq(req);
-
-				// One at a time
-				if (Ongoing(req)) {
-					wait(m_removeEvent);
+			if (it->second.presence.none()) {
+				if (!it->second.backInvalidating) {
+					m_lru.erase(it->second.lru);
 				}
+				m_lines.erase(it);
 			}
 		}
 
-		bool OverlappingRequestOngoing(ReqTxn *req)
+		void BackInvalidate()
 		{
-			typename std::list<ReqTxn*>::iterator it;
+			if (m_capacity == 0) {
+				return;
+			}
 
-			for (it = m_ongoing.begin();
-				it != m_ongoing.end(); it++) {
-				ReqTxn *tmp = (*it);
-				Address addr1(tmp);
-				Address addr2(req);
+			while (m_lru.size() > m_capacity) {
+				uint64_t key = m_lru.front();
+				Entry& e = m_lines[key];
 
-				//
-				// Endpoint address range is 64b, same as cache
-				// line here 2.8 [1]
-				//
-				if (addr1 == addr2) {
-					return true;
-				}
+				m_lru.pop_front();
+				e.backInvalidating = true;
+
+				m_reqOrderer->ProcessReq(
+					CreateBackInvalidateReq(key));
+				m_backInvalidations++;
 			}
-			return false;
 		}
 
-		bool Ongoing(ReqTxn *req)
+		//
+		// A CleanInvalid from the HN-F itself (SrcID NODE_ID), so
+		// all RN-Fs holding the line get snooped and the final Comp
+		// is not transmitted to any port.
+		//
+		ReqTxn *CreateBackInvalidateReq(uint64_t key)
 		{
-			typename std::list<ReqTxn*>::iterator it;
-			for (it = m_ongoing.begin();
-				it != m_ongoing.end(); it++) {
+			tlm::tlm_generic_payload gp;
+			chiattr_extension *attr = new chiattr_extension();
 
-				if ((*it) == req) {
-					return true;
-				}
-			}
-			return false;
+			gp.set_command(tlm::TLM_IGNORE_COMMAND);
+			gp.set_address(key & ~(uint64_t)(CACHELINE_SZ-1));
+			gp.set_data_length(CACHELINE_SZ);
+			gp.set_streaming_width(CACHELINE_SZ);
+
+			attr->SetSrcID(NODE_ID);
+			attr->SetTgtID(NODE_ID);
+			attr->SetOpcode(Req::CleanInvalid);
+			attr->SetNonSecure(key & 1);
+			attr->SetSnpAttr(true);
+			attr->SetExpCompAck(false);
+
+			// Freed by the gp
+			gp.set_extension(attr);
+
+			return GetMsgPools().req.Get(gp);
 		}
 
-		IPacketRouter *m_router;
-		std::list<ReqTxn*> m_reqList;
-		std::list<ReqTxn*> m_ongoing;
-		sc_event m_pushEvent;
-		sc_event m_removeEvent;
+		RequestOrderer *m_reqOrderer;
 
+		std::unordered_map<uint64_t, Entry> m_lines;
+		std::list<uint64_t> m_lru;
+
+		unsigned int m_capacity;
+		uint64_t m_backInvalidations;
 	};
 
 	//
@@ -1924,7 +2184,6 @@ private:
 			txsnp_init_socket.bind(dev.txsnp_tgt_socket);
 		}
 
-		SnoopFilter& GetSnoopFilter() { return m_snoopFilter; }
 	private:
 		virtual void b_transport_rxreq(tlm::tlm_generic_payload& trans,
 						sc_time& delay)
@@ -1935,7 +2194,7 @@ private:
 				chiattr_extension *chiattr;
 				trans.get_extension(chiattr);
 				if (chiattr) {
-					ReqTxn *req = new ReqTxn(trans);
+					ReqTxn *req = GetMsgPools().req.Get(trans);
 
 					if (req->GetAllowRetry() && GetToggle()) {
 
@@ -1945,7 +2204,7 @@ private:
 						// Don't store it, instead
 						// always accept retry reqs
 						//
-						delete req;
+						req->Release();
 					} else {
 						m_reqOrderer->ProcessReq(req);
 					}
@@ -1993,8 +2252,10 @@ private:
 
 		void ReplyRetry(ReqTxn *req)
 		{
-			RspMsg *rspRetryAck = new RspMsg(req, Rsp::RetryAck);
-			RspMsg *rspPCrdGrant = new RspMsg(req, Rsp::PCrdGrant);
+			RspMsg *rspRetryAck =
+				GetMsgPools().rsp.Get(req, Rsp::RetryAck);
+			RspMsg *rspPCrdGrant =
+				GetMsgPools().rsp.Get(req, Rsp::PCrdGrant);
 
 			// PCrdType == 0
 			m_txRspChannel.Process(rspRetryAck);
@@ -2018,8 +2279,6 @@ private:
 		bool m_onlySnpDVM;
 		uint16_t m_nodeID;
 		bool m_toggle;
-
-		SnoopFilter m_snoopFilter;
 	};
 
 	class Port_SN :
@@ -2133,15 +2392,35 @@ private:
 				TxnIDs *ids,
 				ReqTxn **ongoingTxn,
 				RequestOrderer *reqOrderer,
+				SnoopFilter *snoopFilter,
 				IDVMOpProcessor *poc) :
 			m_port_RN_F(port_RN_F),
 			m_port_SN(port_SN),
 			m_ids(ids),
 			m_ongoingTxn(ongoingTxn),
 			m_reqOrderer(reqOrderer),
-			m_poc(poc)
+			m_snoopFilter(snoopFilter),
+			m_poc(poc),
+			m_snInterleave(4 * 1024)
 		{}
 
+		//
+		// The address space is interleaved across the SNs in
+		// granule sized blocks (power of 2, at least a cache line)
+		//
+		void SetSNInterleave(unsigned int granule)
+		{
+			assert(granule >= CACHELINE_SZ);
+			assert((granule & (granule - 1)) == 0);
+
+			m_snInterleave = granule;
+		}
+
+		int GetSNIndex(uint64_t addr)
+		{
+			return (addr / m_snInterleave) % NUM_CHI_SN;
+		}
+
 		void ProcessSnpdReq(ReqTxn *req)
 		{
 			if (req->GotSnpData() && req->GetSnpRespPassDirty() &&
@@ -2149,18 +2428,19 @@ private:
 				//
 				// Transmit dirty data to SN
 				//
-				ReqTxn *wrReq = new ReqTxn(req, Req::WriteNoSnpPtl,
-								m_ids->GetID());
+				ReqTxn *wrReq = GetMsgPools().req.Get(req,
+							Req::WriteNoSnpPtl,
+							m_ids->GetID());
 
 				req->SnpRespPassDirtyClear();
 
 				m_ongoingTxn[wrReq->GetTxnID()] = req;
 
-				m_port_SN[0]->Transmit(wrReq);
+				TransmitToSlaveNode(wrReq);
 
 			} else if (req->GotSnpData() && req->IsSnpRead()) {
 
-				DatMsg *dat = new DatMsg(req);
+				DatMsg *dat = GetMsgPools().dat.Get(req);
 
 				if (req->GetExpCompAck()) {
 					dat->GetCHIAttr()->SetHomeNID(NODE_ID);
@@ -2179,7 +2459,7 @@ private:
 				TransmitToRequestNode(dat);
 
 			} else if (req->IsDVMOp()) {
-				RspMsg *rsp = new RspMsg(req, Rsp::Comp);
+				RspMsg *rsp = GetMsgPools().rsp.Get(req, Rsp::Comp);
 
 				TransmitToRequestNode(rsp);
 
@@ -2210,7 +2490,7 @@ private:
 				//
 				// Construct an SN req taking into
 				// consideration if DMT is allowed
-				ReqTxn *rdReq = new ReqTxn(req,
+				ReqTxn *rdReq = GetMsgPools().req.Get(req,
 							Req::ReadNoSnp,
 							m_ids->GetID());
 
@@ -2236,10 +2516,11 @@ private:
 
 				// To SN
 				m_ongoingTxn[rdReq->GetTxnID()] = req;
-				m_port_SN[0]->Transmit(rdReq);
+				TransmitToSlaveNode(rdReq);
 
 			} else if (req->IsWrite() || req->IsAtomicStore()) {
-				RspMsg *rsp = new RspMsg(req, Rsp::CompDBIDResp);
+				RspMsg *rsp = GetMsgPools().rsp.Get(req,
+							Rsp::CompDBIDResp);
 
 				// HomeNID not used, see 2.6.3 [1]
 				rsp->SetDBID(m_ids->GetID());
@@ -2251,7 +2532,7 @@ private:
 
 				TransmitToRequestNode(rsp);
 			} else if (req->IsDataLess()) {
-				RspMsg *rsp = new RspMsg(req, Rsp::Comp);
+				RspMsg *rsp = GetMsgPools().rsp.Get(req, Rsp::Comp);
 
 				if (req->GetExpCompAck()) {
 					rsp->GetCHIAttr()->SetHomeNID(NODE_ID);
@@ -2281,7 +2562,7 @@ private:
 				// AtomicStore i handled as an IsWrite, so only
 				// the non store atomics are handled here
 				//
-				RspMsg *rsp = new RspMsg(req, Rsp::DBIDResp);
+				RspMsg *rsp = GetMsgPools().rsp.Get(req, Rsp::DBIDResp);
 
 				// HomeNID not used, see 2.6.3 [1]
 				rsp->SetDBID(m_ids->GetID());
@@ -2325,11 +2606,11 @@ private:
 					//
 					if (dat.GetPassDirty()) {
 						// To SN
-						ReqTxn *wrReq = new ReqTxn(req,
+						ReqTxn *wrReq = GetMsgPools().req.Get(req,
 								Req::WriteNoSnpPtl,
 								dat.GetTxnID());
 
-						m_port_SN[0]->Transmit(wrReq);
+						TransmitToSlaveNode(wrReq);
 
 					} else {
 						// WriteEvictFull ends here
@@ -2373,11 +2654,11 @@ private:
 						}
 
 						// To SN
-						wrReq = new ReqTxn(req,
+						wrReq = GetMsgPools().req.Get(req,
 								opcode,
 								dat.GetTxnID());
 
-						m_port_SN[0]->Transmit(wrReq);
+						TransmitToSlaveNode(wrReq);
 					} else {
 						uint8_t txnID = dat.GetTxnID();
 
@@ -2450,7 +2731,7 @@ private:
 		//
 		void ProcessDat_SN(DatMsg& datSN)
 		{
-			DatMsg *dat = new DatMsg(datSN);
+			DatMsg *dat = GetMsgPools().dat.Get(datSN);
 			ReqTxn *req = m_ongoingTxn[datSN.GetTxnID()];
 
 			dat->SetupNonDMT(req);
@@ -2472,37 +2753,43 @@ private:
 
 		void ProcessResp_SN(RspMsg& rsp)
 		{
-			if (rsp.IsRetryAck() || rsp.IsPCrdGrant()) {
-				//
-				// Retry sequence, since one req is issued at a
-				// time marking that both RetryAck & PCrdGrant
-				// have been received is enough.
-				//
+			if (rsp.IsRetryAck()) {
 				uint8_t txnID = rsp.GetTxnID();
 				ReqTxn *req = m_ongoingTxn[txnID];
 				chiattr_extension *attr = rsp.GetCHIAttr();
 
-				if (rsp.IsRetryAck()) {
-					req->HandleRetryAck(attr);
-				} else if (rsp.IsPCrdGrant()) {
-					req->HandlePCrdGrant(attr);
+				req->HandleRetryAck(attr);
+
+				if (TakePCrd(attr->GetSrcID(),
+						attr->GetPCrdType())) {
+					req->HandlePCrdGrant();
+					RetryToSlaveNode(req);
+				} else {
+					m_retryWaiting.push_back(req);
 				}
 
-				// Got both RetryAck and PCrdGrant
-				if (req->RetryRequest()) {
-					ReqTxn *reqSN = new ReqTxn(req->GetReqSNCopy());
+			} else if (rsp.IsPCrdGrant()) {
+				chiattr_extension *attr = rsp.GetCHIAttr();
+				ReqTxn *req = TakeRetryWaiting(attr->GetSrcID(),
+							attr->GetPCrdType());
 
-					m_port_SN[0]->Transmit(reqSN);
+				if (req) {
+					req->HandlePCrdGrant();
+					RetryToSlaveNode(req);
+				} else {
+					m_pcrds[PCrdKey(attr->GetSrcID(),
+						attr->GetPCrdType())]++;
 				}
 
 			} else if (rsp.IsCompDBIDResp() || rsp.IsDBIDResp()) {
 				uint8_t txnID = rsp.GetTxnID();
 				ReqTxn *req = m_ongoingTxn[txnID];
-				DatMsg *dat = new DatMsg(req, Dat::NonCopyBackWrData,
-								rsp.GetDBID());
+				DatMsg *dat = GetMsgPools().dat.Get(req,
+							Dat::NonCopyBackWrData,
+							rsp.GetDBID());
 
 				// To SN
-				m_port_SN[0]->Transmit(dat);
+				TransmitToSlaveNode(dat);
 
 				if (rsp.IsCompDBIDResp()) {
 					req->SetCompSNReceived(true);
@@ -2609,19 +2896,29 @@ private:
 		}
 
 		Port_RN_F *LookupPortRNF(uint16_t nodeID)
+		{
+			int portID = LookupPortID(nodeID);
+
+			return portID >= 0 ? m_port_RN_F[portID] : NULL;
+		}
+
+		//
+		// Index of the RN-F port with nodeID, -1 if there is none
+		// (requests from the HN-F itself)
+		//
+		int LookupPortID(uint16_t nodeID)
 		{
 			for (int i = 0; i < NUM_CHI_RN_F; i++) {
 				if (m_port_RN_F[i]->GetNodeID() == nodeID) {
-					return m_port_RN_F[i];
+					return i;
 				}
 			}
-			return NULL;
+			return -1;
 		}
 
-
 		void TransmitReadReceipt(ReqTxn *req)
 		{
-			RspMsg *rsp = new RspMsg(req, Rsp::ReadReceipt);
+			RspMsg *rsp = GetMsgPools().rsp.Get(req, Rsp::ReadReceipt);
 
 			TransmitToRequestNode(rsp);
 		}
@@ -2629,13 +2926,83 @@ private:
 	private:
 		void UpdatePortRNFSnoopFilter(ReqTxn *req)
 		{
-			Port_RN_F *port = LookupPortRNF(req->GetSrcID());
+			int portID = LookupPortID(req->GetSrcID());
 
-			if (port) {
-				port->GetSnoopFilter().Update(req);
+			if (portID >= 0) {
+				m_snoopFilter->Update(portID, req);
 			}
 		}
 
+		//
+		// Requests and write data towards the SN serving the address
+		//
+		template<typename TxnType>
+		void TransmitToSlaveNode(TxnType *t)
+		{
+			uint64_t addr = t->GetGP().get_address();
+			Port_SN *port = m_port_SN[GetSNIndex(addr)];
+
+			t->GetCHIAttr()->SetTgtID(port->GetNodeID());
+			port->Transmit(t);
+		}
+
+		//
+		// Retry sequence towards the SNs. A PCrdGrant does not
+		// identify the retried request, only the SN (SrcID) and the
+		// PCrdType, so with several requests outstanding the credits
+		// are matched on those: a retried request waits for a credit
+		// from the SN that sent the RetryAck and the PCrdGrant goes
+		// to the oldest waiting request, or is kept until a matching
+		// RetryAck arrives (it can arrive first) 2.3.2 + 2.11.2 [1].
+		//
+		uint32_t PCrdKey(uint16_t srcID, uint8_t pcrdType)
+		{
+			return (srcID << 8) | pcrdType;
+		}
+
+		bool TakePCrd(uint16_t srcID, uint8_t pcrdType)
+		{
+			typename std::unordered_map<uint32_t,
+				unsigned int>::iterator it;
+
+			it = m_pcrds.find(PCrdKey(srcID, pcrdType));
+			if (it == m_pcrds.end()) {
+				return false;
+			}
+
+			if (--it->second == 0) {
+				m_pcrds.erase(it);
+			}
+			return true;
+		}
+
+		ReqTxn *TakeRetryWaiting(uint16_t srcID, uint8_t pcrdType)
+		{
+			typename std::list<ReqTxn*>::iterator it;
+
+			for (it = m_retryWaiting.begin();
+				it != m_retryWaiting.end(); it++) {
+				ReqTxn *req = (*it);
+
+				if (req->GetRetrySrcID() == srcID &&
+					req->GetPCrdType() == pcrdType) {
+					m_retryWaiting.erase(it);
+					return req;
+				}
+			}
+			return NULL;
+		}
+
+		void RetryToSlaveNode(ReqTxn *req)
+		{
+			ReqTxn *reqSN;
+
+			assert(req->RetryRequest());
+
+			reqSN = GetMsgPools().req.Get(req->GetReqSNCopy());
+			TransmitToSlaveNode(reqSN);
+		}
+
 		template<typename TxnType>
 		void TransmitToRequestNode(TxnType *t)
 		{
@@ -2643,6 +3010,12 @@ private:
 
 			if (port) {
 				port->Transmit(t);
+			} else {
+				//
+				// Snoop filter back-invalidations are
+				// issued by the HN-F and complete here
+				//
+				t->Release();
 			}
 		}
 
@@ -2652,7 +3025,7 @@ private:
 		Port_RN_F **m_port_RN_F;
 
 		//
-		// Slave Node port
+		// Slave Node ports
 		//
 		Port_SN **m_port_SN;
 
@@ -2666,9 +3039,20 @@ private:
 		//
 		ReqTxn **m_ongoingTxn;
 		RequestOrderer *m_reqOrderer;
+		SnoopFilter *m_snoopFilter;
 
 		// IDVMOpProcessor
 		IDVMOpProcessor *m_poc;
+
+		unsigned int m_snInterleave;
+
+		//
+		// Retry sequence towards the SNs, requests waiting for a
+		// PCrdGrant and granted credits not yet used (per SN and
+		// PCrdType)
+		//
+		std::list<ReqTxn*> m_retryWaiting;
+		std::unordered_map<uint32_t, unsigned int> m_pcrds;
 	};
 
 	//
@@ -2680,11 +3064,13 @@ private:
 		PointOfCoherence(Port_RN_F **port_RN_F,
 				TxnIDs *ids,
 				ReqTxn **ongoingTxn,
-				TxnProcessor& txnProcessor) :
+				TxnProcessor& txnProcessor,
+				SnoopFilter *snoopFilter) :
 			m_port_RN_F(port_RN_F),
 			m_ids(ids),
 			m_ongoingTxn(ongoingTxn),
 			m_txnProcessor(txnProcessor),
+			m_snoopFilter(snoopFilter),
 			m_DCT_enabled(true)
 		{}
 
@@ -2711,7 +3097,7 @@ private:
 				}
 
 				for (it = ports.begin(); it != ports.end(); it++) {
-					SnpMsg *snp = new SnpMsg(req,
+					SnpMsg *snp = GetMsgPools().snp.Get(req,
 								m_ids->GetID(),
 								allowsSnpFwd);
 					Port_RN_F *port = (*it);
@@ -2736,8 +3122,10 @@ private:
 
 				if (port->GetNodeID() != req->GetSrcID()) {
 					uint8_t txnID = m_ids->GetID();
-					SnpMsg *dvmSnp0 = new SnpMsg(req, txnID, false);
-					SnpMsg *dvmSnp1 = new SnpMsg(req, txnID, true);
+					SnpMsg *dvmSnp0 =
+						GetMsgPools().snp.Get(req, txnID, false);
+					SnpMsg *dvmSnp1 =
+						GetMsgPools().snp.Get(req, txnID, true);
 
 					req->WaitForSnpTxn(txnID);
 					m_ongoingTxn[txnID] = req;
@@ -2750,19 +3138,24 @@ private:
 
 		void FillPortsToSnoop(ReqTxn *req, std::list<Port_RN_F*>& ports)
 		{
-			for (int i = 0; i < NUM_CHI_RN_F; i++) {
+			Address addr(req);
+			typename SnoopFilter::Presence presence =
+				m_snoopFilter->GetPresence(addr);
+
+			//
+			// Only the RN-Fs that have the line allocated
+			//
+			for (int i = 0; i < NUM_CHI_RN_F && presence.any(); i++) {
 				Port_RN_F *port = m_port_RN_F[i];
 
+				if (!presence.test(i)) {
+					continue;
+				}
+				presence.reset(i);
+
 				if (port->GetNodeID() != req->GetSrcID() ||
 					req->GetSnpMe()) {
-
-					SnoopFilter& snpFilter =
-						port->GetSnoopFilter();
-					Address addr(req);
-
-					if (snpFilter.ContainsAllocated(addr)) {
-						ports.push_back(port);
-					}
+					ports.push_back(port);
 				}
 			}
 		}
@@ -2777,16 +3170,15 @@ private:
 			if (req) {
 				uint16_t id = rsp.GetSrcID();
 				uint8_t resp = rsp.GetCHIAttr()->GetResp();
-				Port_RN_F *port =
-					m_txnProcessor.LookupPortRNF(id);
+				int portID = m_txnProcessor.LookupPortID(id);
 				bool noFwdedData;
 				bool fwdedDataGotCompAck;
 
 				//
 				// Snoop filter update
 				//
-				if (port) {
-					port->GetSnoopFilter().Update(rsp, req);
+				if (portID >= 0) {
+					m_snoopFilter->Update(portID, rsp, req);
 				}
 
 				//
@@ -2842,16 +3234,16 @@ private:
 				//
 				if (req->AllSnpDataReceived(txnID)) {
 					uint16_t id = dat.GetSrcID();
-					Port_RN_F *port =
-						m_txnProcessor.LookupPortRNF(id);
+					int portID =
+						m_txnProcessor.LookupPortID(id);
 					bool noFwdedData;
 					bool fwdedDataGotCompAck;
 
 					//
 					// Snoop filter update
 					//
-					if (port) {
-						port->GetSnoopFilter().Update(dat, req);
+					if (portID >= 0) {
+						m_snoopFilter->Update(portID, dat, req);
 					}
 
 					//
@@ -2924,6 +3316,7 @@ private:
 		ReqTxn **m_ongoingTxn;
 
 		TxnProcessor& m_txnProcessor;
+		SnoopFilter *m_snoopFilter;
 
 		bool m_DCT_enabled;
 	};
@@ -3045,7 +3438,7 @@ private:
 				}
 			} else if ((port_RN_F = LookupPortRNF(dat.GetTgtID()))) {
 
-				port_RN_F->Transmit(new DatMsg(dat));
+				port_RN_F->Transmit(GetMsgPools().dat.Get(dat));
 			}
 		}
 
@@ -3096,6 +3489,7 @@ private:
 	};
 
 	RequestOrderer m_reqOrderer;
+	SnoopFilter m_snoopFilter;
 	TxnIDs m_ids;
 	ReqTxn *m_ongoingTxn[TxnIDs::NumIDs];
 
@@ -3108,6 +3502,12 @@ public:
 	Port_RN_F *port_RN_F[NUM_CHI_RN_F];
 	Port_SN   *port_SN;
 
+	//
+	// All SN ports, port_SN is ports_SN[0]. SN i has node ID
+	// SLAVE_NODE_ID + i.
+	//
+	Port_SN   *ports_SN[NUM_CHI_SN];
+
 	SC_HAS_PROCESS(iconnect_chi);
 
 	iconnect_chi(sc_module_name name) :
@@ -3116,17 +3516,21 @@ public:
 		m_reqOrderer("reqOrderer",
 				&m_router),
 
+		m_snoopFilter(&m_reqOrderer),
+
 		m_txnProcessor(port_RN_F,
-				&port_SN,
+				ports_SN,
 				&m_ids,
 				m_ongoingTxn,
 				&m_reqOrderer,
+				&m_snoopFilter,
 				&m_poc),
 
 		m_poc(port_RN_F,
 			&m_ids,
 			m_ongoingTxn,
-			m_txnProcessor),
+			m_txnProcessor,
+			&m_snoopFilter),
 
 		m_router(m_poc,
 			m_txnProcessor,
@@ -3143,7 +3547,19 @@ public:
 							portID);
 		}
 
-		port_SN = new Port_SN("Port-SN", &m_router, SLAVE_NODE_ID);
+		for (int i = 0; i < NUM_CHI_SN; i++) {
+			std::ostringstream name;
+
+			name << "Port-SN";
+			if (i) {
+				name << i;
+			}
+
+			ports_SN[i] = new Port_SN(name.str().c_str(),
+							&m_router,
+							SLAVE_NODE_ID + i);
+		}
+		port_SN = ports_SN[0];
 
 		memset(m_ongoingTxn,
 			0x0,
@@ -3152,12 +3568,67 @@ public:
 
 	void EnableDCT(bool enable) { m_poc.EnableDCT(enable); }
 
+	//
+	// Size of the address blocks interleaved across the SNs (power of
+	// 2, at least a cache line, default 4 KB)
+	//
+	void SetSNInterleave(unsigned int granule)
+	{
+		m_txnProcessor.SetSNInterleave(granule);
+	}
+
+	//
+	// Amount of requests (to different cache lines) processed
+	// concurrently, default is one at a time. Requests to the same
+	// line are always processed in order, one at a time.
+	//
+	void SetMaxOutstandingRequests(unsigned int n)
+	{
+		m_reqOrderer.SetMaxOutstanding(n);
+	}
+
+	//
+	// Limit the snoop filter to nrLines cache lines, lines beyond that
+	// are back-invalidated from the RN-Fs. 0 (default) is unlimited.
+	//
+	void SetSnoopFilterCapacity(unsigned int nrLines)
+	{
+		m_snoopFilter.SetCapacity(nrLines);
+	}
+
+	uint64_t GetSnoopFilterBackInvalidations()
+	{
+		return m_snoopFilter.GetBackInvalidations();
+	}
+
+	//
+	// Messages allocated on the heap / handed out by the message pools
+	// (shared between all iconnect_chi instances of the same type).
+	//
+	uint64_t GetMsgPoolAllocs()
+	{
+		MsgPools& pools = GetMsgPools();
+
+		return pools.req.GetAllocs() + pools.rsp.GetAllocs() +
+			pools.dat.GetAllocs() + pools.snp.GetAllocs();
+	}
+
+	uint64_t GetMsgPoolRequests()
+	{
+		MsgPools& pools = GetMsgPools();
+
+		return pools.req.GetGets() + pools.rsp.GetGets() +
+			pools.dat.GetGets() + pools.snp.GetGets();
+	}
+
 	virtual ~iconnect_chi()
 	{
 		for (int i = 0; i < NUM_CHI_RN_F; i++) {
 			delete port_RN_F[i];
 		}
-		delete port_SN;
+		for (int i = 0; i < NUM_CHI_SN; i++) {
+			delete ports_SN[i];
+		}
 	}
 };
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TLM_MODULES_PRIV_CACHE_SETS_H__
+#define TLM_MODULES_PRIV_CACHE_SETS_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//
+// Replacement policies for the set-associative caches (cache_ace, cache_chi)
+//
+enum ReplacementPolicy { ReplaceLRU, ReplacePLRU, ReplaceRandom };
+
+//
+// Per cache instance counters
+//
+struct CacheStats
+{
+	CacheStats()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		hits = 0;
+		misses = 0;
+		evictions = 0;
+		snoop_hits = 0;
+	}
+
+	// Load / store lookups that found / didn't find the line
+	uint64_t hits;
+	uint64_t misses;
+
+	// Valid lines removed to make room for another line
+	uint64_t evictions;
+
+	// Snoops that found the line in the cache
+	uint64_t snoop_hits;
+};
+
+//
+// Replacement state for NUM_SETS sets of NUM_WAYS ways. Touch() is called
+// when a way is accessed and GetVictim() returns the way to replace when
+// the set has no invalid way. GetVictim() does not modify the state, so it
+// can be called repeatedly while a line is being refilled.
+//
+// ReplaceLRU keeps an access stamp per way, ReplacePLRU a binary tree of
+// NUM_WAYS - 1 bits per set (NUM_WAYS must be a power of 2, at most 64).
+// ReplaceRandom picks from a pseudo random sequence advanced at every
+// access.
+//
+template<int NUM_SETS, int NUM_WAYS, int POLICY>
+class CacheReplacement
+{
+public:
+	CacheReplacement() :
+		m_state(POLICY == ReplacePLRU ? NUM_SETS : NUM_SETS * NUM_WAYS, 0),
+		m_clock(0),
+		m_rand(0x9e3779b9)
+	{
+		static_assert(NUM_SETS > 0 && NUM_WAYS > 0,
+				"The cache must have at least one set and way");
+		static_assert(POLICY != ReplacePLRU ||
+				(NUM_WAYS <= 64 &&
+				 (NUM_WAYS & (NUM_WAYS - 1)) == 0),
+				"PLRU requires a power of 2 ways, at most 64");
+	}
+
+	void Touch(unsigned int set, unsigned int way)
+	{
+		switch (POLICY) {
+		case ReplaceLRU:
+			m_state[set * NUM_WAYS + way] = ++m_clock;
+			break;
+		case ReplacePLRU:
+		{
+			uint64_t& bits = m_state[set];
+			unsigned int node = 1;
+			unsigned int level;
+
+			//
+			// Point every node on the path away from way
+			//
+			for (level = NUM_WAYS >> 1; level; level >>= 1) {
+				unsigned int right = (way & level) ? 1 : 0;
+
+				if (right) {
+					bits &= ~(1ULL << node);
+				} else {
+					bits |= 1ULL << node;
+				}
+				node = node * 2 + right;
+			}
+			break;
+		}
+		case ReplaceRandom:
+		default:
+			// xorshift32
+			m_rand ^= m_rand << 13;
+			m_rand ^= m_rand >> 17;
+			m_rand ^= m_rand << 5;
+			break;
+		}
+	}
+
+	unsigned int GetVictim(unsigned int set)
+	{
+		switch (POLICY) {
+		case ReplaceLRU:
+		{
+			uint64_t *stamps = &m_state[set * NUM_WAYS];
+			unsigned int victim = 0;
+			unsigned int way;
+
+			for (way = 1; way < NUM_WAYS; way++) {
+				if (stamps[way] < stamps[victim]) {
+					victim = way;
+				}
+			}
+			return victim;
+		}
+		case ReplacePLRU:
+		{
+			uint64_t bits = m_state[set];
+			unsigned int node = 1;
+
+			while (node < NUM_WAYS) {
+				node = node * 2 + ((bits >> node) & 1);
+			}
+			return node - NUM_WAYS;
+		}
+		case ReplaceRandom:
+		default:
+			return (m_rand ^ (set * 0x9e3779b9)) % NUM_WAYS;
+		}
+	}
+
+private:
+	std::vector<uint64_t> m_state;
+	uint64_t m_clock;
+	uint32_t m_rand;
+};
+
+#endif /* TLM_MODULES_PRIV_CACHE_SETS_H__ */
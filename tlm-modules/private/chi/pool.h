@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TLM_MODULES_PRIV_CHI_POOL_H__
+#define TLM_MODULES_PRIV_CHI_POOL_H__
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace AMBA {
+namespace CHI {
+
+//
+// Where a pooled object returns itself when released
+//
+template<typename Base>
+class IObjPool
+{
+public:
+	virtual ~IObjPool() {}
+
+	virtual void Put(Base *b) = 0;
+};
+
+//
+// Free list of T objects (CHI messages and transactions). Released objects
+// are kept constructed, together with the generic payloads and extensions
+// they own, and are handed out again after T::Recycle() followed by
+// T::Init(args...), where Init takes the same arguments as the matching
+// constructor. Steady state traffic thereby doesn't allocate on the heap.
+//
+// T gets a pointer to the pool through T::SetPool() and returns itself
+// with Put() (T::Release()).
+//
+template<typename T, typename Base = T>
+class ObjPool : public IObjPool<Base>
+{
+public:
+	ObjPool() :
+		m_allocs(0),
+		m_gets(0)
+	{}
+
+	virtual ~ObjPool()
+	{
+		typename std::vector<T*>::iterator it;
+
+		for (it = m_free.begin(); it != m_free.end(); it++) {
+			delete (*it);
+		}
+	}
+
+	template<typename... Args>
+	T *Get(Args&&... args)
+	{
+		T *t;
+
+		m_gets++;
+
+		if (m_free.empty()) {
+			m_allocs++;
+			t = new T(std::forward<Args>(args)...);
+		} else {
+			t = m_free.back();
+			m_free.pop_back();
+
+			t->Recycle();
+			t->Init(std::forward<Args>(args)...);
+		}
+
+		t->SetPool(this);
+
+		return t;
+	}
+
+	void Put(Base *b)
+	{
+		m_free.push_back(static_cast<T*>(b));
+	}
+
+	// Objects allocated on the heap
+	uint64_t GetAllocs() { return m_allocs; }
+
+	// Objects handed out, allocated or recycled
+	uint64_t GetGets() { return m_gets; }
+
+private:
+	std::vector<T*> m_free;
+
+	uint64_t m_allocs;
+	uint64_t m_gets;
+};
+
+} /* namespace CHI */
+} /* namespace AMBA */
+
+#endif /* TLM_MODULES_PRIV_CHI_POOL_H__ */
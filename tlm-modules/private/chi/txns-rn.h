@@ -36,6 +36,7 @@
 #include "tlm-extensions/chiattr.h"
 #include "tlm-bridges/amba-chi.h"
 #include "tlm-modules/private/chi/cacheline.h"
+#include "tlm-modules/private/chi/pool.h"
 
 namespace AMBA {
 namespace CHI {
@@ -56,7 +57,8 @@ public:
 		m_isSnp(isSnp),
 		m_gotRetryAck(false),
 		m_gotPCrdGrant(false),
-		m_isWriteUniqueWithCompAck(false)
+		m_isWriteUniqueWithCompAck(false),
+		m_pool(NULL)
 	{
 		m_chiattr->SetSrcID(NODE_ID);
 
@@ -95,6 +97,25 @@ public:
 		}
 	}
 
+	void SetPool(IObjPool<ITxn> *pool) { m_pool = pool; }
+
+	//
+	// Transactions taken from a pool are returned to it (after
+	// releasing the txnID as the destructor does), others are deleted.
+	//
+	void Release()
+	{
+		if (m_pool) {
+			if (m_ids) {
+				m_ids->ReturnID(m_txnID);
+				m_ids = NULL;
+			}
+			m_pool->Put(this);
+		} else {
+			delete this;
+		}
+	}
+
 	bool DoAssertCheck(uint8_t opcode)
 	{
 		if (opcode >= Req::AtomicStore &&
@@ -189,6 +210,27 @@ public:
 
 protected:
 
+	//
+	// Restore the state set up by the constructor for a pooled
+	// transaction, keeping the chiattr allocation.
+	//
+	void Recycle()
+	{
+		m_l = NULL;
+		m_txnID = 0;
+		m_gotRetryAck = false;
+		m_gotPCrdGrant = false;
+		m_isWriteUniqueWithCompAck = false;
+
+		m_gp.clear_extension(m_chiattr);
+		m_gp.free_all_extensions();
+
+		*m_chiattr = chiattr_extension();
+		m_chiattr->SetSrcID(NODE_ID);
+
+		m_gp.set_extension(m_chiattr);
+	}
+
 	//
 	// Copy over relevant attributes for transactions that will
 	// fill read in / allocate a cacheline.
@@ -317,6 +359,8 @@ protected:
 	bool m_gotRetryAck;
 	bool m_gotPCrdGrant;
 	bool m_isWriteUniqueWithCompAck;
+
+	IObjPool<ITxn> *m_pool;
 };
 
 template<
@@ -1575,6 +1619,16 @@ public:
 		m_transmitCompAck(false),
 		m_fwdAttr(new chiattr_extension()),
 		m_received(0)
+	{
+		Init(gp);
+
+		//
+		// Take over ownership
+		//
+		m_fwdGP.set_extension(m_fwdAttr);
+	}
+
+	void Init(tlm::tlm_generic_payload& gp)
 	{
 		//
 		// Store the snoop req
@@ -1588,11 +1642,22 @@ public:
 		// Default init as SnpResp without data
 		//
 		InitSnpResp();
+	}
 
-		//
-		// Take over ownership
-		//
-		m_fwdGP.set_extension(m_fwdAttr);
+	void Recycle()
+	{
+		ITxn_t::Recycle();
+
+		// Set by ITxn for all opcodes except PrefetchTgt
+		m_chiattr->SetAllowRetry(true);
+
+		m_dataToHomeNode = false;
+		m_dataToReqNode = false;
+		m_gotCompData = true;
+		m_transmitCompAck = false;
+		m_received = 0;
+
+		*m_fwdAttr = chiattr_extension();
 	}
 
 	void InitSnpResp()
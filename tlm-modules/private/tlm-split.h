@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TLM_MODULES_PRIV_TLM_SPLIT_H__
+#define TLM_MODULES_PRIV_TLM_SPLIT_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "tlm.h"
+
+//
+// Per module counters of the transactions that had to be split up
+//
+struct tlm_split_stats
+{
+	tlm_split_stats()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		transactions = 0;
+		split = 0;
+		pieces = 0;
+	}
+
+	// Transactions received
+	uint64_t transactions;
+
+	// Transactions that were split up
+	uint64_t split;
+
+	// Transactions issued for the split up ones
+	uint64_t pieces;
+};
+
+//
+// Generic payloads for the pieces of a split up transaction (tlm_aligner,
+// tlm_wrap_expander). A piece points into the original transaction's data
+// and byte enables and shares its extensions (the pointers, not clones), so
+// once the free list has warmed up splitting doesn't allocate or copy
+// anything. Only a piece starting in the middle of the byte enable pattern
+// and running past its end gets the byte enables rotated into the piece's
+// scratch buffer.
+//
+// The free list holds one piece per transaction being split concurrently
+// (b_transport may be re-entered while a piece waits downstream).
+//
+class tlm_split_engine
+{
+public:
+	class piece : public tlm::tlm_generic_payload
+	{
+	public:
+		std::vector<unsigned char> be_scratch;
+	};
+
+	~tlm_split_engine()
+	{
+		std::vector<piece*>::iterator it;
+
+		for (it = m_free.begin(); it != m_free.end(); it++) {
+			delete (*it);
+		}
+	}
+
+	//
+	// Returns a piece set up as trans
+	//
+	piece *get(tlm::tlm_generic_payload& trans)
+	{
+		unsigned int i;
+		piece *p;
+
+		if (m_free.empty()) {
+			p = new piece();
+		} else {
+			p = m_free.back();
+			m_free.pop_back();
+		}
+
+		p->set_command(trans.get_command());
+		p->set_address(trans.get_address());
+		p->set_data_ptr(trans.get_data_ptr());
+		p->set_data_length(trans.get_data_length());
+		p->set_byte_enable_ptr(trans.get_byte_enable_ptr());
+		p->set_byte_enable_length(trans.get_byte_enable_length());
+		p->set_streaming_width(trans.get_streaming_width());
+		p->set_response_status(trans.get_response_status());
+		p->set_dmi_allowed(false);
+
+		for (i = 0; i < tlm::max_num_extensions(); i++) {
+			p->set_extension(i, trans.get_extension(i));
+		}
+
+		stats.split++;
+		return p;
+	}
+
+	//
+	// Propagates the response of the last piece issued to trans and
+	// returns the piece to the free list
+	//
+	void put(tlm::tlm_generic_payload& trans, piece *p)
+	{
+		unsigned int i;
+
+		trans.set_response_status(p->get_response_status());
+		trans.set_dmi_allowed(p->is_dmi_allowed());
+
+		//
+		// The extensions shared with trans belong to trans, the ones
+		// added downstream to the piece are freed (as when the piece
+		// would have been destroyed).
+		//
+		for (i = 0; i < tlm::max_num_extensions(); i++) {
+			tlm::tlm_extension_base *ext = p->get_extension(i);
+
+			if (ext && ext != trans.get_extension(i)) {
+				ext->free();
+			}
+			p->set_extension(i, NULL);
+		}
+
+		m_free.push_back(p);
+	}
+
+	//
+	// Sets up the byte enables of a piece covering bytes [pos, pos + len)
+	// of trans, the byte enable pattern repeats every be_len bytes.
+	//
+	void set_byte_enables(piece *p, tlm::tlm_generic_payload& trans,
+				unsigned int pos, unsigned int len)
+	{
+		unsigned char *be = trans.get_byte_enable_ptr();
+		unsigned int be_len = trans.get_byte_enable_length();
+		unsigned int offset;
+
+		if (be_len == 0) {
+			return;
+		}
+
+		offset = pos % be_len;
+
+		if (offset == 0) {
+			p->set_byte_enable_ptr(be);
+			p->set_byte_enable_length(be_len);
+		} else if (len <= be_len - offset) {
+			p->set_byte_enable_ptr(be + offset);
+			p->set_byte_enable_length(len);
+		} else {
+			p->be_scratch.resize(be_len);
+			memcpy(&p->be_scratch[0], be + offset, be_len - offset);
+			memcpy(&p->be_scratch[be_len - offset], be, offset);
+
+			p->set_byte_enable_ptr(&p->be_scratch[0]);
+			p->set_byte_enable_length(be_len);
+		}
+	}
+
+	tlm_split_stats stats;
+
+private:
+	std::vector<piece*> m_free;
+};
+
+#endif /* TLM_MODULES_PRIV_TLM_SPLIT_H__ */
@@ -25,6 +25,8 @@
 
 #include <stdint.h>
 
+#include "tlm-modules/private/tlm-split.h"
+
 #define D(x)
 
 #ifndef MIN
@@ -63,6 +65,12 @@ public:
 		m_validator(validator)
 	{
 		target_socket.register_b_transport(this, &tlm_aligner::b_transport);
+		target_socket.register_transport_dbg(this,
+				&tlm_aligner::transport_dbg);
+		target_socket.register_get_direct_mem_ptr(this,
+				&tlm_aligner::get_direct_mem_ptr);
+		init_socket.register_invalidate_direct_mem_ptr(this,
+				&tlm_aligner::invalidate_direct_mem_ptr);
 	}
 
 	void set_bus_width(uint32_t w) {
@@ -81,6 +89,10 @@ public:
 		return max_len;
 	}
 
+	tlm_split_stats& get_split_stats(void) {
+		return m_split.stats;
+	}
+
 private:
 	// Bus with in bits.
 	uint32_t bus_width;
@@ -93,6 +105,7 @@ private:
 	uint64_t max_address_boundary;
 	bool do_natural_alignment;
 	IValidator *m_validator;
+	tlm_split_engine m_split;
 
 	uint64_t compute_natural_alignment(uint64_t addr)
 	{
@@ -120,17 +133,17 @@ private:
 	virtual void b_transport(tlm::tlm_generic_payload& trans,
 				sc_time& delay)
 	{
-		unsigned int be_len = trans.get_byte_enable_length();
 		unsigned char *data = trans.get_data_ptr();
 		unsigned int len = trans.get_data_length();
 		unsigned int streaming_width = trans.get_streaming_width();
 		sc_dt::uint64 addr = trans.get_address();
-		tlm::tlm_generic_payload gp;
+		tlm_split_engine::piece *gp;
 		uint64_t natural_alignment;
-		unsigned char *be = NULL;
 		unsigned int pos = 0;
 		uint64_t addr_range;
 
+		m_split.stats.transactions++;
+
 		natural_alignment = compute_natural_alignment(addr);
 		addr_range = compute_max_addr_range(addr, natural_alignment);
 
@@ -149,23 +162,9 @@ private:
 			return;
 		}
 
-		// Since data and byte_enable ptrs remain NULL, nothing gets copied.
-		// This is true with acceleras Open Source implementation, but is it
-		// true by spec?
-		gp.deep_copy_from(trans);
-
-		if (be_len) {
-			be = new uint8_t[be_len * 2];
-			if (!be) {
-				trans.set_response_status(tlm::TLM_GENERIC_ERROR_RESPONSE);
-				return;
-			}
-			// Copy two consecutive copies so we can do a sliding window.
-			memcpy(be, trans.get_byte_enable_ptr(), be_len);
-			memcpy(be + be_len, be, be_len);
-		}
-
 		// Need to chop this one up into multiple transactions.
+		gp = m_split.get(trans);
+
 		while (pos < len) {
 			uint64_t t_addr = addr + (pos % streaming_width);
 			unsigned int t_len;
@@ -178,42 +177,57 @@ private:
 			if (pos % streaming_width != 0) {
 				// Make a single beat to align with streaming width
 				t_len = MIN(t_len, streaming_width - (pos % streaming_width));
-				gp.set_streaming_width(t_len);
+				gp->set_streaming_width(t_len);
 			} else if (streaming_width != len) {
 				if (m_validator &&
 					m_validator->validate(t_addr, t_len, streaming_width)) {
-					gp.set_streaming_width(streaming_width);
+					gp->set_streaming_width(streaming_width);
 				} else {
 					unsigned int bus_width_bytes = MIN(bus_width / 8, streaming_width);
 
 					// Chop up into multiple beats.
 					t_len = MIN(t_len, bus_width_bytes);
-					gp.set_streaming_width(t_len);
+					gp->set_streaming_width(t_len);
 				}
 			}
 
 			assert(t_len > 0);
 			assert(t_len <= max_len);
-			gp.set_address(t_addr);
-			gp.set_data_ptr(data + pos);
-			gp.set_data_length(t_len);
-
-			if (be_len) {
-				// Sliding window of byte-enables.
-				gp.set_byte_enable_ptr(be + (pos % be_len));
-			}
-
-			init_socket->b_transport(gp, delay);
-			if (gp.get_response_status() != tlm::TLM_OK_RESPONSE) {
+			gp->set_address(t_addr);
+			gp->set_data_ptr(data + pos);
+			gp->set_data_length(t_len);
+			m_split.set_byte_enables(gp, trans, pos, t_len);
+
+			m_split.stats.pieces++;
+			init_socket->b_transport(*gp, delay);
+			if (gp->get_response_status() != tlm::TLM_OK_RESPONSE) {
 				break;
 			}
 
 			pos += t_len;
 		}
-		// Restore data ptr from start-pos for update_from_original()
-		gp.set_data_ptr(trans.get_data_ptr());
-		trans.update_original_from(gp);
-		delete[] be;
+		m_split.put(trans, gp);
+	}
+
+	//
+	// Debug and DMI accesses are forwarded as they are, the
+	// alignment constraints only apply to the transactions on the bus.
+	//
+	virtual unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
+	{
+		return init_socket->transport_dbg(trans);
+	}
+
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data)
+	{
+		return init_socket->get_direct_mem_ptr(trans, dmi_data);
+	}
+
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		target_socket->invalidate_direct_mem_ptr(start, end);
 	}
 };
 #endif
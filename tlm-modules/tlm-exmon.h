@@ -29,7 +29,9 @@
 #ifndef TLM_EXMON_H__
 #define TLM_EXMON_H__
 
-#include <list>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
 
 #include "tlm.h"
 #include "tlm_utils/simple_initiator_socket.h"
@@ -45,89 +47,183 @@ public:
 	tlm_exclusive_monitor(sc_core::sc_module_name name,
 				uint32_t id_mask = 0xF) :
 		sc_core::sc_module(name),
+		m_wide(NULL),
+		m_nr_valid(0),
 		m_id_mask(id_mask)
 	{
+		memset(m_buckets, 0, sizeof(m_buckets));
+
 		target_socket.register_b_transport(this, &tlm_exclusive_monitor::b_transport);
+		target_socket.register_transport_dbg(this,
+				&tlm_exclusive_monitor::transport_dbg);
+		target_socket.register_get_direct_mem_ptr(this,
+				&tlm_exclusive_monitor::get_direct_mem_ptr);
+		init_socket.register_invalidate_direct_mem_ptr(this,
+				&tlm_exclusive_monitor::invalidate_direct_mem_ptr);
 	}
 
 	~tlm_exclusive_monitor()
 	{
-		monitor_clear();
+		std::vector<Reservation*>::iterator it;
+
+		for (it = m_slots.begin(); it != m_slots.end(); it++) {
+			delete (*it);
+		}
 	}
 
+	struct Stats
+	{
+		Stats()
+		{
+			reset();
+		}
+
+		void reset()
+		{
+			exclusive_reads = 0;
+			exclusive_writes_ok = 0;
+			exclusive_writes_failed = 0;
+			cleared = 0;
+		}
+
+		// Exclusive reads that started monitoring a location
+		uint64_t exclusive_reads;
+
+		// Exclusive writes that did / did not update the location
+		uint64_t exclusive_writes_ok;
+		uint64_t exclusive_writes_failed;
+
+		// Monitored locations cleared by writes
+		uint64_t cleared;
+	};
+
+	Stats& get_stats() { return m_stats; }
+
 private:
-	class Transaction
+	enum {
+		//
+		// Monitored locations are hashed into NR_BUCKETS buckets by
+		// their 2^GRANULE_BITS byte granule ([1] limits exclusive
+		// accesses to 128 bytes, aligned to their size, so they stay
+		// within one granule).
+		//
+		GRANULE_BITS = 7,
+		NR_BUCKETS = 256,
+	};
+
+	//
+	// The location monitored for one masked id ([1] recommends one
+	// exclusive monitor for every exclusive capable master). A slot is
+	// allocated the first time a masked id does an exclusive read and is
+	// then reused, while valid it is linked into the bucket of its
+	// location (or m_wide if it crosses a granule).
+	//
+	class Reservation
 	{
 	public:
-		Transaction(tlm::tlm_generic_payload& gp, uint32_t id_mask) :
-			m_id_mask(id_mask)
+		Reservation(uint32_t masked_id) :
+			valid(false),
+			masked_id(masked_id),
+			start(0),
+			end(0),
+			next(NULL),
+			pprev(NULL)
+		{}
+
+		bool overlaps(uint64_t s, uint64_t e)
 		{
-			genattr_extension *genattr;
+			return start <= e && end >= s;
+		}
 
-			m_gp.set_address(gp.get_address());
-			m_gp.set_data_length(gp.get_data_length());
+		bool valid;
+		uint32_t masked_id;
+		uint64_t start;
+		uint64_t end;
 
-			gp.get_extension(genattr);
-			if (genattr) {
-				m_genattr.copy_from(*genattr);
-			}
-		}
+		Reservation *next;
+		Reservation **pprev;
+	};
 
-		bool has_location(tlm::tlm_generic_payload& gp)
-		{
-			uint64_t addr = m_gp.get_address();
-			unsigned int len = m_gp.get_data_length();
+	static uint64_t get_end(tlm::tlm_generic_payload& trans)
+	{
+		unsigned int len = trans.get_data_length();
 
-			return gp.get_address() >= addr &&
-				gp.get_address() < (addr + len);
-		}
+		return trans.get_address() + (len ? len - 1 : 0);
+	}
 
-		bool has_same_location(tlm::tlm_generic_payload& gp)
-		{
-			return m_gp.get_address() == gp.get_address() &&
-				m_gp.get_data_length() == gp.get_data_length();
+	bool get_masked_id(tlm::tlm_generic_payload& trans, uint32_t& masked_id)
+	{
+		genattr_extension *genattr;
+
+		trans.get_extension(genattr);
+		if (genattr) {
+			masked_id = genattr->get_transaction_id() & m_id_mask;
+			return true;
 		}
 
-		bool has_masked_id(tlm::tlm_generic_payload& gp)
-		{
-			genattr_extension *genattr;
+		return false;
+	}
 
-			gp.get_extension(genattr);
-			if (genattr) {
-				uint32_t masked_id =
-					genattr->get_transaction_id() & m_id_mask;
+	Reservation **get_bucket(uint64_t start, uint64_t end)
+	{
+		uint64_t granule = start >> GRANULE_BITS;
 
-				return get_masked_id() == masked_id;
-			}
+		if (granule != (end >> GRANULE_BITS)) {
+			return &m_wide;
+		}
+		return &m_buckets[granule % NR_BUCKETS];
+	}
 
-			return false;
+	void link(Reservation *r)
+	{
+		Reservation **head = get_bucket(r->start, r->end);
+
+		r->next = *head;
+		r->pprev = head;
+		if (r->next) {
+			r->next->pprev = &r->next;
 		}
+		*head = r;
 
+		r->valid = true;
+		m_nr_valid++;
+	}
 
-		//
-		// Get the masked id ([1] recommends one exclusive monitor for
-		// every exclusive capable master).
-		//
-		uint32_t get_masked_id()
-		{
-			return m_genattr.get_transaction_id() & m_id_mask;
+	void unlink(Reservation *r)
+	{
+		*r->pprev = r->next;
+		if (r->next) {
+			r->next->pprev = r->pprev;
 		}
+		r->next = NULL;
+		r->pprev = NULL;
 
-	private:
-		tlm::tlm_generic_payload m_gp;
-		genattr_extension m_genattr;
-		uint32_t m_id_mask;
-	};
+		r->valid = false;
+		m_nr_valid--;
+	}
 
-	void monitor_clear()
+	Reservation *get_slot(uint32_t masked_id)
 	{
-		for (std::list<Transaction*>::iterator it = m_monitor.begin();
-			it != m_monitor.end();) {
-			Transaction *t = (*it);
+		std::unordered_map<uint32_t, Reservation*>::iterator it;
+		Reservation *r;
 
-			it = m_monitor.erase(it);
-			delete t;
+		it = m_slot_by_id.find(masked_id);
+		if (it != m_slot_by_id.end()) {
+			return it->second;
 		}
+
+		r = new Reservation(masked_id);
+		m_slots.push_back(r);
+		m_slot_by_id[masked_id] = r;
+		return r;
+	}
+
+	Reservation *find_slot(uint32_t masked_id)
+	{
+		std::unordered_map<uint32_t, Reservation*>::iterator it;
+
+		it = m_slot_by_id.find(masked_id);
+		return it != m_slot_by_id.end() ? it->second : NULL;
 	}
 
 	bool is_exclusive(tlm::tlm_generic_payload& trans)
@@ -144,55 +240,91 @@ private:
 
 	bool is_monitored_location(tlm::tlm_generic_payload& trans)
 	{
-		for (std::list<Transaction*>::iterator it = m_monitor.begin();
-			it != m_monitor.end(); it++) {
-			Transaction *t = (*it);
+		uint32_t masked_id;
+		Reservation *r;
 
-			if (t->has_masked_id(trans) &&
-				t->has_same_location(trans)) {
-				return true;
-			}
+		if (!get_masked_id(trans, masked_id)) {
+			return false;
 		}
-		return false;
+
+		r = find_slot(masked_id);
+
+		return r && r->valid &&
+			r->start == trans.get_address() &&
+			r->end == get_end(trans);
 	}
 
-	void monitor_clear_locations(tlm::tlm_generic_payload& trans)
+	void clear_chain(Reservation *r, uint64_t start, uint64_t end)
 	{
-		for (std::list<Transaction*>::iterator it = m_monitor.begin();
-			it != m_monitor.end();) {
-			Transaction *t = (*it);
+		while (r) {
+			Reservation *next = r->next;
 
-			if (t->has_location(trans)) {
-				it = m_monitor.erase(it);
-				delete t;
-			} else {
-				it++;
+			if (r->overlaps(start, end)) {
+				unlink(r);
+				m_stats.cleared++;
 			}
+			r = next;
 		}
 	}
 
-	void monitor_clear_id(uint32_t masked_id)
+	//
+	// Stop monitoring the locations overlapping the written bytes
+	//
+	void monitor_clear_locations(tlm::tlm_generic_payload& trans)
 	{
-		for (std::list<Transaction*>::iterator it = m_monitor.begin();
-			it != m_monitor.end(); it++) {
-			Transaction *t = (*it);
-
-			if (t->get_masked_id() == masked_id) {
-				m_monitor.remove(t);
-				delete t;
-				return;
+		uint64_t start = trans.get_address();
+		uint64_t end = get_end(trans);
+		uint64_t first = start >> GRANULE_BITS;
+		uint64_t last = end >> GRANULE_BITS;
+		uint64_t g;
+
+		if (m_nr_valid == 0) {
+			return;
+		}
+
+		clear_chain(m_wide, start, end);
+
+		if (last - first >= NR_BUCKETS) {
+			// Covers all buckets
+			for (g = 0; g < NR_BUCKETS; g++) {
+				clear_chain(m_buckets[g], start, end);
 			}
+			return;
+		}
+
+		for (g = first; g <= last; g++) {
+			clear_chain(m_buckets[g % NR_BUCKETS], start, end);
 		}
 	}
 
 	void monitor_location(tlm::tlm_generic_payload& trans)
 	{
-		Transaction *t = new Transaction(trans, m_id_mask);
+		uint32_t masked_id = 0;
+		Reservation *r;
+
+		// Without genattr the location can't be matched by the
+		// exclusive write, monitor it as masked id 0 anyway.
+		get_masked_id(trans, masked_id);
+
+		r = get_slot(masked_id);
 
 		// If already monitoring transaction ID, remove the old one.
-		monitor_clear_id(t->get_masked_id());
+		if (r->valid) {
+			unlink(r);
+		}
 
-		m_monitor.push_back(t);
+		r->start = trans.get_address();
+		r->end = get_end(trans);
+		link(r);
+
+		m_stats.exclusive_reads++;
+
+		//
+		// Stores through DMI pointers would bypass the monitor,
+		// revoke write access to the location (see
+		// get_direct_mem_ptr).
+		//
+		target_socket->invalidate_direct_mem_ptr(r->start, r->end);
 	}
 
 	void set_exclusive_handled(tlm::tlm_generic_payload& trans)
@@ -218,6 +350,7 @@ private:
 				set_exclusive_handled(trans);
 
 				if (is_monitored_location(trans)) {
+					m_stats.exclusive_writes_ok++;
 					monitor_clear_locations(trans);
 				} else {
 					//
@@ -229,6 +362,7 @@ private:
 					// response.
 					//
 
+					m_stats.exclusive_writes_failed++;
 					trans.set_response_status(tlm::TLM_OK_RESPONSE);
 					return;
 				}
@@ -253,7 +387,87 @@ private:
 		}
 	}
 
-	std::list<Transaction*> m_monitor;
+	virtual unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
+	{
+		return init_socket->transport_dbg(trans);
+	}
+
+	//
+	// Monitored locations are kept out of the granted DMI range. If the
+	// requested address itself is monitored only read access is granted,
+	// limited to the monitored location, so stores keep going through
+	// b_transport.
+	//
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data)
+	{
+		uint64_t addr = trans.get_address();
+
+		if (!init_socket->get_direct_mem_ptr(trans, dmi_data)) {
+			return false;
+		}
+
+		for (std::vector<Reservation*>::iterator it = m_slots.begin();
+			it != m_slots.end(); it++) {
+			Reservation *r = (*it);
+			uint64_t start = r->start;
+			uint64_t end = r->end;
+
+			if (!r->valid) {
+				continue;
+			}
+
+			if (end < dmi_data.get_start_address() ||
+				start > dmi_data.get_end_address()) {
+				continue;
+			}
+
+			if (addr >= start && addr <= end) {
+				if (!dmi_data.is_read_allowed()) {
+					return false;
+				}
+				dmi_restrict(dmi_data, start, end);
+				dmi_data.allow_read();
+			} else if (end < addr) {
+				dmi_restrict(dmi_data, end + 1,
+						dmi_data.get_end_address());
+			} else {
+				dmi_restrict(dmi_data,
+						dmi_data.get_start_address(),
+						start - 1);
+			}
+		}
+
+		return true;
+	}
+
+	void dmi_restrict(tlm::tlm_dmi& dmi_data, uint64_t start, uint64_t end)
+	{
+		if (start > dmi_data.get_start_address()) {
+			uint64_t offset = start - dmi_data.get_start_address();
+
+			dmi_data.set_dmi_ptr(dmi_data.get_dmi_ptr() + offset);
+			dmi_data.set_start_address(start);
+		}
+		if (end < dmi_data.get_end_address()) {
+			dmi_data.set_end_address(end);
+		}
+	}
+
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		target_socket->invalidate_direct_mem_ptr(start, end);
+	}
+
+	Reservation *m_buckets[NR_BUCKETS];
+	Reservation *m_wide;
+	unsigned int m_nr_valid;
+
+	std::vector<Reservation*> m_slots;
+	std::unordered_map<uint32_t, Reservation*> m_slot_by_id;
+
 	uint32_t m_id_mask;
+	Stats m_stats;
 };
 #endif
@@ -23,7 +23,11 @@
 #ifndef TLM_SPLITTER_H__
 #define TLM_SPLITTER_H__
 
+#include <assert.h>
 #include <stdint.h>
+#include <string.h>
+#include <sstream>
+#include <vector>
 #include "tests/test-modules/hexdump.h"
 
 #define TLM_SPLITTER_ERROR "TLM Splitter Error"
@@ -33,6 +37,15 @@
  * on our slave port will be replicated on all the outgoing master ports.
  *
  * Optionally, the module can verify that all data responses for reads match.
+ *
+ * By default the ports are called one after the other, so the delays of
+ * all targets add up. In parallel mode the transaction is issued on all
+ * ports at once, ports 1 and up from spawned processes (the includer must
+ * define SC_INCLUDE_DYNAMIC_PROCESSES), and the returned delay is the
+ * largest one. Ports 1 and up then get their own copy of the payload, with
+ * the read data going to a buffer of their own, so the targets don't
+ * overwrite each other's data. b_transport waits for the ports in this
+ * mode, so it can't be called from an SC_METHOD.
  */
 template<unsigned int NR_INIT_SOCKETS>
 class tlm_splitter : public sc_core::sc_module
@@ -41,8 +54,10 @@ public:
 	tlm_utils::simple_target_socket<tlm_splitter> target_socket;
 	tlm_utils::simple_initiator_socket_tagged<tlm_splitter> *i_sk[NR_INIT_SOCKETS];
 
-	tlm_splitter(sc_core::sc_module_name name, bool do_check_read_data = false) :
-		do_check_read_data(do_check_read_data)
+	tlm_splitter(sc_core::sc_module_name name, bool do_check_read_data = false,
+			bool parallel = false) :
+		do_check_read_data(do_check_read_data),
+		parallel(parallel)
 	{
 		char sk_name[64];
 		unsigned int i;
@@ -50,21 +65,113 @@ public:
 		for (i = 0; i < NR_INIT_SOCKETS; i++) {
 			sprintf(sk_name, "init_socket_%d", i);
 			i_sk[i] = new tlm_utils::simple_initiator_socket_tagged<tlm_splitter>(sk_name);
+			i_sk[i]->register_invalidate_direct_mem_ptr(this,
+				&tlm_splitter::invalidate_direct_mem_ptr, i);
 		}
 		target_socket.register_b_transport(this, &tlm_splitter::b_transport);
+		target_socket.register_transport_dbg(this,
+				&tlm_splitter::transport_dbg);
+		target_socket.register_get_direct_mem_ptr(this,
+				&tlm_splitter::get_direct_mem_ptr);
 	}
+
+	~tlm_splitter()
+	{
+		typename std::vector<fanout*>::iterator it;
+
+		for (it = m_free.begin(); it != m_free.end(); it++) {
+			delete (*it);
+		}
+	}
+
 private:
+	//
+	// State of one transaction being replicated. Kept on a free list (one
+	// per transaction in flight) together with the data buffers, so
+	// steady state traffic doesn't allocate.
+	//
+	struct fanout
+	{
+		// Ports 1 and up in parallel mode
+		tlm::tlm_generic_payload gp[NR_INIT_SOCKETS];
+		sc_time delay[NR_INIT_SOCKETS];
+
+		// Parallel mode, when each port's access completes
+		// (sc_time_stamp() + delay as returned by the port)
+		sc_time end[NR_INIT_SOCKETS];
+
+		// Read data of ports 1 and up in parallel mode, the
+		// reference read data (port 0) in sequential mode
+		std::vector<uint8_t> data[NR_INIT_SOCKETS];
+
+		unsigned int pending;
+		sc_event done;
+	};
+
 	bool do_check_read_data;
+	bool parallel;
+	std::vector<fanout*> m_free;
+
+	fanout *get_fanout()
+	{
+		fanout *f;
+
+		if (m_free.empty()) {
+			return new fanout();
+		}
+
+		f = m_free.back();
+		m_free.pop_back();
+		return f;
+	}
+
+	//
+	// Compares the read data returned on port i with the reference and
+	// reports the first mismatching byte
+	//
+	void check_read_data(unsigned char *ref, unsigned char *data,
+				unsigned int len, unsigned int i)
+	{
+		std::ostringstream msg;
+		unsigned int pos;
+
+		if (!memcmp(ref, data, len)) {
+			return;
+		}
+
+		for (pos = 0; ref[pos] == data[pos]; pos++) {
+			;
+		}
+
+		hexdump("ref-data", ref, len);
+		hexdump("data", data, len);
+
+		msg << "Read-data missmatch on init_socket_" << i
+			<< " at offset " << pos;
+		SC_REPORT_ERROR(TLM_SPLITTER_ERROR, msg.str().c_str());
+	}
 
 	virtual void b_transport(tlm::tlm_generic_payload &trans, sc_time &delay) {
+		if (parallel && NR_INIT_SOCKETS > 1) {
+			b_transport_parallel(trans, delay);
+		} else {
+			b_transport_sequential(trans, delay);
+		}
+	}
+
+	void b_transport_sequential(tlm::tlm_generic_payload &trans,
+					sc_time &delay)
+	{
 		unsigned char *data = trans.get_data_ptr();
 		unsigned int len = trans.get_data_length();
+		bool check = do_check_read_data && trans.is_read();
 		tlm::tlm_response_status resp_status = tlm::TLM_OK_RESPONSE;
-		uint8_t *ref_data = NULL;
+		fanout *f = NULL;
 		unsigned int i;
 
-		if (do_check_read_data && trans.is_read()) {
-			ref_data = new uint8_t[len];
+		if (check) {
+			f = get_fanout();
+			f->data[0].resize(len);
 		}
 
 		for (i = 0; i < NR_INIT_SOCKETS; i++) {
@@ -74,21 +181,199 @@ private:
 				resp_status = trans.get_response_status();
 			}
 
-			if (do_check_read_data && trans.is_read()) {
+			if (check && len) {
 				if (i == 0) {
-					memcpy(ref_data, data, len);
+					memcpy(f->data[0].data(), data, len);
 				} else {
-					if (memcmp(ref_data, data, len)) {
-						hexdump("ref-data", ref_data, len);
-						hexdump("data", data, len);
-						SC_REPORT_ERROR(TLM_SPLITTER_ERROR,
-							"Read-data missmatch");
-					}
+					check_read_data(f->data[0].data(),
+							data, len, i);
 				}
 			}
 		}
 		trans.set_response_status(resp_status);
-		delete[] ref_data;
+
+		if (f) {
+			m_free.push_back(f);
+		}
+	}
+
+	void b_transport_parallel(tlm::tlm_generic_payload &trans,
+					sc_time &delay)
+	{
+		unsigned char *data = trans.get_data_ptr();
+		unsigned int len = trans.get_data_length();
+		tlm::tlm_response_status resp_status;
+		fanout *f = get_fanout();
+		sc_time end;
+		sc_time now;
+		unsigned int i;
+		unsigned int j;
+
+		// Waits below
+		assert(sc_core::sc_get_current_process_handle().proc_kind() !=
+			sc_core::SC_METHOD_PROC_);
+
+		f->pending = NR_INIT_SOCKETS - 1;
+
+		for (i = 1; i < NR_INIT_SOCKETS; i++) {
+			tlm::tlm_generic_payload& gp = f->gp[i];
+
+			gp.set_command(trans.get_command());
+			gp.set_address(trans.get_address());
+			gp.set_data_ptr(data);
+			gp.set_data_length(len);
+			gp.set_byte_enable_ptr(trans.get_byte_enable_ptr());
+			gp.set_byte_enable_length(trans.get_byte_enable_length());
+			gp.set_streaming_width(trans.get_streaming_width());
+			gp.set_response_status(trans.get_response_status());
+			gp.set_dmi_allowed(false);
+
+			// Share the extensions (the pointers, not clones)
+			for (j = 0; j < tlm::max_num_extensions(); j++) {
+				gp.set_extension(j, trans.get_extension(j));
+			}
+
+			if (trans.is_read() && len) {
+				// Disabled bytes keep the initiator's data
+				f->data[i].resize(len);
+				memcpy(f->data[i].data(), data, len);
+				gp.set_data_ptr(f->data[i].data());
+			}
+
+			f->delay[i] = delay;
+
+			sc_spawn(sc_bind(&tlm_splitter::fanout_thread,
+						this, f, i));
+		}
+
+		(*i_sk[0])->b_transport(trans, delay);
+		f->end[0] = sc_time_stamp() + delay;
+
+		//
+		// The spawned processes might have completed while port 0
+		// was waiting, so count rather than wait on each done event.
+		//
+		while (f->pending) {
+			wait(f->done);
+		}
+
+		resp_status = trans.get_response_status();
+		end = f->end[0];
+
+		for (i = 1; i < NR_INIT_SOCKETS; i++) {
+			tlm::tlm_generic_payload& gp = f->gp[i];
+
+			if (gp.get_response_status() != tlm::TLM_OK_RESPONSE) {
+				resp_status = gp.get_response_status();
+			}
+
+			if (f->end[i] > end) {
+				end = f->end[i];
+			}
+
+			if (do_check_read_data && trans.is_read() && len) {
+				check_read_data(data, gp.get_data_ptr(),
+						len, i);
+			}
+
+			//
+			// The extensions shared with trans belong to trans,
+			// the ones added by the port's target are freed.
+			//
+			for (j = 0; j < tlm::max_num_extensions(); j++) {
+				tlm::tlm_extension_base *ext =
+					gp.get_extension(j);
+
+				if (ext && ext != trans.get_extension(j)) {
+					ext->free();
+				}
+				gp.set_extension(j, NULL);
+			}
+		}
+		trans.set_response_status(resp_status);
+
+		//
+		// The ports may have waited (and returned their delays) at
+		// different times, the transaction completes with the last
+		// one.
+		//
+		now = sc_time_stamp();
+		delay = end > now ? end - now : SC_ZERO_TIME;
+
+		m_free.push_back(f);
+	}
+
+	void fanout_thread(fanout *f, unsigned int i)
+	{
+		(*i_sk[i])->b_transport(f->gp[i], f->delay[i]);
+		f->end[i] = sc_time_stamp() + f->delay[i];
+
+		if (--f->pending == 0) {
+			f->done.notify();
+		}
+	}
+
+	//
+	// Debug writes are replicated, debug reads are served by the first
+	// target.
+	//
+	virtual unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
+	{
+		unsigned int ret;
+		unsigned int i;
+
+		ret = (*i_sk[0])->transport_dbg(trans);
+		if (trans.is_write()) {
+			for (i = 1; i < NR_INIT_SOCKETS; i++) {
+				(*i_sk[i])->transport_dbg(trans);
+			}
+		}
+		return ret;
+	}
+
+	//
+	// Stores need to reach all targets and read data can only be
+	// compared through b_transport, so DMI is read only, into the first
+	// target's memory, over the range all targets grant DMI for.
+	//
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data)
+	{
+		unsigned int i;
+
+		if (do_check_read_data ||
+			!(*i_sk[0])->get_direct_mem_ptr(trans, dmi_data) ||
+			!dmi_data.is_read_allowed()) {
+			return false;
+		}
+
+		for (i = 1; i < NR_INIT_SOCKETS; i++) {
+			tlm::tlm_dmi dmi;
+
+			if (!(*i_sk[i])->get_direct_mem_ptr(trans, dmi)) {
+				return false;
+			}
+
+			if (dmi.get_start_address() > dmi_data.get_start_address()) {
+				uint64_t offset = dmi.get_start_address() -
+						dmi_data.get_start_address();
+
+				dmi_data.set_dmi_ptr(dmi_data.get_dmi_ptr() + offset);
+				dmi_data.set_start_address(dmi.get_start_address());
+			}
+			if (dmi.get_end_address() < dmi_data.get_end_address()) {
+				dmi_data.set_end_address(dmi.get_end_address());
+			}
+		}
+
+		dmi_data.allow_read();
+		return true;
+	}
+
+	virtual void invalidate_direct_mem_ptr(int id, sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		target_socket->invalidate_direct_mem_ptr(start, end);
 	}
 };
 #endif
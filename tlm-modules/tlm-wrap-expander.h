@@ -35,6 +35,7 @@
 #include "tlm_utils/simple_initiator_socket.h"
 #include "tlm_utils/simple_target_socket.h"
 #include "tlm-extensions/genattr.h"
+#include "tlm-modules/private/tlm-split.h"
 
 class tlm_wrap_expander : public sc_core::sc_module
 {
@@ -47,6 +48,17 @@ public:
 		m_generate_two_gps(generate_two_gps)
 	{
 		target_socket.register_b_transport(this, &tlm_wrap_expander::b_transport);
+		target_socket.register_transport_dbg(this,
+				&tlm_wrap_expander::transport_dbg);
+		target_socket.register_get_direct_mem_ptr(this,
+				&tlm_wrap_expander::get_direct_mem_ptr);
+		init_socket.register_invalidate_direct_mem_ptr(this,
+				&tlm_wrap_expander::invalidate_direct_mem_ptr);
+	}
+
+	tlm_split_stats& get_split_stats(void)
+	{
+		return m_split.stats;
 	}
 
 private:
@@ -64,12 +76,12 @@ private:
 
 	virtual void b_transport(tlm::tlm_generic_payload& gp, sc_time& delay)
 	{
+		m_split.stats.transactions++;
+
 		if (is_wrap(gp)) {
-			unsigned int be_len = gp.get_byte_enable_length();
 			unsigned char *data = gp.get_data_ptr();
 			uint64_t len = gp.get_data_length();
 			uint64_t addr = gp.get_address();
-			unsigned char *be = NULL;
 			uint64_t wrap_boundary;
 			unsigned int pos;
 
@@ -78,83 +90,59 @@ private:
 			// Start byte position in the wrap
 			pos = addr - wrap_boundary;
 
-			if (be_len) {
-				be = new uint8_t[be_len*2];
-				if (!be) {
-					gp.set_response_status(tlm::TLM_GENERIC_ERROR_RESPONSE);
-					return;
-				}
-				// Copy two consecutive copies so we can do a sliding window.
-				memcpy(be, gp.get_byte_enable_ptr(), be_len);
-				memcpy(be + be_len, be, be_len);
-			}
-
 			if (m_generate_two_gps && pos != 0) {
 				//
 				// Generate two gps (first one is from
 				// pos -> len and second one from the
 				// wrap_boundary -> pos)
 				//
-				tlm::tlm_generic_payload tmp_gp;
+				tlm_split_engine::piece *tmp_gp = m_split.get(gp);
 				uint64_t len1 = len - pos;
 
 				//
 				// Setup first gp
 				//
-				tmp_gp.deep_copy_from(gp);
-				tmp_gp.set_address(addr);
-				tmp_gp.set_data_ptr(data);
-				tmp_gp.set_data_length(len1);
+				tmp_gp->set_address(addr);
+				tmp_gp->set_data_ptr(data);
+				tmp_gp->set_data_length(len1);
+				m_split.set_byte_enables(tmp_gp, gp, 0, len1);
 
-				if (be_len) {
-					tmp_gp.set_byte_enable_ptr(be);
-				}
-
-				tmp_gp.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+				tmp_gp->set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
 
 				// First gp
-				init_socket->b_transport(tmp_gp, delay);
+				m_split.stats.pieces++;
+				init_socket->b_transport(*tmp_gp, delay);
 
-				if (tmp_gp.get_response_status() == tlm::TLM_OK_RESPONSE) {
+				if (tmp_gp->get_response_status() == tlm::TLM_OK_RESPONSE) {
 					//
 					// Setup second gp
 					//
 					uint64_t len2 = pos;
 
-					tmp_gp.set_address(wrap_boundary);
-					tmp_gp.set_data_ptr(data + len1);
-					tmp_gp.set_data_length(len2);
-
-					if (be_len) {
-						tmp_gp.set_byte_enable_ptr(be + (len1 % be_len));
-					}
+					tmp_gp->set_address(wrap_boundary);
+					tmp_gp->set_data_ptr(data + len1);
+					tmp_gp->set_data_length(len2);
+					m_split.set_byte_enables(tmp_gp, gp, len1, len2);
 
-					tmp_gp.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+					tmp_gp->set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
 
 					// Second gp
-					init_socket->b_transport(tmp_gp, delay);
-
-					//
-					// Since the response of the first gp
-					// was ok we can just propagate the
-					// second gps response
-					//
-					gp.set_response_status(tmp_gp.get_response_status());
-				}  else {
-					//
-					// Propagate the first gp's error response
-					//
-					gp.set_response_status(tmp_gp.get_response_status());
+					m_split.stats.pieces++;
+					init_socket->b_transport(*tmp_gp, delay);
 				}
+
+				//
+				// Propagate the first gp's error response or,
+				// since the response of the first gp was ok,
+				// the second gp's response
+				//
+				m_split.put(gp, tmp_gp);
 			} else {
 				// Always wrap_boundary here
 				gp.set_address(wrap_boundary);
 
 				init_socket->b_transport(gp, delay);
 			}
-
-			delete[] be;
-
 		} else {
 			//
 			// Just propagate the gp if it is not a wrapping burst.
@@ -163,6 +151,28 @@ private:
 		}
 	}
 
+	//
+	// Debug and DMI accesses are forwarded as they are, they
+	// don't carry the wrap attribute.
+	//
+	virtual unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
+	{
+		return init_socket->transport_dbg(trans);
+	}
+
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
+					tlm::tlm_dmi& dmi_data)
+	{
+		return init_socket->get_direct_mem_ptr(trans, dmi_data);
+	}
+
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+						sc_dt::uint64 end)
+	{
+		target_socket->invalidate_direct_mem_ptr(start, end);
+	}
+
 	bool m_generate_two_gps;
+	tlm_split_engine m_split;
 };
 #endif
@@ -0,0 +1,343 @@
+/*
+ * TLM transaction recorder.
+ *
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "systemc.h"
+#include "tlm.h"
+
+using namespace sc_core;
+using namespace sc_dt;
+using namespace std;
+
+#include "tlm-recorder.h"
+
+static const char trace_magic[8] = { 'T', 'L', 'M', 'T', 'R', 'C', 0, 0 };
+
+static void put_le(uint8_t *p, uint64_t v, unsigned int len)
+{
+	unsigned int i;
+
+	for (i = 0; i < len; i++) {
+		p[i] = v >> (i * 8);
+	}
+}
+
+trace_recorder::trace_recorder(const char *filename, bool record_data,
+			       size_t buf_size)
+	: record_data(record_data),
+	  buf_size(buf_size),
+	  last_ts(0),
+	  stop(false)
+{
+	uint8_t hdr[24];
+	double res_fs;
+
+	fp = fopen(filename, "wb");
+	if (!fp) {
+		perror(filename);
+		SC_REPORT_FATAL("trace_recorder", "Failed to open trace file");
+		return;
+	}
+
+	res_fs = sc_get_time_resolution().to_seconds() * 1e15;
+	memcpy(hdr, trace_magic, sizeof trace_magic);
+	put_le(hdr + 8, TRACE_RECORDER_VERSION, 4);
+	put_le(hdr + 12, 0, 4);
+	put_le(hdr + 16, (uint64_t) (res_fs + 0.5), 8);
+	fwrite(hdr, sizeof hdr, 1, fp);
+
+	// Leave room for the record that fills up the buffer.
+	buf.reserve(buf_size + 256);
+	pending.reserve(buf_size + 256);
+
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&cond, NULL);
+	pthread_create(&thread, NULL, writer_main, this);
+}
+
+trace_recorder::~trace_recorder(void)
+{
+	if (!fp) {
+		return;
+	}
+
+	flush();
+
+	pthread_mutex_lock(&mutex);
+	stop = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+	pthread_join(thread, NULL);
+
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+	fclose(fp);
+}
+
+void *trace_recorder::writer_main(void *opaque)
+{
+	trace_recorder *t = (trace_recorder *) opaque;
+
+	pthread_mutex_lock(&t->mutex);
+	while (true) {
+		while (t->pending.empty() && !t->stop) {
+			pthread_cond_wait(&t->cond, &t->mutex);
+		}
+		if (t->pending.empty()) {
+			break;
+		}
+
+		// The simulation keeps filling buf while we write.
+		pthread_mutex_unlock(&t->mutex);
+		fwrite(&t->pending[0], t->pending.size(), 1, t->fp);
+		pthread_mutex_lock(&t->mutex);
+
+		t->pending.clear();
+		pthread_cond_broadcast(&t->cond);
+	}
+	pthread_mutex_unlock(&t->mutex);
+	fflush(t->fp);
+	return NULL;
+}
+
+void trace_recorder::flush(void)
+{
+	if (!fp || buf.empty()) {
+		return;
+	}
+
+	pthread_mutex_lock(&mutex);
+	// Only blocks if the writer falls behind.
+	while (!pending.empty()) {
+		pthread_cond_wait(&cond, &mutex);
+	}
+	buf.swap(pending);
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void trace_recorder::commit(void)
+{
+	if (buf.size() >= buf_size) {
+		flush();
+	}
+}
+
+void trace_recorder::put_varint(uint64_t v)
+{
+	while (v >= 0x80) {
+		buf.push_back((v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	buf.push_back(v);
+}
+
+void trace_recorder::put_time(void)
+{
+	uint64_t ts = sc_time_stamp().value();
+
+	put_varint(ts - last_ts);
+	last_ts = ts;
+}
+
+void trace_recorder::put_trans(tlm::tlm_generic_payload &trans)
+{
+	put_u8(trans.get_command());
+	put_varint(trans.get_address());
+	put_varint(trans.get_data_length());
+	put_u8(trans.get_response_status() + 8);
+}
+
+uint32_t trace_recorder::intern(const char *name)
+{
+	std::map<std::string, uint32_t>::iterator it = names.find(name);
+	uint32_t id;
+	size_t len;
+
+	if (it != names.end()) {
+		return it->second;
+	}
+
+	id = names.size();
+	names[name] = id;
+
+	len = strlen(name);
+	put_u8(TRACE_REC_NAME);
+	put_varint(id);
+	put_varint(len);
+	buf.insert(buf.end(), name, name + len);
+	commit();
+	return id;
+}
+
+void trace_recorder::record_txn(uint32_t name, unsigned int kind,
+				tlm::tlm_generic_payload &trans,
+				const sc_time &delay)
+{
+	put_u8(TRACE_REC_TXN);
+	put_time();
+	put_varint(name);
+	put_u8(kind);
+	put_trans(trans);
+	put_varint(delay.value());
+
+	if (record_data && trans.get_data_ptr()) {
+		unsigned char *data = trans.get_data_ptr();
+		unsigned int len = trans.get_data_length();
+
+		put_varint(len);
+		buf.insert(buf.end(), data, data + len);
+	} else {
+		put_varint(0);
+	}
+	commit();
+}
+
+void trace_recorder::record_phase(uint32_t name, uint64_t tag, bool bw,
+				  tlm::tlm_generic_payload &trans,
+				  const tlm::tlm_phase &phase,
+				  unsigned int sync,
+				  const sc_time &delay)
+{
+	put_u8(TRACE_REC_PHASE);
+	put_time();
+	put_varint(name);
+	put_varint(tag);
+	put_u8(bw);
+	put_u8((unsigned int) phase);
+	put_u8(sync);
+	put_trans(trans);
+	put_varint(delay.value());
+	commit();
+}
+
+tlm_recorder::tlm_recorder(sc_module_name name, trace_recorder *rec)
+	: sc_module(name),
+	  target_socket("target_socket"),
+	  init_socket("init_socket"),
+	  rec(rec),
+	  next_tag(0)
+{
+	name_id = rec->intern(this->name());
+
+	target_socket.register_b_transport(this, &tlm_recorder::b_transport);
+	target_socket.register_nb_transport_fw(this,
+				&tlm_recorder::nb_transport_fw);
+	target_socket.register_transport_dbg(this,
+				&tlm_recorder::transport_dbg);
+	target_socket.register_get_direct_mem_ptr(this,
+				&tlm_recorder::get_direct_mem_ptr);
+	init_socket.register_nb_transport_bw(this,
+				&tlm_recorder::nb_transport_bw);
+	init_socket.register_invalidate_direct_mem_ptr(this,
+				&tlm_recorder::invalidate_direct_mem_ptr);
+}
+
+uint64_t tlm_recorder::tag(tlm::tlm_generic_payload &trans)
+{
+	std::map<tlm::tlm_generic_payload *, uint64_t>::iterator it;
+
+	it = tags.find(&trans);
+	if (it == tags.end()) {
+		it = tags.insert(std::make_pair(&trans, next_tag++)).first;
+	}
+	return it->second;
+}
+
+void tlm_recorder::untag(tlm::tlm_generic_payload &trans,
+			 const tlm::tlm_phase &phase, tlm::tlm_sync_enum r)
+{
+	if (r == tlm::TLM_COMPLETED || phase == tlm::END_RESP) {
+		tags.erase(&trans);
+	}
+}
+
+void tlm_recorder::b_transport(tlm::tlm_generic_payload &trans,
+			       sc_time &delay)
+{
+	init_socket->b_transport(trans, delay);
+	rec->record_txn(name_id, TRACE_KIND_B, trans, delay);
+}
+
+tlm::tlm_sync_enum tlm_recorder::nb_transport_fw(
+				tlm::tlm_generic_payload &trans,
+				tlm::tlm_phase &phase,
+				sc_time &delay)
+{
+	uint64_t t = tag(trans);
+	tlm::tlm_sync_enum r;
+
+	rec->record_phase(name_id, t, false, trans, phase, TRACE_SYNC_CALL,
+			  delay);
+	r = init_socket->nb_transport_fw(trans, phase, delay);
+	if (r != tlm::TLM_ACCEPTED) {
+		rec->record_phase(name_id, t, false, trans, phase, r, delay);
+	}
+	untag(trans, phase, r);
+	return r;
+}
+
+tlm::tlm_sync_enum tlm_recorder::nb_transport_bw(
+				tlm::tlm_generic_payload &trans,
+				tlm::tlm_phase &phase,
+				sc_time &delay)
+{
+	uint64_t t = tag(trans);
+	tlm::tlm_sync_enum r;
+
+	rec->record_phase(name_id, t, true, trans, phase, TRACE_SYNC_CALL,
+			  delay);
+	r = target_socket->nb_transport_bw(trans, phase, delay);
+	if (r != tlm::TLM_ACCEPTED) {
+		rec->record_phase(name_id, t, true, trans, phase, r, delay);
+	}
+	untag(trans, phase, r);
+	return r;
+}
+
+unsigned int tlm_recorder::transport_dbg(tlm::tlm_generic_payload &trans)
+{
+	unsigned int r;
+
+	r = init_socket->transport_dbg(trans);
+	rec->record_txn(name_id, TRACE_KIND_DBG, trans, SC_ZERO_TIME);
+	return r;
+}
+
+bool tlm_recorder::get_direct_mem_ptr(tlm::tlm_generic_payload &trans,
+				      tlm::tlm_dmi &dmi_data)
+{
+	// Accesses through DMI pointers bypass us and won't be recorded.
+	return init_socket->get_direct_mem_ptr(trans, dmi_data);
+}
+
+void tlm_recorder::invalidate_direct_mem_ptr(sc_dt::uint64 start,
+					     sc_dt::uint64 end)
+{
+	target_socket->invalidate_direct_mem_ptr(start, end);
+}
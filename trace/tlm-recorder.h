@@ -0,0 +1,173 @@
+/*
+ * TLM transaction recorder.
+ *
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TLM_RECORDER_H__
+#define TLM_RECORDER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tlm_utils/simple_initiator_socket.h"
+#include "tlm_utils/simple_target_socket.h"
+
+/*
+ * Binary transaction trace file.
+ *
+ * The file starts with a header:
+ *   char     magic[8]    "TLMTRC\0\0"
+ *   uint32_t version     TRACE_RECORDER_VERSION, little-endian
+ *   uint32_t reserved
+ *   uint64_t resolution  SystemC time resolution in fs, little-endian
+ *
+ * followed by records. Every record starts with a type byte. All
+ * other integers are unsigned LEB128 varints. Timestamps are deltas
+ * in units of the time resolution from the previous record.
+ *
+ *   TRACE_REC_NAME   id, len, name[len]
+ *       Binds a name to an id. Emitted before the first record that
+ *       uses the id.
+ *
+ *   TRACE_REC_TXN    dt, name, kind, cmd, addr, len, status, delay,
+ *                    data_len, data[data_len]
+ *       A completed b_transport or transport_dbg call. status is
+ *       the tlm_response_status plus 8, delay the annotated delay.
+ *       data_len is 0 unless data recording is enabled.
+ *
+ *   TRACE_REC_PHASE  dt, name, tag, dir, phase, sync, cmd, addr, len,
+ *                    status, delay
+ *       A non-blocking transport call. tag identifies the transaction
+ *       across phases, dir is 0 for forward and 1 for backward calls.
+ *       Every call is recorded before it's forwarded, with the phase
+ *       and delay passed by the caller and sync TRACE_SYNC_CALL. If
+ *       the callee returns TLM_UPDATED or TLM_COMPLETED, the returned
+ *       phase and delay are recorded as a second record with sync set
+ *       to the returned tlm_sync_enum.
+ */
+#define TRACE_RECORDER_VERSION 1
+
+enum {
+	TRACE_REC_NAME  = 1,
+	TRACE_REC_TXN   = 2,
+	TRACE_REC_PHASE = 3,
+};
+
+enum {
+	TRACE_KIND_B   = 0,
+	TRACE_KIND_DBG = 1,
+};
+
+// sync of the record made before a call is forwarded, follows the
+// tlm_sync_enum values.
+#define TRACE_SYNC_CALL 3
+
+// Writes a trace file. Records are encoded into a buffer that a
+// writer thread flushes to the file while the simulation goes on.
+class trace_recorder
+{
+public:
+	trace_recorder(const char *filename, bool record_data = false,
+		       size_t buf_size = 1024 * 1024);
+	~trace_recorder(void);
+
+	// Returns the id for name, allocating one on first use.
+	uint32_t intern(const char *name);
+
+	void record_txn(uint32_t name, unsigned int kind,
+			tlm::tlm_generic_payload &trans,
+			const sc_core::sc_time &delay);
+	void record_phase(uint32_t name, uint64_t tag, bool bw,
+			  tlm::tlm_generic_payload &trans,
+			  const tlm::tlm_phase &phase,
+			  unsigned int sync,
+			  const sc_core::sc_time &delay);
+
+	// Hands everything recorded so far to the writer thread.
+	void flush(void);
+
+private:
+	FILE *fp;
+	bool record_data;
+	size_t buf_size;
+	std::vector<uint8_t> buf;
+	std::map<std::string, uint32_t> names;
+	uint64_t last_ts;
+
+	// Writer thread. pending is written out while buf is filled.
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	std::vector<uint8_t> pending;
+	bool stop;
+
+	void put_u8(uint8_t v) { buf.push_back(v); }
+	void put_varint(uint64_t v);
+	void put_time(void);
+	void put_trans(tlm::tlm_generic_payload &trans);
+	void commit(void);
+
+	static void *writer_main(void *opaque);
+};
+
+// Records all transactions passing from target_socket to init_socket.
+class tlm_recorder : public sc_core::sc_module
+{
+public:
+	tlm_utils::simple_target_socket<tlm_recorder> target_socket;
+	tlm_utils::simple_initiator_socket<tlm_recorder> init_socket;
+
+	tlm_recorder(sc_core::sc_module_name name, trace_recorder *rec);
+
+private:
+	trace_recorder *rec;
+	uint32_t name_id;
+	// nb transactions in flight, by payload.
+	std::map<tlm::tlm_generic_payload *, uint64_t> tags;
+	uint64_t next_tag;
+
+	uint64_t tag(tlm::tlm_generic_payload &trans);
+	void untag(tlm::tlm_generic_payload &trans,
+		   const tlm::tlm_phase &phase, tlm::tlm_sync_enum r);
+
+	virtual void b_transport(tlm::tlm_generic_payload &trans,
+				 sc_core::sc_time &delay);
+	virtual tlm::tlm_sync_enum nb_transport_fw(
+				tlm::tlm_generic_payload &trans,
+				tlm::tlm_phase &phase,
+				sc_core::sc_time &delay);
+	virtual tlm::tlm_sync_enum nb_transport_bw(
+				tlm::tlm_generic_payload &trans,
+				tlm::tlm_phase &phase,
+				sc_core::sc_time &delay);
+	virtual unsigned int transport_dbg(tlm::tlm_generic_payload &trans);
+	virtual bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans,
+					tlm::tlm_dmi &dmi_data);
+	virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start,
+					       sc_dt::uint64 end);
+};
+
+#endif
@@ -27,6 +27,9 @@
 #include <stdio.h>
 #include <signal.h>
 #include <unistd.h>
+#include <fnmatch.h>
+#include <map>
+#include <typeindex>
 
 #include "systemc.h"
 
@@ -36,52 +39,109 @@ using namespace std;
 
 #include "trace.h"
 
-template < typename T > void sc_trace_template(sc_trace_file *tf, sc_object *obj)
+static std::map<std::type_index, trace_fn> &trace_types(void)
 {
-	T* object ;
-	if ((object  = dynamic_cast < T* >(obj)))
-		sc_trace(tf, *object , object->name());
+	static std::map<std::type_index, trace_fn> types;
+	return types;
 }
 
-#define TRACE_TYPE(T, W)						\
-do {									\
-	sc_trace_template < sc_core::sc_signal < T<W> > > (tf,obj);	\
-	sc_trace_template < sc_core::sc_in < T<W> > > (tf,obj);		\
-	sc_trace_template < sc_core::sc_out < T<W> > > (tf,obj);	\
-} while (0)
+// Every type we have come across, including the ones that can't be
+// traced (NULL) and types derived from registered ones.
+static std::map<std::type_index, trace_fn> &trace_cache(void)
+{
+	static std::map<std::type_index, trace_fn> cache;
+	return cache;
+}
 
-void trace(sc_trace_file* tf, const sc_module& mod, const char *txt)
+void trace_register(const std::type_info &ti, trace_fn fn)
 {
-	std::vector < sc_object* > ch = mod.get_child_objects();
-
-	for ( unsigned i = 0; i < ch.size(); i++ ) {
-		sc_module* m;
-		sc_object* obj = ch[i];
-
-		/* Add more types as needed.  */
-		sc_trace_template < sc_core::sc_signal < bool > > (tf,obj);
-		sc_trace_template < sc_core::sc_in < bool > > (tf,obj);
-		sc_trace_template < sc_core::sc_out < bool > > (tf,obj);
-
-		TRACE_TYPE(sc_bv, 2);
-		TRACE_TYPE(sc_bv, 3);
-		TRACE_TYPE(sc_bv, 4);
-		TRACE_TYPE(sc_bv, 5);
-		TRACE_TYPE(sc_bv, 6);
-		TRACE_TYPE(sc_bv, 7);
-		TRACE_TYPE(sc_bv, 8);
-		TRACE_TYPE(sc_bv, 9);
-		TRACE_TYPE(sc_bv, 10);
-		TRACE_TYPE(sc_bv, 16);
-		TRACE_TYPE(sc_bv, 32);
-		TRACE_TYPE(sc_bv, 64);
-		TRACE_TYPE(sc_bv, 128);
-		TRACE_TYPE(sc_bv, 256);
-		TRACE_TYPE(sc_bv, 384);
-		TRACE_TYPE(sc_bv, 512);
-		TRACE_TYPE(sc_bv, 1024);
-
-		if ((m = dynamic_cast < sc_module* > (obj)))
-			trace(tf, *m, m->name());
+	trace_types()[std::type_index(ti)] = fn;
+	trace_cache().clear();
+}
+
+static void trace_register_defaults(void)
+{
+	static bool done = false;
+
+	if (done)
+		return;
+	done = true;
+
+	/* Add more types as needed, or register them from the outside.  */
+	trace_register_type<bool>();
+	trace_register_widths<sc_bv, 1, 10>();
+	trace_register_type<sc_bv<16> >();
+	trace_register_type<sc_bv<32> >();
+	trace_register_type<sc_bv<64> >();
+	trace_register_type<sc_bv<128> >();
+	trace_register_type<sc_bv<256> >();
+	trace_register_type<sc_bv<384> >();
+	trace_register_type<sc_bv<512> >();
+	trace_register_type<sc_bv<1024> >();
+	trace_register_type<sc_uint<8> >();
+	trace_register_type<sc_uint<16> >();
+	trace_register_type<sc_uint<32> >();
+	trace_register_type<sc_uint<64> >();
+}
+
+static trace_fn trace_lookup(sc_object *obj)
+{
+	std::map<std::type_index, trace_fn> &cache = trace_cache();
+	std::map<std::type_index, trace_fn> &types = trace_types();
+	std::map<std::type_index, trace_fn>::iterator it;
+	std::type_index ti(typeid(*obj));
+	trace_fn fn = NULL;
+
+	it = cache.find(ti);
+	if (it != cache.end())
+		return it->second;
+
+	it = types.find(ti);
+	if (it != types.end()) {
+		fn = it->second;
+	} else if (!dynamic_cast<sc_module *>(obj)) {
+		/* First object of an unknown type, it may derive
+		 * from a registered one (e.g sc_buffer).  */
+		for (it = types.begin(); it != types.end(); it++) {
+			if (it->second(NULL, obj) == false)
+				continue;
+			fn = it->second;
+			break;
+		}
 	}
+	cache[ti] = fn;
+	return fn;
+}
+
+void trace(sc_trace_file* tf, const sc_module& mod, const char *txt,
+	   const char *glob)
+{
+	std::vector < const sc_object* > stack;
+
+	trace_register_defaults();
+
+	stack.push_back(&mod);
+	while (!stack.empty()) {
+		const std::vector < sc_object* > &ch =
+			stack.back()->get_child_objects();
+
+		stack.pop_back();
+		for ( unsigned i = 0; i < ch.size(); i++ ) {
+			sc_object* obj = ch[i];
+			trace_fn fn;
+
+			fn = trace_lookup(obj);
+			if (fn) {
+				if (!glob || !fnmatch(glob, obj->name(), 0))
+					fn(tf, obj);
+			} else if (dynamic_cast < sc_module* > (obj)) {
+				stack.push_back(obj);
+			}
+		}
+	}
+}
+
+void trace(sc_trace_file* tf, const sc_module& mod, const char *txt)
+{
+	trace(tf, mod, txt, NULL);
 }
@@ -26,6 +26,77 @@
 #ifndef TRACE_H__
 #define TRACE_H__
 
+#include <typeinfo>
+
+/*
+ * Signal tracing.
+ *
+ * trace() walks the module hierarchy once and adds every signal and
+ * port of a registered type to tf. Types are found by their typeid,
+ * so the cost per object doesn't grow with the number of registered
+ * types. bool, the common sc_bv widths and sc_uint<8/16/32/64> are
+ * registered by default. Other types are registered with
+ * trace_register_type<T>() or trace_register_widths<sc_bv, 1, 64>()
+ * before calling trace().
+ *
+ * With glob, only objects whose full hierarchical name matches
+ * the fnmatch() pattern are traced, e.g "top.cpu.*.awaddr".
+ */
+// Returns true if obj was traced. With tf NULL, only checks if obj can be.
+typedef bool (*trace_fn)(sc_trace_file *tf, sc_object *obj);
+
+void trace_register(const std::type_info &ti, trace_fn fn);
+
+template<typename T>
+bool trace_object(sc_trace_file *tf, sc_object *obj)
+{
+	T *object = dynamic_cast<T *>(obj);
+
+	if (!object)
+		return false;
+	if (tf)
+		sc_trace(tf, *object, object->name());
+	return true;
+}
+
+// Registers sc_signal<T>, sc_in<T>, sc_out<T> and sc_inout<T>.
+template<typename T>
+void trace_register_type(void)
+{
+	trace_register(typeid(sc_core::sc_signal<T>),
+		       trace_object<sc_core::sc_signal<T> >);
+	trace_register(typeid(sc_core::sc_in<T>),
+		       trace_object<sc_core::sc_in<T> >);
+	trace_register(typeid(sc_core::sc_out<T>),
+		       trace_object<sc_core::sc_out<T> >);
+	trace_register(typeid(sc_core::sc_inout<T>),
+		       trace_object<sc_core::sc_inout<T> >);
+}
+
+// Registers T<W> for all W in [FIRST, LAST].
+template<template<int> class T, int FIRST, int LAST>
+struct trace_widths {
+	static void reg(void) {
+		trace_register_type<T<FIRST> >();
+		trace_widths<T, FIRST + 1, LAST>::reg();
+	}
+};
+
+template<template<int> class T, int LAST>
+struct trace_widths<T, LAST, LAST> {
+	static void reg(void) {
+		trace_register_type<T<LAST> >();
+	}
+};
+
+template<template<int> class T, int FIRST, int LAST>
+void trace_register_widths(void)
+{
+	trace_widths<T, FIRST, LAST>::reg();
+}
+
 void trace(sc_trace_file* tf, const sc_module& mod, const char *txt);
+void trace(sc_trace_file* tf, const sc_module& mod, const char *txt,
+	   const char *glob);
 
 #endif
@@ -24,6 +24,7 @@
 #define RANDOMTRAFFIC_H_
 
 #include <stdlib.h>
+#include <string.h>
 #include "itraffic-desc.h"
 
 #ifndef MIN
@@ -34,6 +35,76 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif
 
+//
+// xoshiro256** seeded through splitmix64. Produces 64 random bits per
+// call, reproducible for a given seed and stream.
+//
+class TGRandom
+{
+public:
+	TGRandom(uint64_t seed = 0, uint64_t stream = 0)
+	{
+		setSeed(seed, stream);
+	}
+
+	static uint64_t splitmix64(uint64_t& x)
+	{
+		uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	void setSeed(uint64_t seed, uint64_t stream = 0)
+	{
+		uint64_t x = seed ^ (stream * 0xd1342543de82ef95ULL);
+		int i;
+
+		for (i = 0; i < 4; i++) {
+			s[i] = splitmix64(x);
+		}
+	}
+
+	uint64_t next()
+	{
+		uint64_t result = rotl(s[1] * 5, 7) * 9;
+		uint64_t t = s[1] << 17;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	}
+
+	void fill(uint8_t *buf, size_t len)
+	{
+		size_t i;
+
+		for (i = 0; i + 8 <= len; i += 8) {
+			uint64_t v = next();
+
+			memcpy(buf + i, &v, 8);
+		}
+		if (i < len) {
+			uint64_t v = next();
+
+			memcpy(buf + i, &v, len - i);
+		}
+	}
+
+private:
+	uint64_t s[4];
+
+	static uint64_t rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+};
+
 class RandomTraffic : public ITrafficDesc
 {
 public:
@@ -60,12 +131,18 @@ public:
 		m_last_write(false),
 		m_initMemory(initMemory),
 		m_seed(seed),
+		m_stream(0),
+		m_rng(seed),
+		m_patterns(false),
+		m_expect(NULL),
 		hasAddrLen(false)
 	{}
 
 	~RandomTraffic()
 	{
 		delete[] m_data;
+		delete[] m_byte_enables;
+		delete[] m_expect;
 	}
 
 	virtual tlm::tlm_command getCmd()
@@ -96,23 +173,20 @@ public:
 	}
 
 	virtual unsigned char *getData() {
-		unsigned int i;
-		uint32_t v = 0;
-
 		if (!hasAddrLen)
 			genAddrLen();
 
+		if (m_patterns) {
+			fillPattern(m_data);
+			return m_data;
+		}
+
 		if (m_initMemory) {
 			memset(m_data, 0, len);
 			return m_data;
 		}
 
-		// FIXME: Do something faster?
-		for (i = 0; i < len; i++) {
-			v = v ? v : rand_r(&m_seed);
-			m_data[i] = v;
-			v >>= 8;
-		}
+		m_rng.fill(m_data, len);
 		return m_data;
 	}
 	virtual uint32_t getDataLength()
@@ -124,14 +198,16 @@ public:
 
 	virtual unsigned char *getByteEnable() {
 		unsigned int i;
-		uint32_t v = 0;
+		uint64_t v = 0;
 
 		if (!hasAddrLen)
 			genAddrLen();
 
-		// FIXME: Do something faster?
+		// One random bit per byte-enable.
 		for (i = 0; i < be_len; i++) {
-			v = v ? v : rand_r(&m_seed);
+			if ((i & 63) == 0) {
+				v = m_rng.next();
+			}
 			m_byte_enables[i] = v & 1 ? TLM_BYTE_ENABLED : 0;
 			v >>= 1;
 		}
@@ -151,7 +227,23 @@ public:
 		return sw_len;
 	};
 
-	virtual unsigned char *getExpect() { return nullptr; }
+	//
+	// With patterns enabled, reads are checked against the pattern.
+	// Reads with byte-enables leave disabled bytes untouched, those
+	// are not checked.
+	//
+	virtual unsigned char *getExpect() {
+		if (!m_patterns || m_last_write || be_len) {
+			return nullptr;
+		}
+
+		if (!m_expect) {
+			m_expect = new uint8_t[MAX(m_maxDataLen,
+						m_maxAddress - m_minAddress)];
+		}
+		fillPattern(m_expect);
+		return m_expect;
+	}
 
 	virtual void setExtensions(tlm::tlm_generic_payload *gp) {}
 
@@ -167,9 +259,38 @@ public:
 		m_initMemory = false;
 	}
 
-	void setSeed(unsigned int seed) { m_seed = seed; }
+	//
+	// Data and byte-enables come from their own generator, the
+	// address, length and command sequence for a seed differs from
+	// versions that drew everything from rand_r.
+	//
+	void setSeed(unsigned int seed)
+	{
+		m_seed = seed;
+		m_rng.setSeed(seed, m_stream);
+	}
 	unsigned int getSeed() { return m_seed; }
 
+	//
+	// Selects an independent data stream for the same seed, e.g one
+	// per generator thread.
+	//
+	void setStream(uint64_t stream)
+	{
+		m_stream = stream;
+		m_rng.setSeed(m_seed, stream);
+	}
+
+	//
+	// Write a fixed pattern that only depends on the seed and the
+	// address instead of random data. Since memory then always holds
+	// the pattern, reads can be verified without a shadow copy of
+	// the memory. The memory must be initialized first, e.g with
+	// setInitMemory(true).
+	//
+	void setPatterns(bool v) { m_patterns = v; }
+	bool getPatterns(void) { return m_patterns; }
+
 	void setMinStreamingWidthLen(uint32_t len) { m_minStreamingWidthLen = len; }
 	uint32_t getMinStreamingWidthLen(void) { return m_minStreamingWidthLen; }
 
@@ -195,6 +316,10 @@ private:
 	bool m_initMemory;
 
 	unsigned int m_seed;
+	uint64_t m_stream;
+	TGRandom m_rng;
+	bool m_patterns;
+	uint8_t *m_expect;
 
 	bool hasAddrLen;
 	uint64_t address;
@@ -202,6 +327,37 @@ private:
 	uint32_t be_len;
 	uint32_t sw_len;
 
+	// Pattern byte for address addr.
+	uint8_t pattern(uint64_t addr, uint64_t& word, uint64_t& v)
+	{
+		if ((addr >> 3) != word) {
+			uint64_t x = ((uint64_t) m_seed << 32) ^ (addr >> 3);
+
+			word = addr >> 3;
+			v = TGRandom::splitmix64(x);
+		}
+		return v >> ((addr & 7) * 8);
+	}
+
+	// Fill buf with the pattern for the current transfer, taking
+	// the streaming width into account.
+	void fillPattern(uint8_t *buf)
+	{
+		uint64_t word = UINT64_MAX;
+		uint64_t v = 0;
+		uint32_t i;
+
+		if (sw_len >= len) {
+			for (i = 0; i < len; i++) {
+				buf[i] = pattern(address + i, word, v);
+			}
+		} else {
+			for (i = 0; i < len; i++) {
+				buf[i] = pattern(address + i % sw_len, word, v);
+			}
+		}
+	}
+
 	// Coordinated Address and Len generation.
 	// We need to make sure that address + len does not exceed m_maxAddress.
 	void genAddrLen(void) {
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2026 Xilinx Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef TG_STATS_H_
+#define TG_STATS_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//
+// Histogram with logarithmic buckets, each split into 2^SUB_BITS linear
+// sub-buckets (HDR histogram style). Values are recorded with a relative
+// error below 2^-SUB_BITS over the whole uint64_t range, in constant time
+// and with a fixed amount of memory.
+//
+class TGHistogram
+{
+public:
+	enum { SUB_BITS = 5,
+		SUB_COUNT = 1 << SUB_BITS,
+		NR_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT };
+
+	TGHistogram() :
+		m_counts(NR_BUCKETS, 0)
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_counts.begin(), m_counts.end(), 0);
+		m_count = 0;
+		m_sum = 0;
+		m_min = UINT64_MAX;
+		m_max = 0;
+	}
+
+	void record(uint64_t v, uint64_t n = 1)
+	{
+		m_counts[index(v)] += n;
+		m_count += n;
+		m_sum += (double) v * n;
+		if (v < m_min) {
+			m_min = v;
+		}
+		if (v > m_max) {
+			m_max = v;
+		}
+	}
+
+	uint64_t count() { return m_count; }
+	uint64_t min() { return m_count ? m_min : 0; }
+	uint64_t max() { return m_max; }
+	double mean() { return m_count ? m_sum / m_count : 0; }
+
+	// Value at percentile p (0 - 100). Returns the upper bound of the
+	// matching bucket, capped by the largest recorded value.
+	uint64_t percentile(double p)
+	{
+		uint64_t target = (uint64_t) (p / 100 * m_count + 0.5);
+		uint64_t seen = 0;
+		unsigned int i;
+
+		if (m_count == 0) {
+			return 0;
+		}
+		if (target == 0) {
+			target = 1;
+		}
+
+		for (i = 0; i < NR_BUCKETS; i++) {
+			seen += m_counts[i];
+			if (seen >= target) {
+				uint64_t v = upper(i);
+
+				return v < m_max ? v : m_max;
+			}
+		}
+		return m_max;
+	}
+
+private:
+	std::vector<uint64_t> m_counts;
+	uint64_t m_count;
+	double m_sum;
+	uint64_t m_min;
+	uint64_t m_max;
+
+	static unsigned int index(uint64_t v)
+	{
+		unsigned int msb;
+
+		if (v < SUB_COUNT) {
+			return v;
+		}
+
+		// Bucket by the position of the MSB, sub-bucket by the
+		// SUB_BITS bits below it.
+		msb = 63 - __builtin_clzll(v);
+		return (msb - SUB_BITS + 1) * SUB_COUNT +
+			((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+	}
+
+	static uint64_t upper(unsigned int i)
+	{
+		unsigned int b = i / SUB_COUNT;
+		unsigned int sub = i % SUB_COUNT;
+		unsigned int shift;
+
+		if (b == 0) {
+			return sub;
+		}
+
+		shift = b - 1;
+		return (((uint64_t) (SUB_COUNT + sub) << shift) |
+			((1ULL << shift) - 1));
+	}
+};
+
+//
+// Transfer statistics for one thread or address range.
+//
+struct TGStatsEntry
+{
+	std::string name;
+
+	// Address range, only used for address-range entries.
+	uint64_t start;
+	uint64_t end;
+
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t bytesRead;
+	uint64_t bytesWritten;
+	uint64_t errors;
+
+	// Time of the first issue and last completion.
+	sc_time first;
+	sc_time last;
+
+	// Latency from issue to completion, in time resolution units.
+	TGHistogram latency;
+
+	// Outstanding transactions, weighted by how long (in time
+	// resolution units) each depth was held.
+	TGHistogram depth;
+	unsigned int curDepth;
+	unsigned int maxDepth;
+	sc_time depthChanged;
+	bool started;
+
+	TGStatsEntry(std::string name, uint64_t start = 0,
+			uint64_t end = UINT64_MAX) :
+		name(name),
+		start(start),
+		end(end),
+		curDepth(0)
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		reads = writes = 0;
+		bytesRead = bytesWritten = 0;
+		errors = 0;
+		first = last = sc_time_stamp();
+		started = false;
+		latency.reset();
+		depth.reset();
+		// Transactions in flight are still outstanding.
+		maxDepth = curDepth;
+		depthChanged = sc_time_stamp();
+	}
+
+	void setDepth(unsigned int d)
+	{
+		sc_time now = sc_time_stamp();
+		uint64_t dt = (now - depthChanged).value();
+
+		if (dt) {
+			depth.record(curDepth, dt);
+		}
+		depthChanged = now;
+		curDepth = d;
+		if (d > maxDepth) {
+			maxDepth = d;
+		}
+	}
+
+	void issue(const sc_time& now)
+	{
+		if (!started) {
+			first = now;
+			started = true;
+		}
+		setDepth(curDepth + 1);
+	}
+
+	void complete(tlm::tlm_generic_payload& trans,
+			const sc_time& issued, const sc_time& done)
+	{
+		uint32_t len = trans.get_data_length();
+
+		if (trans.is_read()) {
+			reads++;
+			bytesRead += len;
+		} else if (trans.is_write()) {
+			writes++;
+			bytesWritten += len;
+		}
+		if (trans.is_response_error()) {
+			errors++;
+		}
+
+		latency.record(done > issued ?
+				(done - issued).value() : 0);
+		last = done;
+		// Don't underflow on transactions issued before a reset.
+		setDepth(curDepth ? curDepth - 1 : 0);
+	}
+
+	// Achieved bandwidth in bytes per ns.
+	double bandwidth()
+	{
+		double ns = (last - first).to_seconds() * 1e9;
+
+		return ns > 0 ? (bytesRead + bytesWritten) / ns : 0;
+	}
+};
+
+//
+// Statistics for a TLMTrafficGenerator, per thread and per address
+// range. Recording a transaction costs a few additions and a histogram
+// update per matching entry.
+//
+class TGStats
+{
+public:
+	TGStats() {}
+
+	// Add an address range [start, end] to collect statistics for.
+	void addRange(std::string name, uint64_t start, uint64_t end)
+	{
+		m_ranges.push_back(TGStatsEntry(name, start, end));
+	}
+
+	void issue(int threadID, tlm::tlm_generic_payload& trans,
+			const sc_time& now)
+	{
+		uint64_t addr = trans.get_address();
+
+		thread(threadID).issue(now);
+		for (auto& r : m_ranges) {
+			if (addr >= r.start && addr <= r.end) {
+				r.issue(now);
+			}
+		}
+	}
+
+	void complete(int threadID, tlm::tlm_generic_payload& trans,
+			const sc_time& issued, const sc_time& done)
+	{
+		uint64_t addr = trans.get_address();
+
+		thread(threadID).complete(trans, issued, done);
+		for (auto& r : m_ranges) {
+			if (addr >= r.start && addr <= r.end) {
+				r.complete(trans, issued, done);
+			}
+		}
+	}
+
+	void reset()
+	{
+		for (auto& t : m_threads) {
+			t.reset();
+		}
+		for (auto& r : m_ranges) {
+			r.reset();
+		}
+	}
+
+	void dumpCSV(std::ostream& out)
+	{
+		out << "name,start,end,reads,writes,bytes_read,bytes_written,"
+			"errors,bandwidth_bytes_per_ns,lat_min_ns,lat_mean_ns,"
+			"lat_p50_ns,lat_p99_ns,lat_max_ns,depth_mean,depth_max"
+			<< std::endl;
+		for (auto& t : m_threads) {
+			dumpCSV(out, t);
+		}
+		for (auto& r : m_ranges) {
+			dumpCSV(out, r);
+		}
+	}
+
+	void dumpJSON(std::ostream& out)
+	{
+		bool firstEntry = true;
+
+		out << "[" << std::endl;
+		for (auto& t : m_threads) {
+			dumpJSON(out, t, firstEntry);
+			firstEntry = false;
+		}
+		for (auto& r : m_ranges) {
+			dumpJSON(out, r, firstEntry);
+			firstEntry = false;
+		}
+		out << std::endl << "]" << std::endl;
+	}
+
+	std::vector<TGStatsEntry>& threads() { return m_threads; }
+	std::vector<TGStatsEntry>& ranges() { return m_ranges; }
+
+private:
+	std::vector<TGStatsEntry> m_threads;
+	std::vector<TGStatsEntry> m_ranges;
+
+	TGStatsEntry& thread(int threadID)
+	{
+		while ((int) m_threads.size() <= threadID) {
+			m_threads.push_back(TGStatsEntry("thread" +
+					std::to_string(m_threads.size())));
+		}
+		return m_threads[threadID];
+	}
+
+	static double ns(double ps) { return ps / 1000; }
+
+	// Histograms count in time resolution units, convert to ps.
+	static double ps(uint64_t v)
+	{
+		return sc_get_time_resolution().to_seconds() * 1e12 * v;
+	}
+
+	void dumpCSV(std::ostream& out, TGStatsEntry& e)
+	{
+		// Account the current depth up to now.
+		e.setDepth(e.curDepth);
+		out << e.name << ",0x" << std::hex << e.start
+			<< ",0x" << e.end << std::dec << ","
+			<< e.reads << "," << e.writes << ","
+			<< e.bytesRead << "," << e.bytesWritten << ","
+			<< e.errors << "," << e.bandwidth() << ","
+			<< ns(ps(e.latency.min())) << ","
+			<< ns(ps(1) * e.latency.mean()) << ","
+			<< ns(ps(e.latency.percentile(50))) << ","
+			<< ns(ps(e.latency.percentile(99))) << ","
+			<< ns(ps(e.latency.max())) << ","
+			<< e.depth.mean() << "," << e.maxDepth << std::endl;
+	}
+
+	void dumpJSON(std::ostream& out, TGStatsEntry& e, bool firstEntry)
+	{
+		e.setDepth(e.curDepth);
+		if (!firstEntry) {
+			out << "," << std::endl;
+		}
+		out << "  { \"name\": \"" << e.name << "\", "
+			<< "\"start\": " << e.start << ", "
+			<< "\"end\": " << e.end << ", "
+			<< "\"reads\": " << e.reads << ", "
+			<< "\"writes\": " << e.writes << ", "
+			<< "\"bytes_read\": " << e.bytesRead << ", "
+			<< "\"bytes_written\": " << e.bytesWritten << ", "
+			<< "\"errors\": " << e.errors << ", "
+			<< "\"bandwidth_bytes_per_ns\": " << e.bandwidth() << ", "
+			<< "\"latency_ns\": { "
+			<< "\"min\": " << ns(ps(e.latency.min())) << ", "
+			<< "\"mean\": " << ns(ps(1) * e.latency.mean()) << ", "
+			<< "\"p50\": " << ns(ps(e.latency.percentile(50))) << ", "
+			<< "\"p99\": " << ns(ps(e.latency.percentile(99))) << ", "
+			<< "\"max\": " << ns(ps(e.latency.max())) << " }, "
+			<< "\"depth\": { "
+			<< "\"mean\": " << e.depth.mean() << ", "
+			<< "\"max\": " << e.maxDepth << " } }";
+	}
+};
+
+#endif /* TG_STATS_H_ */
@@ -24,7 +24,9 @@
 #define TG_TLM_H_
 
 #include <sstream>
+#include <fstream>
 #include <vector>
+#include <algorithm>
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
@@ -38,6 +40,7 @@ using namespace std;
 #include "tlm_utils/simple_target_socket.h"
 #include "data-transfer.h"
 #include "itraffic-desc.h"
+#include "tg-stats.h"
 
 SC_MODULE(TLMTrafficGenerator)
 {
@@ -48,7 +51,14 @@ SC_MODULE(TLMTrafficGenerator)
 	SC_HAS_PROCESS(TLMTrafficGenerator);
 	TLMTrafficGenerator(sc_core::sc_module_name name, int numThreads = 1) :
 		m_debug(false),
-		m_startDelay(SC_ZERO_TIME)
+		m_startDelay(SC_ZERO_TIME),
+		m_nonBlocking(false),
+		m_maxOutstanding(1),
+		m_issueRate(0),
+		m_byteRate(0),
+		m_reqInProgress(NULL),
+		m_stats(NULL),
+		m_statsJSON(false)
 	{
 		int i;
 
@@ -56,9 +66,17 @@ SC_MODULE(TLMTrafficGenerator)
 			m_tData.push_back(ThreadData(this, i));
 		}
 
+		socket.register_nb_transport_bw(this,
+				&TLMTrafficGenerator::nb_transport_bw);
+
 		SC_THREAD(run);
 	}
 
+	~TLMTrafficGenerator()
+	{
+		delete m_stats;
+	}
+
 	void enableDebug()
 	{
 		m_debug = true;
@@ -79,6 +97,67 @@ SC_MODULE(TLMTrafficGenerator)
 		m_startDelay = startDelay;
 	}
 
+	//
+	// Issue transactions with nb_transport and keep up to
+	// maxOutstanding of them in flight per thread.
+	//
+	void setNonBlocking(unsigned int maxOutstanding)
+	{
+		m_nonBlocking = true;
+		m_maxOutstanding = maxOutstanding ? maxOutstanding : 1;
+	}
+
+	//
+	// Limit how fast each thread issues transactions, in
+	// transactions per ns and bytes per ns. Zero means no limit.
+	//
+	void setIssueRate(double txnPerNs)
+	{
+		m_issueRate = txnPerNs;
+	}
+
+	void setByteRate(double bytesPerNs)
+	{
+		m_byteRate = bytesPerNs;
+	}
+
+	//
+	// Collect latency and bandwidth statistics per thread and for
+	// the address ranges added with getStats().addRange(). With a
+	// file name, the statistics are written to the file at the end
+	// of the simulation as CSV or JSON.
+	//
+	TGStats& enableStats(const std::string& file = "", bool json = false)
+	{
+		if (!m_stats) {
+			m_stats = new TGStats();
+		}
+		m_statsFile = file;
+		m_statsJSON = json;
+		return *m_stats;
+	}
+
+	TGStats& getStats() { return enableStats(m_statsFile, m_statsJSON); }
+
+	void dumpStats(std::ostream& out, bool json = false)
+	{
+		if (!m_stats) {
+			return;
+		}
+		if (json) {
+			m_stats->dumpJSON(out);
+		} else {
+			m_stats->dumpCSV(out);
+		}
+	}
+
+	//
+	// Transactions allocated by the pool so far and those back in it.
+	// Once all threads are done the two are equal.
+	//
+	unsigned int getTxnsAllocated() { return m_pool.allocated(); }
+	unsigned int getTxnsFree() { return m_pool.available(); }
+
 	template<typename T>
 	void addTransfers(T& transfers, int threadId = 0, DoneCallback c = NULL)
 	{
@@ -94,14 +173,18 @@ private:
 			m_gen(gen),
 			m_id(id),
 			m_callback(NULL),
-			m_transfers(NULL)
+			m_transfers(NULL),
+			m_outstanding(0),
+			m_nextIssue(SC_ZERO_TIME)
 		{}
 
 		ThreadData(ThreadData&& d) :
 			m_gen(d.m_gen),
 			m_id(d.m_id),
 			m_callback(NULL),
-			m_transfers(NULL)
+			m_transfers(NULL),
+			m_outstanding(0),
+			m_nextIssue(SC_ZERO_TIME)
 		{}
 
 		ITrafficDesc *GetTransfers()
@@ -149,12 +232,89 @@ private:
 
 		void SetTTG(TLMTrafficGenerator *gen) { m_gen = gen; }
 
+		unsigned int Outstanding() { return m_outstanding; }
+		void IncOutstanding() { m_outstanding++; }
+		void DecOutstanding()
+		{
+			m_outstanding--;
+			m_respDone.notify();
+		}
+		sc_event& RespDoneEvent() { return m_respDone; }
+
+		sc_time& NextIssue() { return m_nextIssue; }
+
 	private:
 		TLMTrafficGenerator *m_gen;
 		int m_id;
 		DoneCallback m_callback;
 		ITrafficDesc *m_transfers;
 		sc_event m_proceed;
+		unsigned int m_outstanding;
+		sc_event m_respDone;
+		sc_time m_nextIssue;
+	};
+
+	//
+	// Transactions and their buffers are recycled through TxnPool,
+	// which is also their memory manager. Buffers keep their size
+	// between uses so the pool stops allocating once warmed up.
+	//
+	class TLMTxn : public tlm::tlm_generic_payload {
+	public:
+		TLMTxn(tlm::tlm_mm_interface *mm) :
+			tlm::tlm_generic_payload(mm),
+			m_expect(NULL),
+			m_td(NULL)
+		{}
+
+		std::vector<uint8_t> m_data;
+		std::vector<uint8_t> m_be;
+		std::vector<uint8_t> m_expectBuf;
+		unsigned char *m_expect;
+		ThreadData *m_td;
+		sc_time m_issued;
+	};
+
+	class TxnPool : public tlm::tlm_mm_interface {
+	public:
+		TxnPool() :
+			m_allocated(0)
+		{}
+
+		~TxnPool()
+		{
+			for (auto t : m_free) {
+				delete t;
+			}
+		}
+
+		TLMTxn *get()
+		{
+			TLMTxn *t;
+
+			if (m_free.empty()) {
+				m_allocated++;
+				return new TLMTxn(this);
+			}
+
+			t = m_free.back();
+			m_free.pop_back();
+			return t;
+		}
+
+		// Called once the last reference to a transaction is released.
+		void free(tlm::tlm_generic_payload *gp)
+		{
+			gp->free_all_extensions();
+			m_free.push_back(static_cast<TLMTxn*>(gp));
+		}
+
+		unsigned int allocated() { return m_allocated; }
+		unsigned int available() { return m_free.size(); }
+
+	private:
+		std::vector<TLMTxn*> m_free;
+		unsigned int m_allocated;
 	};
 
 
@@ -175,7 +335,11 @@ private:
 			ITrafficDesc *transfers = td->GetTransfers();
 
 			if (transfers) {
-				generate(transfers);
+				if (m_nonBlocking) {
+					generate_nb(transfers, td);
+				} else {
+					generate(transfers, td);
+				}
 			}
 
 			td->RunCallback();
@@ -186,12 +350,114 @@ private:
 		}
 	}
 
-	void generate(ITrafficDesc *transfers)
+	// Wait until the thread is allowed to issue len bytes.
+	void throttle(ThreadData *td, uint32_t len)
+	{
+		sc_time& next = td->NextIssue();
+		double interval = 0;
+
+		if (m_issueRate == 0 && m_byteRate == 0) {
+			return;
+		}
+
+		if (next > sc_time_stamp()) {
+			wait(next - sc_time_stamp());
+		} else {
+			next = sc_time_stamp();
+		}
+
+		if (m_issueRate) {
+			interval = 1 / m_issueRate;
+		}
+		if (m_byteRate) {
+			interval = std::max(interval, len / m_byteRate);
+		}
+		next += sc_time(interval, SC_NS);
+	}
+
+	//
+	// Setup a transaction for the current transfer. With copy set,
+	// data, byte-enables and expected data are copied into the
+	// transaction since the traffic description may reuse its
+	// buffers before the transaction completes.
+	//
+	void setupTxn(TLMTxn *t, ITrafficDesc *transfers, bool copy)
+	{
+		uint32_t len;
+
+		t->set_command(transfers->getCmd());
+		t->set_address(transfers->getAddress());
+
+		len = transfers->getDataLength();
+		t->set_data_length(len);
+
+		if (t->is_write()) {
+			unsigned char *data = transfers->getData();
+
+			if (copy) {
+				t->m_data.assign(data, data + len);
+				data = t->m_data.data();
+			}
+			t->set_data_ptr(data);
+		} else {
+			t->m_data.resize(len);
+			t->set_data_ptr(t->m_data.data());
+		}
+
+		if (transfers->getByteEnable()) {
+			unsigned char *be = transfers->getByteEnable();
+			uint32_t be_len = transfers->getByteEnableLength();
+
+			if (copy) {
+				t->m_be.assign(be, be + be_len);
+				be = t->m_be.data();
+			}
+			t->set_byte_enable_ptr(be);
+			t->set_byte_enable_length(be_len);
+		} else {
+			t->set_byte_enable_ptr(nullptr);
+			t->set_byte_enable_length(0);
+		}
+
+		t->set_streaming_width(transfers->getStreamingWidth());
+
+		t->set_dmi_allowed(false);
+		t->set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+		transfers->setExtensions(t);
+
+		if (m_debug) {
+			debugWrite(t);
+		}
+	}
+
+	void checkTxn(TLMTxn *t)
+	{
+		if ( t->is_response_error() ) {
+			// Print response string
+			char txt[100];
+			sprintf(txt, "Error from b_transport, response status = %s",
+			t->get_response_string().c_str());
+			SC_REPORT_ERROR("TrafficGenerator", txt);
+		}
+
+		if (m_debug) {
+			debugRead(t, t->m_expect);
+		}
+
+		if (t->m_expect &&
+			memcmp(t->m_expect,
+				t->get_data_ptr(), t->get_data_length())) {
+			SC_REPORT_ERROR("TLMTrafficGenerator",
+					"Read data not same as expected!\n");
+		}
+	}
+
+	void generate(ITrafficDesc *transfers, ThreadData *td)
 	{
 		while (!transfers->done()) {
-			tlm::tlm_generic_payload trans;
+			TLMTxn *t = m_pool.get();
 			sc_time delay = sc_time(10, SC_NS);
-			uint8_t *data = NULL;
 
 			if (m_debug) {
 				cout << std::string(80, '-') << endl;
@@ -199,61 +465,165 @@ private:
 					<< endl << endl;
 			}
 
-			trans.set_command(transfers->getCmd());
-			trans.set_address(transfers->getAddress());
+			throttle(td, transfers->getDataLength());
 
-			trans.set_data_length(transfers->getDataLength());
+			t->acquire();
+			setupTxn(t, transfers, false);
+			statsIssue(t, td, sc_time_stamp() + delay);
 
-			if (trans.is_write()) {
-				trans.set_data_ptr(transfers->getData());
-			} else {
-				data = new uint8_t[transfers->getDataLength()];
-				trans.set_data_ptr(data);
-			}
-
-			if (transfers->getByteEnable()) {
-				trans.set_byte_enable_ptr(transfers->getByteEnable());
-				trans.set_byte_enable_length(transfers->getByteEnableLength());
-			} else {
-				trans.set_byte_enable_ptr(nullptr);
-				trans.set_byte_enable_length(0);
-			}
+			socket->b_transport(*t, delay);
 
-			trans.set_streaming_width(transfers->getStreamingWidth());
+			statsComplete(t, td, sc_time_stamp() + delay);
+			t->m_expect = transfers->getExpect();
+			checkTxn(t);
+			t->release();
 
-			trans.set_dmi_allowed(false);
-			trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+			transfers->next();
+		}
+	}
 
-			transfers->setExtensions(&trans);
+	//
+	// Non-blocking generation following the base protocol. The
+	// generator accepts responses right away (TLM_COMPLETED on
+	// BEGIN_RESP) so only the request phase needs to be tracked,
+	// one request at a time for all threads sharing the socket.
+	//
+	void generate_nb(ITrafficDesc *transfers, ThreadData *td)
+	{
+		while (!transfers->done()) {
+			tlm::tlm_phase phase = tlm::BEGIN_REQ;
+			sc_time delay = SC_ZERO_TIME;
+			tlm::tlm_sync_enum r;
+			unsigned char *expect;
+			TLMTxn *t;
+
+			while (td->Outstanding() >= m_maxOutstanding) {
+				wait(td->RespDoneEvent());
+			}
 
 			if (m_debug) {
-				debugWrite(&trans);
+				cout << std::string(80, '-') << endl;
+				cout << "[" << sc_time_stamp() << "]"
+					<< endl << endl;
 			}
 
-			socket->b_transport(trans, delay);
+			throttle(td, transfers->getDataLength());
 
-			if ( trans.is_response_error() ) {
-				// Print response string
-				char txt[100];
-				sprintf(txt, "Error from b_transport, response status = %s",
-				trans.get_response_string().c_str());
-				SC_REPORT_ERROR("TrafficGenerator", txt);
+			while (m_reqInProgress) {
+				wait(m_endReqEvent);
 			}
 
-			if (m_debug) {
-				debugRead(&trans, transfers->getExpect());
+			t = m_pool.get();
+			t->acquire();
+			t->m_td = td;
+			setupTxn(t, transfers, true);
+
+			expect = transfers->getExpect();
+			t->m_expect = NULL;
+			if (expect) {
+				t->m_expectBuf.assign(expect,
+						expect + t->get_data_length());
+				t->m_expect = t->m_expectBuf.data();
 			}
 
-			if (transfers->getExpect() &&
-				memcmp(transfers->getExpect(),
-					trans.get_data_ptr(), trans.get_data_length())) {
-				SC_REPORT_ERROR("TLMTrafficGenerator",
-						"Read data not same as expected!\n");
+			td->IncOutstanding();
+			m_reqInProgress = t;
+			statsIssue(t, td, sc_time_stamp());
+
+			r = socket->nb_transport_fw(*t, phase, delay);
+			if (r == tlm::TLM_UPDATED) {
+				if (phase == tlm::END_REQ) {
+					endReq(t);
+				} else if (phase == tlm::BEGIN_RESP) {
+					endReq(t);
+					completeTxn(t, true);
+				}
+			} else if (r == tlm::TLM_COMPLETED) {
+				endReq(t);
+				completeTxn(t, false);
 			}
 
-			delete[] data;
 			transfers->next();
 		}
+
+		// Wait for all responses before running the callback.
+		while (td->Outstanding()) {
+			wait(td->RespDoneEvent());
+		}
+	}
+
+	void statsIssue(TLMTxn *t, ThreadData *td, const sc_time& now)
+	{
+		if (m_stats) {
+			t->m_issued = now;
+			m_stats->issue(td->GetId(), *t, now);
+		}
+	}
+
+	void statsComplete(TLMTxn *t, ThreadData *td, const sc_time& now)
+	{
+		if (m_stats) {
+			m_stats->complete(td->GetId(), *t, t->m_issued, now);
+		}
+	}
+
+	void end_of_simulation()
+	{
+		if (m_stats && !m_statsFile.empty()) {
+			std::ofstream out(m_statsFile.c_str());
+
+			dumpStats(out, m_statsJSON);
+		}
+	}
+
+	void endReq(TLMTxn *t)
+	{
+		if (m_reqInProgress == t) {
+			m_reqInProgress = NULL;
+			m_endReqEvent.notify();
+		}
+	}
+
+	void completeTxn(TLMTxn *t, bool sendEndResp)
+	{
+		ThreadData *td = t->m_td;
+
+		statsComplete(t, td, sc_time_stamp());
+		checkTxn(t);
+
+		if (sendEndResp) {
+			tlm::tlm_phase phase = tlm::END_RESP;
+			sc_time delay = SC_ZERO_TIME;
+
+			socket->nb_transport_fw(*t, phase, delay);
+		}
+
+		td->DecOutstanding();
+		t->release();
+	}
+
+	tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload& trans,
+					tlm::tlm_phase& phase,
+					sc_time& delay)
+	{
+		TLMTxn *t = static_cast<TLMTxn*>(&trans);
+
+		if (phase == tlm::END_REQ) {
+			endReq(t);
+			return tlm::TLM_ACCEPTED;
+		}
+
+		if (phase == tlm::BEGIN_RESP) {
+			// BEGIN_RESP also ends the request phase.
+			endReq(t);
+			completeTxn(t, false);
+			phase = tlm::END_RESP;
+			return tlm::TLM_COMPLETED;
+		}
+
+		SC_REPORT_ERROR("TLMTrafficGenerator",
+				"Unexpected phase in nb_transport_bw");
+		return tlm::TLM_COMPLETED;
 	}
 
 	void debugWrite(tlm::tlm_generic_payload *trans)
@@ -322,6 +692,19 @@ private:
 	std::vector<ThreadData> m_tData;
 	bool m_debug;
 	sc_time m_startDelay;
+
+	bool m_nonBlocking;
+	unsigned int m_maxOutstanding;
+	double m_issueRate;
+	double m_byteRate;
+
+	TxnPool m_pool;
+	TLMTxn *m_reqInProgress;
+	sc_event m_endReqEvent;
+
+	TGStats *m_stats;
+	std::string m_statsFile;
+	bool m_statsJSON;
 };
 
 #endif /* TG_TLM_H_ */